@@ -10,5 +10,7 @@
 
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, iteration_time, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<int>, core_set_size, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, graphlab_async_applies, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, graphlab_mirror_flushes, 0);
 
 DEFINE_int32(max_iterations, 1024, "Stop after this many iterations, no matter what.");
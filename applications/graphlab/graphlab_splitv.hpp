@@ -15,6 +15,8 @@
 #include "graphlab_borrowed.hpp"
 
 GRAPPA_DECLARE_METRIC(SummarizingMetric<int>, core_set_size);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, graphlab_async_applies);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, graphlab_mirror_flushes);
 
 
 #define MAX_CORES 256
@@ -290,6 +292,7 @@ namespace Grappa {
         
         MPI_Datatype mpi_edge_type;
         MPI_Type_contiguous(2, MPI_INT64_T, &mpi_edge_type);
+        MPI_Type_commit(&mpi_edge_type);
         
         PHASE_END();
         
@@ -307,6 +310,7 @@ namespace Grappa {
                            MPI_COMM_WORLD, request)
           );
         });
+        MPI_Type_free(&mpi_edge_type);
         PHASE_END(); PHASE_BEGIN("  - copying");
         
         for (size_t i = 0; i < nrecv; i++) { edges.emplace_back(buf[i]); }
@@ -717,17 +721,35 @@ struct GraphlabEngine {
   ///
   /// Assuming: `gather_edges = EdgeDirection::In`
   ///
-  static void run_sync(GlobalAddress<G> g_in, bool delta_caching = true) {
-    
-    VLOG(1) << "GraphlabEngine::run_sync(active:" << Vertex::total_active << ")";
-
-    ///////////////
-    // initialize
+  /// Delta accumulated on a mirror by scatters in the current step. Kept
+  /// apart from the vertex program (whose `cache` is overwritten when the
+  /// master broadcasts), so scatter and apply can overlap (double-buffering).
+  struct NextDelta {
+    Gather delta;
+    bool queued;
+    NextDelta(): delta(), queued(false) {}
+  };
+  
+  static NextDelta* next_storage;
+  static NextDelta& next(Vertex& v) { return next_storage[&prog(v) - prog_storage]; }
+  
+  /// Local masters to apply in the next step (fused engine).
+  static std::vector<Vertex*> frontier;
+  /// Local mirrors with a queued delta (fused engine).
+  static std::vector<Vertex*> touched;
+  
+  static GlobalCompletionEvent async_gce;
+  
+  static void init(GlobalAddress<G> g_in) {
     on_all_cores([=]{
       g = g_in;
       
+      delete [] prog_storage;
+      delete [] next_storage;
+      
       auto n = g->l_verts.size() + g->l_master_verts.size();
       prog_storage = new VertexProg[n];
+      next_storage = new NextDelta[n];
       
       size_t i=0;
       auto init_prog = [&i](Vertex& v){
@@ -738,8 +760,104 @@ struct GraphlabEngine {
       
       for (auto& v : g->l_master_verts) init_prog(v);
       for (auto& v : g->l_verts)        init_prog(v);
+      
+      frontier.clear();
+      touched.clear();
+    });
+  }
+  
+  /// Full gather over in-edges of active vertices, leaving the total in
+  /// each active master's `cache`.
+  static void gather_in_edges() {
+    forall(g, [=](Edge& e){
+      auto& v = e.dest();
+      if (v.active) {
+        auto& p = prog(v);
+        p.post_delta( p.gather(v, e) );
+      }
     });
     
+    // send accumulated gather to master to compute total
+    forall(mirrors(g), [=](Vertex& v){
+      if (v.active) {
+        v.deactivate();
+        
+        auto& p = prog(v);
+        auto accum = p.cache;
+        call<async>(v.master, [=](Vertex& m){
+          prog(m).post_delta( accum );
+        });
+        p.reset();
+      }
+    });
+  }
+  
+  /// Scatter along a mirror's local out-edges, accumulating into the
+  /// targets' `next` buffers; `on_queued` is called the first time each
+  /// target receives a delta.
+  template< typename F >
+  static void scatter_into_next(Vertex& v, const VertexProg& p, F on_queued) {
+    for (Edge& e : util::iterate(v.l_out, v.l_nout)) {
+      auto& t = e.dest();
+      auto& n = next(t);
+      n.delta += p.scatter(e, t);
+      if (!n.queued) {
+        n.queued = true;
+        on_queued(t);
+      }
+    }
+  }
+  
+  /// Completion of work enrolled in C on core `origin`, to be called once.
+  template< GlobalCompletionEvent * C >
+  struct Done {
+    Core origin;
+    void operator()() const { C->send_completion(origin); }
+  };
+  
+  /// Like `delegate::call<async,C>`, but `f(v, done)` may hand `done` on to a
+  /// task it spawns, keeping this core's enrollment in C until that task
+  /// calls it. (A message handler can't enroll in C itself, as enrolling may
+  /// block.) `f` must call `done()` exactly once.
+  template< GlobalCompletionEvent * C, typename F >
+  static void call_held(GlobalAddress<Vertex> ga, F f) {
+    C->enroll();
+    Done<C> done{mycore()};
+    send_heap_message(ga.core(), [ga,f,done]{
+      f(*ga.pointer(), done);
+    });
+  }
+  
+  /// Send a mirror's queued delta to its master, activating it if `scatter`
+  /// activated the mirror; `on_activate(m, done)` runs in a message handler
+  /// on the master's core the first time it is activated (see call_held).
+  template< GlobalCompletionEvent * C, typename F >
+  static void flush_mirror(Vertex& v, F on_activate) {
+    auto& n = next(v);
+    n.queued = false;
+    auto delta = n.delta;
+    n.delta = Gather();
+    bool activate = v.active;
+    v.deactivate();
+    graphlab_mirror_flushes++;
+    call_held<C>(v.master, [=](Vertex& m, Done<C> done){
+      prog(m).post_delta(delta);
+      if (activate && m.activate()) {
+        on_activate(m, done);
+      } else {
+        done();
+      }
+    });
+  }
+  
+  static void run_sync(GlobalAddress<G> g_in, bool delta_caching = true) {
+    
+    VLOG(1) << "GraphlabEngine::run_sync(active:" << Vertex::total_active << ")";
+
+    ///////////////
+    // initialize
+    init(g_in);
+    
     int iteration = 0;
     while ( Vertex::total_active > 0 && iteration < FLAGS_max_iterations )
         GRAPPA_TIME_REGION(iteration_time) {
@@ -751,28 +869,7 @@ struct GraphlabEngine {
       // gather (TODO: do this in fewer 'forall's)
       
       if (!delta_caching || iteration == 0) {
-        // gather in_edges
-        forall(g, [=](Edge& e){
-          auto& v = e.dest();
-          if (v.active) {
-            auto& p = prog(v);
-            p.post_delta( p.gather(v, e) );
-          }
-        });
-        
-        // send accumulated gather to master to compute total
-        forall(mirrors(g), [=](Vertex& v){
-          if (v.active) {
-            v.deactivate();
-            
-            auto& p = prog(v);
-            auto accum = p.cache;
-            call<async>(v.master, [=](Vertex& m){
-              prog(m).post_delta( accum );
-            });
-            p.reset();
-          }
-        });
+        gather_in_edges();
       }
             
       ////////////////////////////////////////////////////////////
@@ -849,6 +946,160 @@ struct GraphlabEngine {
       VLOG(1) << "  time:   " << walltime()-t;
     } // while
   }
+  
+  ///
+  /// Fused synchronous engine (always delta-caching).
+  ///
+  /// After an initial gather, each superstep makes one pass over the edges:
+  /// masters on the frontier apply and broadcast to their mirrors, which
+  /// scatter straight away into their targets' `next` buffers. A second,
+  /// much smaller pass forwards just the mirrors that received a delta to
+  /// their masters, which forms the next frontier. Vertices whose value did
+  /// not change (`scatter_edges` false) activate nothing.
+  ///
+  static void run_fused(GlobalAddress<G> g_in) {
+    
+    VLOG(1) << "GraphlabEngine::run_fused(active:" << Vertex::total_active << ")";
+    
+    init(g_in);
+    gather_in_edges();
+    
+    forall(masters(g), [](Vertex& m){
+      if (m.active) frontier.push_back(&m);
+    });
+    
+    int iteration = 0;
+    while ( Vertex::total_active > 0 && iteration < FLAGS_max_iterations )
+        GRAPPA_TIME_REGION(iteration_time) {
+      VLOG(1) << "iteration " << iteration;
+      VLOG(1) << "  active: " << Vertex::total_active;
+      double t = walltime();
+      
+      ////////////////////////////////////////////////////////////
+      // apply + scatter
+      // (clear on every core first: other cores' broadcasts add to `touched`)
+      on_all_cores([]{ touched.clear(); });
+      finish([=]{
+        on_all_cores([=]{
+          forall_here<TaskMode::Bound,SyncMode::Async>(0, frontier.size(), [](int64_t i){
+            auto& m = *frontier[i];
+            m.deactivate();
+            
+            auto& p = prog(m);
+            p.apply(m, p.cache);
+            
+            auto do_scatter = p.scatter_edges(m);
+            auto p_copy = p;
+            auto data = m.data;
+            for (auto gv : m.master_info->mirror_verts) {
+              call_held<&impl::local_gce>(gv, [=](Vertex& v, Done<&impl::local_gce> done){
+                v.data = data;
+                prog(v) = p_copy;
+                prog(v).reset();
+                if (do_scatter && v.l_nout > 0) {
+                  auto vp = &v;
+                  spawn([vp,done]{
+                    scatter_into_next(*vp, prog(*vp), [](Vertex& t){
+                      touched.push_back(&t);
+                    });
+                    done();
+                  });
+                } else {
+                  done();
+                }
+              });
+            }
+          });
+        });
+      });
+      
+      ////////////////////////////////////////////////////////////
+      // forward deltas to masters, building the next frontier
+      on_all_cores([]{ frontier.clear(); });
+      finish([=]{
+        on_all_cores([=]{
+          forall_here<TaskMode::Bound,SyncMode::Async>(0, touched.size(), [](int64_t i){
+            flush_mirror<&impl::local_gce>(*touched[i], [](Vertex& m, Done<&impl::local_gce> done){
+              frontier.push_back(&m);
+              done();
+            });
+          });
+        });
+      });
+      
+      iteration++;
+      VLOG(1) << "  time:   " << walltime()-t;
+    } // while
+  }
+  
+  ///
+  /// Asynchronous (non-BSP) engine for delta-converging programs
+  /// (e.g. PageRank, SSSP) whose `apply` only depends on the accumulated
+  /// `cache`.
+  ///
+  /// Masters apply as soon as they are activated; the new program is sent to
+  /// mirrors which scatter into `next`, and each mirror flushes its queued
+  /// delta to the master from a separate task so deltas arriving in the
+  /// meantime are combined. Runs until no vertex is active anywhere
+  /// (`max_iterations` does not apply).
+  ///
+  static void run_async(GlobalAddress<G> g_in) {
+    
+    VLOG(1) << "GraphlabEngine::run_async(active:" << Vertex::total_active << ")";
+    
+    init(g_in);
+    gather_in_edges();
+    
+    GRAPPA_TIME_REGION(iteration_time) {
+      finish<&async_gce>([=]{
+        on_all_cores([=]{
+          forall_here<TaskMode::Bound,SyncMode::Async,&async_gce>
+          (0, g->l_master_verts.size(), [](int64_t i){
+            auto& m = g->l_master_verts[i];
+            if (m.active) async_apply(m);
+          });
+        });
+      });
+    }
+  }
+  
+  static void async_apply(Vertex& m) {
+    m.deactivate();
+    graphlab_async_applies++;
+    
+    auto& p = prog(m);
+    p.apply(m, p.cache);
+    
+    auto do_scatter = p.scatter_edges(m);
+    auto p_copy = p;
+    auto data = m.data;
+    for (auto gv : m.master_info->mirror_verts) {
+      call_held<&async_gce>(gv, [=](Vertex& v, Done<&async_gce> done){
+        v.data = data;
+        if (do_scatter && v.l_nout > 0) {
+          auto vp = &v;
+          // scatter with this copy: a later apply may overwrite prog(v) first
+          spawn([vp,p_copy,done]{
+            scatter_into_next(*vp, p_copy, [](Vertex& t){
+              auto tp = &t;
+              spawn<&async_gce>([tp]{
+                flush_mirror<&async_gce>(*tp, [](Vertex& m, Done<&async_gce> done){
+                  auto mp = &m;
+                  spawn([mp,done]{
+                    async_apply(*mp);
+                    done();
+                  });
+                });
+              });
+            });
+            done();
+          });
+        } else {
+          done();
+        }
+      });
+    }
+  }
 };
 
 template< typename G, typename VertexProg, class C >
@@ -856,3 +1107,15 @@ GlobalAddress<G> GraphlabEngine<G,VertexProg,C>::g;
 
 template< typename G, typename VertexProg, class C >
 VertexProg* GraphlabEngine<G,VertexProg,C>::prog_storage;
+
+template< typename G, typename VertexProg, class C >
+typename GraphlabEngine<G,VertexProg,C>::NextDelta* GraphlabEngine<G,VertexProg,C>::next_storage;
+
+template< typename G, typename VertexProg, class C >
+std::vector<typename G::Vertex*> GraphlabEngine<G,VertexProg,C>::frontier;
+
+template< typename G, typename VertexProg, class C >
+std::vector<typename G::Vertex*> GraphlabEngine<G,VertexProg,C>::touched;
+
+template< typename G, typename VertexProg, class C >
+GlobalCompletionEvent GraphlabEngine<G,VertexProg,C>::async_gce;
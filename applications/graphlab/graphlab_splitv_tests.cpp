@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include "graphlab.hpp"
+
+BOOST_AUTO_TEST_SUITE( graphlab_splitv_tests );
+
+using namespace Grappa;
+
+DEFINE_int32( scale, 10, "Log2 number of vertices" );
+DEFINE_int32( edgefactor, 16, "Average number of edges per vertex" );
+DEFINE_double( tolerance, 1.0E-10, "PageRank convergence tolerance" );
+
+const double RESET_PROB = 0.15;
+
+struct PagerankVertexData {
+  double rank;
+  PagerankVertexData(double rank = 1.0): rank(rank) {}
+};
+
+using G = GraphlabGraph<PagerankVertexData,Empty>;
+
+// same delta-caching PageRank as pagerank_new.cpp
+struct PagerankVertexProgram : public GraphlabVertexProgram<G,double> {
+  double delta;
+
+  PagerankVertexProgram() = default;
+  PagerankVertexProgram(const Vertex& v) {}
+
+  bool gather_edges(const Vertex& v) const { return true; }
+
+  Gather gather(const Vertex& v, Edge& e) const {
+    auto& src = e.source();
+    return src->rank / src.num_out_edges();
+  }
+  void apply(Vertex& v, const Gather& total) {
+    auto new_val = (1.0 - RESET_PROB) * total + RESET_PROB;
+    delta = (new_val - v->rank) / v.num_out_edges();
+    v->rank = new_val;
+  }
+  bool scatter_edges(const Vertex& v) const {
+    return std::fabs(delta * v.num_out_edges()) > FLAGS_tolerance;
+  }
+  Gather scatter(const Edge& e, Vertex& target) const {
+    target.activate();
+    return delta;
+  }
+};
+
+using Engine = GraphlabEngine<G,PagerankVertexProgram>;
+
+// ranks of this core's masters after run_sync, in l_master_verts order
+std::vector<double> sync_ranks;
+double rank_error;
+
+template< typename Run >
+void run_pagerank( GlobalAddress<G> g, Run run ) {
+  forall(g, [](G::Vertex& v){ v->rank = 1.0; });
+  activate_all(g);
+  run(g);
+}
+
+// largest difference of any master's rank from the run_sync result
+double max_rank_error( GlobalAddress<G> g ) {
+  call_on_all_cores([g]{
+    rank_error = 0;
+    for (size_t i = 0; i < g->l_master_verts.size(); i++) {
+      rank_error = std::max(rank_error, std::fabs(g->l_master_verts[i]->rank - sync_ranks[i]));
+    }
+  });
+  return reduce<double,collective_max>(&rank_error);
+}
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t ne = (1L << FLAGS_scale) * FLAGS_edgefactor;
+    auto tg = TupleGraph::Kronecker(FLAGS_scale, ne, 111, 222);
+    auto g = G::create(tg);
+
+    run_pagerank(g, [](GlobalAddress<G> g){ Engine::run_sync(g); });
+    on_all_cores([g]{
+      sync_ranks.clear();
+      for (auto& v : g->l_master_verts) sync_ranks.push_back(v->rank);
+    });
+    auto total = sum_all_cores([]{
+      return std::accumulate(sync_ranks.begin(), sync_ranks.end(), 0.0);
+    });
+    BOOST_MESSAGE("sync total rank: " << total);
+
+    // same supersteps as run_sync, so only summation order differs
+    run_pagerank(g, [](GlobalAddress<G> g){ Engine::run_fused(g); });
+    auto fused_err = max_rank_error(g);
+    BOOST_MESSAGE("fused max error: " << fused_err);
+    BOOST_CHECK_LT( fused_err, 1e-9 );
+
+    // applies many smaller deltas, more of which fall under the tolerance,
+    // so it only approaches the same ranks
+    run_pagerank(g, [](GlobalAddress<G> g){ Engine::run_async(g); });
+    auto async_err = max_rank_error(g);
+    BOOST_MESSAGE("async max error: " << async_err);
+    BOOST_CHECK_LT( async_err, 1e-3 );
+
+    tg.destroy();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
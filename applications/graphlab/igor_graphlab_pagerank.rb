@@ -16,7 +16,8 @@ Igor do
     format: 'bintsv4',
     max_iterations: 1024,
     trials: 3,
-    scale: 10
+    scale: 10,
+    vertex_order: 'original',
   })
   GFLAGS.delete :flat_combining
   
@@ -46,6 +47,7 @@ Igor do
   
   @cols << :aggregator_autoflush_ticks  
   @cols << :total_time_mean
+  @cols << :graph_core_adj_max
   @order = :total_time_mean
   
   # scaling
@@ -47,6 +47,7 @@ DEFINE_int32(trials, 3, "Number of timed trials to run and average over.");
 
 DEFINE_string(path, "", "Path to graph source file.");
 DEFINE_string(format, "bintsv4", "Format of graph source file.");
+DEFINE_string(vertex_order, "original", "Vertex numbering/partitioning: original, degree or balanced.");
 
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, init_time, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, tuple_time, 0);
@@ -115,7 +116,7 @@ int main(int argc, char* argv[]) {
     LOG(INFO) << "constructing graph";
     t = walltime();
     
-    auto g = G::create(tg, true);
+    auto g = G::create(tg, true, true, vertex_order_from_string(FLAGS_vertex_order));
     
     GRAPPA_TIME_REGION(init_time) {
       // TODO: random init
@@ -55,6 +55,8 @@ DEFINE_int32(trials, 3, "Number of timed trials to run and average over.");
 DEFINE_string(path, "", "Path to graph source file.");
 DEFINE_string(format, "bintsv4", "Format of graph source file.");
 
+DEFINE_string(engine, "sync", "GraphLab engine to run: 'sync', 'fused' or 'async'.");
+
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, init_time, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, tuple_time, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, construction_time, 0);
@@ -141,7 +143,13 @@ int main(int argc, char* argv[]) {
       
       GRAPPA_TIME_REGION(total_time) {
         activate_all(g);
-        GraphlabEngine<G,PagerankVertexProgram>::run_sync(g);
+        if (FLAGS_engine == "fused") {
+          GraphlabEngine<G,PagerankVertexProgram>::run_fused(g);
+        } else if (FLAGS_engine == "async") {
+          GraphlabEngine<G,PagerankVertexProgram>::run_async(g);
+        } else {
+          GraphlabEngine<G,PagerankVertexProgram>::run_sync(g);
+        }
       }
       
       if (i == 0) {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+
 namespace Aggregates {
   template < typename State, typename UV >
     State SUM(State sofar, UV nextval) {
@@ -10,4 +13,73 @@ namespace Aggregates {
     State COUNT(State sofar, UV nextval) {
       return sofar + 1;
     }
+
+  template < typename State, typename UV >
+    State MIN(State sofar, UV nextval) {
+      return nextval < sofar ? nextval : sofar;
+    }
+
+  template < typename State, typename UV >
+    State MAX(State sofar, UV nextval) {
+      return sofar < nextval ? nextval : sofar;
+    }
+
+  /// Aggregates usable with GroupBy. Each one has a trivially-copyable
+  /// partial `State` that starts from `init()`, folds in input values with
+  /// `update`, merges with another partial with `merge` (partials for a
+  /// key are built on many cores), and yields its final `value`.
+
+  template < typename T >
+    struct Sum {
+      typedef T State;
+      typedef T Value;
+      static State init() { return 0; }
+      template < typename UV >
+        static void update(State& s, const UV& v) { s = SUM(s, v); }
+      static void merge(State& s, const State& o) { s = SUM(s, o); }
+      static Value value(const State& s) { return s; }
+    };
+
+  struct Count {
+    typedef int64_t State;
+    typedef int64_t Value;
+    static State init() { return 0; }
+    template < typename UV >
+      static void update(State& s, const UV& v) { s = COUNT(s, v); }
+    static void merge(State& s, const State& o) { s = SUM(s, o); }
+    static Value value(const State& s) { return s; }
+  };
+
+  template < typename T >
+    struct Min {
+      typedef T State;
+      typedef T Value;
+      static State init() { return std::numeric_limits<T>::max(); }
+      template < typename UV >
+        static void update(State& s, const UV& v) { s = MIN(s, v); }
+      static void merge(State& s, const State& o) { s = MIN(s, o); }
+      static Value value(const State& s) { return s; }
+    };
+
+  template < typename T >
+    struct Max {
+      typedef T State;
+      typedef T Value;
+      static State init() { return std::numeric_limits<T>::lowest(); }
+      template < typename UV >
+        static void update(State& s, const UV& v) { s = MAX(s, v); }
+      static void merge(State& s, const State& o) { s = MAX(s, o); }
+      static Value value(const State& s) { return s; }
+    };
+
+  template < typename T >
+    struct Avg {
+      struct State { T sum; int64_t count; };
+      typedef double Value;
+      static State init() { return State{0, 0}; }
+      template < typename UV >
+        static void update(State& s, const UV& v) { s.sum = SUM(s.sum, v); s.count++; }
+      static void merge(State& s, const State& o) { s.sum += o.sum; s.count += o.count; }
+      static Value value(const State& s) { return s.count == 0 ? 0.0 : double(s.sum) / s.count; }
+    };
 }
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <Grappa.hpp>
+#include <ChunkSender.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/// Per-core open-addressed table from keys to values (e.g. partial
+/// aggregates), used to combine updates to the same key before they are
+/// shuffled to the key's owner. A growing table doubles at half load; a
+/// fixed one holds `capacity` keys and then reports `full()` so the
+/// caller can spill it with `shuffle()`.
+template < typename K, typename V >
+class CombiningTable {
+  struct Slot {
+    K key;
+    V val;
+    bool used;
+  };
+  std::vector<Slot> slots;
+  size_t used;
+  size_t limit;
+  bool grows;
+
+  static size_t hash( const K& key ) {
+    return std::hash<K>()(key) * 0x9E3779B97F4A7C15ULL >> 20;
+  }
+
+  void rehash( size_t n ) {
+    std::vector<Slot> old(n);
+    old.swap(slots);
+    for (auto& s : slots) s.used = false;
+    size_t mask = slots.size() - 1;
+    for (auto& o : old) {
+      if (!o.used) continue;
+      size_t i = hash(o.key) & mask;
+      while (slots[i].used) i = (i + 1) & mask;
+      slots[i] = o;
+    }
+  }
+
+  // slot holding `key`, claimed for it (and `fresh` set) if the key is new
+  Slot& lookup( const K& key, bool& fresh ) {
+    if (grows && 2 * (used + 1) > slots.size()) rehash(2 * slots.size());
+    size_t mask = slots.size() - 1;
+    size_t i = hash(key) & mask;
+    while (slots[i].used && !(slots[i].key == key)) i = (i + 1) & mask;
+    auto& s = slots[i];
+    fresh = !s.used;
+    if (fresh) {
+      s.key = key;
+      s.used = true;
+      used++;
+    }
+    return s;
+  }
+
+  public:
+    typedef std::pair<K,V> Entry;
+
+    explicit CombiningTable( size_t capacity = 1, bool grows = false )
+      : used(0), limit(std::max<size_t>(capacity, 1)), grows(grows) {
+      size_t n = 1;
+      while (n < 2 * limit) n *= 2;
+      slots.resize(n);
+      for (auto& s : slots) s.used = false;
+    }
+
+    size_t size() const { return used; }
+    bool full() const { return !grows && used >= limit; }
+
+    /// Value for `key`, set to `init` if the key is new.
+    V& find( const K& key, const V& init ) {
+      bool fresh;
+      auto& s = lookup(key, fresh);
+      if (fresh) s.val = init;
+      return s.val;
+    }
+
+    /// Add `val` under `key`, merging it into an existing value with
+    /// `combine(old, val)`; returns true if it was merged.
+    template < typename Combine >
+    bool insert( const K& key, const V& val, Combine combine ) {
+      bool fresh;
+      auto& s = lookup(key, fresh);
+      s.val = fresh ? val : combine(s.val, val);
+      return !fresh;
+    }
+
+    template < typename F >
+    void each( F f ) const {
+      for (auto& s : slots) if (s.used) f(s.key, s.val);
+    }
+
+    void clear() {
+      for (auto& s : slots) s.used = false;
+      used = 0;
+    }
+
+    /// Empty the table, sending each entry to core `owner(key)` in bulk
+    /// through `sender`. There each chunk of entries is handed to
+    /// `f(entries, n)`, in a message handler (the calling core's own
+    /// entries are passed directly). Returns the number of entries sent
+    /// to other cores; call `sender.wait()` before relying on delivery.
+    template < typename Owner, typename F >
+    size_t shuffle( Grappa::ChunkSender& sender, Owner owner, F f ) {
+      std::vector<std::vector<Entry>> parts(Grappa::cores());
+      each([&parts,owner](const K& key, const V& val) {
+        parts[owner(key)].push_back(Entry(key, val));
+      });
+      clear();
+
+      size_t sent = 0;
+      for (Grappa::Core c = 0; c < Grappa::cores(); c++) {
+        auto& part = parts[c];
+        if (part.empty()) continue;
+        if (c == Grappa::mycore()) {
+          f(part.data(), part.size());
+          continue;
+        }
+        sender.send(c, part.data(), part.size(), [f](const Entry * es, size_t n, size_t offset) {
+          f(es, n);
+        });
+        sent += part.size();
+      }
+      return sent;
+    }
+};
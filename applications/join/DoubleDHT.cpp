@@ -0,0 +1,5 @@
+#include "DoubleDHT.hpp"
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, double_dht_arena_bytes, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, double_dht_directory_bytes, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, double_dht_directory_grows, 0);
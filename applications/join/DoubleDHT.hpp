@@ -4,267 +4,272 @@
 #include <GlobalAllocator.hpp>
 #include <GlobalCompletionEvent.hpp>
 #include <ParallelLoop.hpp>
-#include <BufferVector.hpp>
 #include <Metrics.hpp>
 
-#include <list>
-#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
 
 //GRAPPA_DECLARE_METRIC(MaxMetric<uint64_t>, max_cell_length);
 GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, hash_tables_size);
 GRAPPA_DECLARE_METRIC(SummarizingMetric<uint64_t>, hash_tables_lookup_steps);
-
-// for naming the types scoped in DoubleDHT
-#define DDHT_TYPE(type) typename DoubleDHT<K,VL,VR,HF>::type
-#define _DDHT_TYPE(type) DoubleDHT<K,VL,VR,HF>::type
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, double_dht_arena_bytes);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, double_dht_directory_bytes);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, double_dht_directory_grows);
 
 enum class Direction { LEFT, RIGHT };
 
-// Hash table for joins
-// * allows multiple copies of a Key
-// * lookups return all Key matches
+// Bump allocator for one core's join tuples: space is carved out of large
+// blocks and only released all at once, so storing a tuple never mallocs.
+class JoinArena {
+  static const size_t block_bytes = 1 << 20;
+  std::vector<char*> blocks;
+  char * next;
+  size_t left;
+  size_t total;
+
+  public:
+    JoinArena() : next(nullptr), left(0), total(0) {}
+    ~JoinArena() { for (auto b : blocks) free(b); }
+    JoinArena(const JoinArena&) = delete;
+    JoinArena& operator=(const JoinArena&) = delete;
+
+    void * allocate( size_t bytes, size_t align ) {
+      size_t pad = (align - reinterpret_cast<uintptr_t>(next) % align) % align;
+      if (pad + bytes > left) {
+        size_t sz = std::max(block_bytes, bytes + align);
+        char * b;
+        CHECK_EQ(posix_memalign(reinterpret_cast<void**>(&b), 64, sz), 0);
+        blocks.push_back(b);
+        total += sz;
+        double_dht_arena_bytes += sz;
+        next = b;
+        left = sz;
+        pad = (align - reinterpret_cast<uintptr_t>(next) % align) % align;
+      }
+      void * p = next + pad;
+      next += pad + bytes;
+      left -= pad + bytes;
+      return p;
+    }
+
+    size_t bytes() const { return total; }
+};
+
+// Symmetric hash table for pipelined joins
+// * allows multiple copies of a Key on each side
+// * inserting a tuple on one side looks up all current matches on the other
+//
+// Each key is owned by one core. There, a key maps (through an
+// open-addressed directory) to two chains of tuple segments, one per side.
+// Segments live in a per-core bump arena and double in size along a
+// chain, so a probe scans a few contiguous runs of tuples.
 template <typename K, typename VL, typename VR, uint64_t (*HF)(K)> 
 class DoubleDHT {
 
   private:
     template <typename V>
-    struct Entry {
-      K key;
-      std::vector<V> * vs;
-      //BufferVector<V> * vs;
-      Entry( K key ) : key(key), vs(new std::vector<V>()) {}
-      //Entry( K key ) : key(key), vs(new BufferVector<V>( 16 )) {}
-      Entry ( ) {}
-    };
+    struct Segment {
+      Segment * next;
+      uint32_t n;
+      uint32_t cap;
 
-    struct PairCell {
-      std::list<Entry<VL>> * entriesLeft;
-      std::list<Entry<VR>> * entriesRight;
-
-      PairCell() : entriesLeft( NULL ), entriesRight( NULL ) {}
+      static size_t header() {
+        return (sizeof(Segment) + alignof(V) - 1) / alignof(V) * alignof(V);
+      }
+      V * vals() { return reinterpret_cast<V*>(reinterpret_cast<char*>(this) + header()); }
     };
 
     template <typename V>
-    struct lookup_result {
-      GlobalAddress<V> matches;
-      size_t num;
+    struct Side {
+      Segment<V> * head;
+      Segment<V> * tail;
+      uint64_t count;
     };
-    
-    // private members
-    GlobalAddress< PairCell > base;
-    size_t capacity;
 
-    uint64_t computeIndex( K key ) {
-      return HF(key) & (capacity - 1);
-    }
+    struct Slot {
+      K key;
+      bool used;
+      Side<VL> left;
+      Side<VR> right;
+    };
 
-    // for creating local DoubleDHT
-    DoubleDHT( GlobalAddress<PairCell> base, uint32_t capacity_pow2 ) {
-      this->base = base;
-      this->capacity = capacity_pow2;
-    }
+    static const uint32_t first_segment = 4;
+    static const uint32_t max_segment = 1024;
 
-    template <typename V>
-    static bool lookup_local_helper( K key, std::list<_DDHT_TYPE(Entry<V>)> * entries, Entry<V> * result ) {
-      // first check if the cell has any entries;
-      // if not then the lookup returns nothing
-      if ( entries == NULL ) return false;
-
-      uint64_t steps = 1;
-      for (auto i = entries->begin(); i!=entries->end(); ++i) {
-        const Entry<V> e = *i;
-        if ( e.key == key ) {  // typename K must implement operator==
-          *result = e;
-          hash_tables_lookup_steps += steps;
-          return true;
+    // one core's share of the table
+    struct Local {
+      std::vector<Slot> directory;
+      size_t used;
+      JoinArena arena;
+
+      explicit Local( size_t capacity_pow2 ) : used(0) {
+        resize( capacity_pow2 );
+      }
+
+      void resize( size_t capacity_pow2 ) {
+        std::vector<Slot> old( capacity_pow2 );
+        for (auto& s : old) s.used = false;
+        std::swap( old, directory );
+        double_dht_directory_bytes += (directory.size() - old.size()) * sizeof(Slot);
+        for (auto& s : old) {
+          if (s.used) *probe( s.key ) = s;
         }
-        ++steps;
       }
-      hash_tables_lookup_steps += steps;
-      return false;
-    }
 
-    static bool lookup_local_left( K key, PairCell * target, Entry<VL> * result) {
-      return lookup_local_helper(key, target->entriesLeft, result);
-    }
-    static bool lookup_local_right( K key, PairCell * target, Entry<VR> * result) {
-      return lookup_local_helper(key, target->entriesRight, result);
-    }
+      // slot holding `key`, or the empty slot where it belongs
+      Slot * probe( K key ) {
+        size_t mask = directory.size() - 1;
+        size_t i = (HF(key) * 0x9E3779B97F4A7C15ULL >> 20) & mask;
+        uint64_t steps = 1;
+        while (directory[i].used && !(directory[i].key == key)) {  // typename K must implement operator==
+          i = (i + 1) & mask;
+          ++steps;
+        }
+        hash_tables_lookup_steps += steps;
+        return &directory[i];
+      }
 
-    template <bool Unique, typename V>
-    static void insert_local_helper( K key, std::list<_DDHT_TYPE(Entry<V>)> * entries, V val) {
-      // find matching key in the list
-      for (auto i = entries->begin(); i!=entries->end(); ++i) {
-        Entry<V> e = *i;
-        if ( e.key == key ) {
-          // key found so add to matches
-          if (!Unique) {
-            e.vs->push_back( val );
-            hash_tables_size+=1;
-          }
-          return;
+      Slot * find_or_insert( K key ) {
+        if (2 * (used + 1) > directory.size()) {
+          resize( 2 * directory.size() );
+          double_dht_directory_grows++;
+        }
+        Slot * s = probe( key );
+        if (!s->used) {
+          s->key = key;
+          s->used = true;
+          s->left = Side<VL>{ nullptr, nullptr, 0 };
+          s->right = Side<VR>{ nullptr, nullptr, 0 };
+          used++;
         }
+        return s;
       }
 
-      // this is the first time the key has been seen
-      // so add it to the list
-      Entry<V> newe( key );
-      newe.vs->push_back( val );
-      entries->push_back( newe );
-      hash_tables_size+=1;
-    }
-   
-    template < bool Unique >
-    static void insert_local_left( K key, PairCell * target, VL val ) {
-      // if first time the cell is hit then initialize
-      if ( target->entriesLeft == NULL ) {
-        target->entriesLeft = new std::list<Entry<VL>>();
+      template <bool Unique, typename V>
+      void append( Side<V>& side, const V& val ) {
+        if (Unique && side.count > 0) return;
+
+        auto t = side.tail;
+        if (t == nullptr || t->n == t->cap) {
+          uint32_t cap = (t == nullptr) ? first_segment : std::min(2 * t->cap, max_segment);
+          auto seg = static_cast<Segment<V>*>(
+              arena.allocate( Segment<V>::header() + cap * sizeof(V),
+                              std::max(alignof(Segment<V>), alignof(V)) ));
+          seg->next = nullptr;
+          seg->n = 0;
+          seg->cap = cap;
+          if (t == nullptr) side.head = seg; else t->next = seg;
+          side.tail = t = seg;
+        }
+        new (t->vals() + t->n) V( val );
+        t->n++;
+        side.count++;
+        hash_tables_size+=1;
       }
+    };
 
-      insert_local_helper<Unique>( key, target->entriesLeft, val ); 
+    Local * local;
+
+    static Grappa::Core owner( K key ) {
+      return HF(key) % Grappa::cores();
     }
 
-    template < bool Unique >
-    static void insert_local_right( K key, PairCell * target, VR val ) {
-      // if first time the cell is hit then initialize
-      if ( target->entriesRight == NULL ) {
-        target->entriesRight = new std::list<Entry<VR>>();
+    // Call `f` on each tuple on `side` (a copy, taken right after the
+    // insert), in parallel tasks.
+    // Critical for correctness: only the first `side.count` tuples are
+    // visited, so tuples inserted later are not used.
+    template< Grappa::GlobalCompletionEvent * GCE, typename V, typename CF >
+    static void forall_matches( Side<V> side, CF f ) {
+      uint64_t remaining = side.count;
+      for (auto seg = side.head; remaining > 0; seg = seg->next) {
+        auto vals = seg->vals();
+        uint64_t n = std::min<uint64_t>(seg->n, remaining);
+        remaining -= n;
+        Grappa::forall_here<Grappa::async,GCE>(0, n, [f,vals](int64_t start, int64_t iters) {
+          for (int64_t i=start; i<start+iters; i++) {
+            // call the continuation with the lookup result
+            f(vals[i]);
+          }
+        });
       }
-
-      insert_local_helper<Unique>( key, target->entriesRight, val ); 
     }
-    
+
   public:
     // for static construction
-    DoubleDHT( ) {}
+    DoubleDHT( ) : local(nullptr) {}
 
+    // `capacity` is the initial number of keys the table is sized for
+    // (across all cores); directories grow as needed.
     static void init_global_DHT( DoubleDHT<K,VL,VR,HF> * globally_valid_local_pointer, size_t capacity ) {
+      size_t per_core = std::max<size_t>(16, capacity / Grappa::cores());
+      size_t capacity_pow2 = 1;
+      while (capacity_pow2 < 2 * per_core) capacity_pow2 *= 2;
 
-      uint32_t capacity_exp = log2(capacity);
-      size_t capacity_powerof2 = pow(2, capacity_exp);
-      GlobalAddress<PairCell> base = Grappa::global_alloc<PairCell>( capacity_powerof2 );
-
-      Grappa::on_all_cores( [globally_valid_local_pointer,base,capacity_powerof2] {
-        *globally_valid_local_pointer = DoubleDHT<K,VL,VR,HF>( base, capacity_powerof2 );
+      Grappa::on_all_cores( [globally_valid_local_pointer,capacity_pow2] {
+        delete globally_valid_local_pointer->local;
+        globally_valid_local_pointer->local = new Local( capacity_pow2 );
       });
+    }
 
-      Grappa::forall( base, capacity_powerof2, []( int64_t i, PairCell& c ) {
-        PairCell empty;
-        c = empty;
+    // Release every core's tuples and directory.
+    static void destroy_global_DHT( DoubleDHT<K,VL,VR,HF> * globally_valid_local_pointer ) {
+      Grappa::on_all_cores( [globally_valid_local_pointer] {
+        delete globally_valid_local_pointer->local;
+        globally_valid_local_pointer->local = nullptr;
       });
     }
 
     static void set_RO_global( DoubleDHT<K,VL,VR,HF> * globally_valid_local_pointer ) {
           //noop
-      //Grappa::forall( globally_valid_local_pointer->base, globally_valid_local_pointer->capacity, []( int64_t i, Cell& c ) {
-      //});
     }
 
-    /* ineset_lookup*():
-     *   Does an insert to hash table D and lookup in hash table ~D.
-     *   This insert-lookup is atomic. This means concurrent insert-lookups
-     *   will soundly compute the join of two datasets. Note that insert_lookup
-     *   is not idempotent because of the insert.
-     */
-
-/* Uncomment to duplicate left/right
-    template< Direction D, typename VLkp, typename VIns >
-    uint64_t insert_lookup ( K key, VIns val, GlobalAddress<VLkp> * resultsAddr ) {          
-      uint64_t index = computeIndex( key );
-      GlobalAddress< PairCell > target = base + index; 
-
-      // FIXME: remove 'this' capture when using gcc4.8, this is just a bug in 4.7
-      lookup_result<VLkp> result = Grappa::delegate::call( target.core(), [key,val,target,this]() {
-
-        // this is atomic { insert_local; lookup_local }
-        insert_local<D, VIns>( key, target.pointer(), val);
-
-        _DDHT_TYPE(lookup_result<VLkp>) lr;
-        lr.num = 0;
-
-        Entry<VLkp> e;
-        if (lookup_local<D, VLkp>( key, target.pointer(), &e)) {
-         // XXX: only valid for localeShared mem version.
-         // lr.matches = static_cast<GlobalAddress<V>>(e.vs->getReadBuffer());
-          lr.num = e.vs->size();
-        }
-
-        return lr;
-      });
+    // Bytes of arena and directory held on this core.
+    size_t local_bytes() const {
+      return local ? local->arena.bytes() + local->directory.size() * sizeof(Slot) : 0;
+    }
 
-      *resultsAddr = result.matches;
-      return result.num;
-    } 
-    */
+    /* insert_lookup_iter_*():
+     *   Inserts `val` on one side and calls `f` on every tuple with the
+     *   same key on the other side, in one task on the key's owner, so the
+     *   insert-lookup is atomic: concurrent insert-lookups from both sides
+     *   soundly compute the join of the two datasets (each matching pair
+     *   is produced exactly once). Not idempotent because of the insert.
+     */
 
     // Left and right version instead of with templates because of type checker preceeds dead code elim.
     // VL == VR, or might be different, so we can't check on them either.
     
-    // version of lookup that takes a continuation instead of returning results back
     template< typename CF, Grappa::GlobalCompletionEvent * GCE = &Grappa::impl::local_gce, bool Unique=false >
     void insert_lookup_iter_left ( K key, VL val, CF f ) {
-      uint64_t index = computeIndex( key );
-      GlobalAddress< PairCell > target = base + index; 
-
-      // FIXME: remove 'this' capture when using gcc4.8, this is just a bug in 4.7
-      //TODO optimization where only need to do remotePrivateTask instead of call_async
-      //if you are going to do more suspending ops (comms) inside the loop
-      Grappa::spawnRemote<GCE>( target.core(), [key, val, target, f, this]() {
-        
-        // this is atomic { insert_local; lookup_local }
-        insert_local_left<Unique>( key, target.pointer(), val );
-
-        Entry<VR> e;
-        if (lookup_local_right( key, target.pointer(), &e)) {
-          auto resultsptr = e.vs;
-          // Critical for correctness: uses the current size of the vector, so later inserts are not used
-          Grappa::forall_here<Grappa::async,GCE>(0, e.vs->size(), [f,resultsptr](int64_t start, int64_t iters) {
-            for  (int64_t i=start; i<start+iters; i++) {
-              auto results = *resultsptr;
-              // call the continuation with the lookup result
-              f(results[i]); 
-            }
-          });
-        }
+      auto self = this;
+      Grappa::spawnRemote<GCE>( owner(key), [key, val, f, self]() {
+        auto l = self->local;
+        auto s = l->find_or_insert( key );
+        l->template append<Unique>( s->left, val );
+        forall_matches<GCE>( s->right, f );
       });
     }
     // overload for only specifying GCE
   template<Grappa::GlobalCompletionEvent * GCE, typename CF, bool Unique=false>
   void insert_lookup_iter_left ( K key, VL val, CF f ) {
-    insert_lookup_iter_left<CF, GCE>( key, val, f );
+    insert_lookup_iter_left<CF, GCE, Unique>( key, val, f );
   }
 
   // overload for only specifying GCE and Unique
   template<Grappa::GlobalCompletionEvent * GCE, bool Unique, typename CF>
   void insert_lookup_iter_left ( K key, VL val, CF f ) {
-    insert_lookup_iter_left<CF, GCE>( key, val, f );
+    insert_lookup_iter_left<CF, GCE, Unique>( key, val, f );
   }
 
     template< typename CF, Grappa::GlobalCompletionEvent * GCE = &Grappa::impl::local_gce, bool Unique=false >
     void insert_lookup_iter_right ( K key, VR val, CF f ) {
-      uint64_t index = computeIndex( key );
-      GlobalAddress< PairCell > target = base + index; 
-
-      // FIXME: remove 'this' capture when using gcc4.8, this is just a bug in 4.7
-      //TODO optimization where only need to do remotePrivateTask instead of call_async
-      //if you are going to do more suspending ops (comms) inside the loop
-      Grappa::spawnRemote<GCE>( target.core(), [key, val, target, f, this]() {
-        
-        // this is atomic { insert_local; lookup_local }
-        insert_local_right<Unique>( key, target.pointer(), val );
-
-        Entry<VL> e;
-        if (lookup_local_left( key, target.pointer(), &e)) {
-          auto resultsptr = e.vs;
-          // Critical for correctness: uses the current size of the vector, so later inserts are not used
-          Grappa::forall_here<Grappa::async,GCE>(0, e.vs->size(), [f,resultsptr](int64_t start, int64_t iters) {
-            for  (int64_t i=start; i<start+iters; i++) {
-              auto results = *resultsptr;
-              // call the continuation with the lookup result
-              f(results[i]); 
-            }
-          });
-        }
+      auto self = this;
+      Grappa::spawnRemote<GCE>( owner(key), [key, val, f, self]() {
+        auto l = self->local;
+        auto s = l->find_or_insert( key );
+        l->template append<Unique>( s->right, val );
+        forall_matches<GCE>( s->left, f );
       });
     }
     // overload for only specifying GCE
@@ -278,27 +283,4 @@ class DoubleDHT {
     insert_lookup_iter_right<CF, GCE, Unique>( key, val, f );
   }
 
-    /* Uncomment to duplicate left right
-    // version of lookup that takes a continuation instead of returning results back
-    template< Direction D, typename VLkp, typename CF, typename VIns, GlobalCompletionEvent * GCE = &Grappa::impl::local_gce >
-    void insert_lookup ( K key, VIns val, CF f ) {
-      uint64_t index = computeIndex( key );
-      GlobalAddress< PairCell > target = base + index; 
-
-      Grappa::delegate::call<Grappa::async, GCE>( target.core(), [key, target, val, f]() {
-        // this is atomic { insert_local; lookup_local }
-        insert_local<D, VIns>( key, target.pointer(), val );
-
-        Entry<VLkp> e;
-        if (lookup_local<D, VLkp>( key, target.pointer(), &e)) {
-          uint64_t len = e.vs->size();
-          f(e.vs, len); 
-        }
-      });
-    }
-    */
-
-
 };
-
-
@@ -1,42 +1,24 @@
-/*
-Query A(yr) :- sp2bench_1m(journal, '<http://www.w3.org/1999/02/22-rdf-syntax-ns#type>', '<http://localhost/vocabulary/bench/Journal>'),
-                 sp2bench_1m(journal, '<http://purl.org/dc/elements/1.1/title>', '\"Journal 1 (1940)\"^^<http://www.w3.org/2001/XMLSchema#string>'),
-                 sp2bench_1m(journal, '<http://purl.org/dc/terms/issued>', yr)
-*/
-// grappa
+// Pipelined symmetric hash join of two synthetic relations through
+// DoubleDHT: both relations are scanned at once, each tuple inserted on its
+// side and joined with the matches already on the other. Checks the
+// number of results and reports throughput and table memory.
+
 #include <Grappa.hpp>
 #include <Collective.hpp>
 
 using namespace Grappa;
 
-// stl
 #include <vector>
-#include <unordered_map>
 
-// query library
-#include "relation_io.hpp"
+#include "relation.hpp"
 #include "DoubleDHT.hpp"
-#include "utils.h"
 #include "stats.h"
-#include "strings.h"
-
-// graph gen
-#include "generator/make_graph.h"
-#include "generator/utils.h"
-#include "grappa/timer.h"
-#include "grappa/common.h"
-#include "grappa/graph.hpp"
-#include "prng.h"
-
-template < typename T >                                                                                                
-struct Relation {
-    GlobalAddress<T> data;
-    size_t numtuples;
-};  
-
-DEFINE_uint64( nt, 30, "hack: number of tuples"); 
 
+DEFINE_uint64( nt, 30, "number of tuples in each relation"); 
+DEFINE_uint64( nkeys, 16, "number of distinct join keys");
 
+GRAPPA_DEFINE_METRIC(SimpleMetric<double>, double_dht_tuples_per_sec, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<double>, double_dht_bytes_per_tuple, 0);
 
 class MaterializedTupleRef_V2_0_1_2 {
     private:
@@ -120,6 +102,10 @@ class MaterializedTupleRef_V1_0_1_2 {
     return t.dump(o);
   }
 
+uint64_t std_hash( int64_t k ) {
+  return static_cast<uint64_t>(k);
+}
+
 typedef DoubleDHT<int64_t, MaterializedTupleRef_V1_0_1_2, MaterializedTupleRef_V2_0_1_2, std_hash> DHT;
 DHT hash0;
 
@@ -129,30 +115,55 @@ GlobalCompletionEvent loop2;
 Relation<MaterializedTupleRef_V1_0_1_2> V1;
 Relation<MaterializedTupleRef_V2_0_1_2> V2;
 
-void query() {
+uint64_t result_count = 0;
 
-  hash0.init_global_DHT( &hash0, cores()*16*1024 );
+// V1 has key i % nkeys and V2 (i + nkeys/2) % nkeys, so the number of
+// results is known in closed form.
+uint64_t expected_results() {
+  auto count = [](uint64_t k) { return FLAGS_nt / FLAGS_nkeys + (k < FLAGS_nt % FLAGS_nkeys ? 1 : 0); };
+  uint64_t total = 0;
+  for (uint64_t k = 0; k < FLAGS_nkeys; k++) {
+    total += count(k) * count((k + FLAGS_nkeys - FLAGS_nkeys/2) % FLAGS_nkeys);
+  }
+  return total;
+}
 
+template < typename T >
+Relation<T> make_relation( uint64_t key_offset ) {
+  Relation<T> r;
+  r.data = global_alloc<T>( FLAGS_nt );
+  r.numtuples = FLAGS_nt;
+  forall( r.data, r.numtuples, [key_offset](int64_t i, T& t) {
+    t.set(0, (i + key_offset) % FLAGS_nkeys);
+    t.set(1, i);
+    t.set(2, -i);
+  });
+  return r;
+}
+
+void query() {
+
+  hash0.init_global_DHT( &hash0, FLAGS_nkeys );
 
   {
-    V1.data = readTuples<MaterializedTupleRef_V1_0_1_2>( "test1", FLAGS_nt);
-    V1.numtuples = FLAGS_nt;
-    auto l_V1 = V1;
+    auto l_V1 = make_relation<MaterializedTupleRef_V1_0_1_2>( 0 );
     on_all_cores([=]{ V1 = l_V1; });
   }
 
   {
-    V2.data = readTuples<MaterializedTupleRef_V2_0_1_2>( "test2", FLAGS_nt);
-    V2.numtuples = FLAGS_nt;
-    auto l_V2 = V2;
+    auto l_V2 = make_relation<MaterializedTupleRef_V2_0_1_2>( FLAGS_nkeys/2 );
     on_all_cores([=]{ V2 = l_V2; });
   }
 
+  double start = Grappa::walltime();
+
   CompletionEvent ce1;
   spawn(&ce1, [=] {
     forall<&loop1>( V1.data, V1.numtuples, [=](int64_t i, MaterializedTupleRef_V1_0_1_2& t_000) {
       hash0.insert_lookup_iter_left<&loop1>(t_000.get(0), t_000, [=](MaterializedTupleRef_V2_0_1_2& t_001) {
-        LOG(INFO) << "V1(" << i <<") : (" << t_000 << ") -> " << t_001;
+        VLOG(2) << "V1(" << i <<") : (" << t_000 << ") -> " << t_001;
+        CHECK_EQ(t_000.get(0), t_001.get(0));
+        result_count++;
         });
       }); // end  scan over V1
   });
@@ -161,7 +172,9 @@ void query() {
   spawn(&ce2, [=] {
     forall<&loop2>( V2.data, V2.numtuples, [=](int64_t i, MaterializedTupleRef_V2_0_1_2& t_000) {
       hash0.insert_lookup_iter_right<&loop2>(t_000.get(0), t_000, [=](MaterializedTupleRef_V1_0_1_2& t_001) {
-        LOG(INFO) << "V2(" << i << ") : (" << t_000 << ") -> " << t_001;
+        VLOG(2) << "V2(" << i << ") : (" << t_000 << ") -> " << t_001;
+        CHECK_EQ(t_000.get(0), t_001.get(0));
+        result_count++;
         });
       }); // end  scan over V2
   });
@@ -169,6 +182,21 @@ void query() {
   ce1.wait();
   ce2.wait();
 
+  double end = Grappa::walltime();
+  query_runtime = end - start;
+  double_dht_tuples_per_sec = 2.0 * FLAGS_nt / (end - start);
+
+  auto results = reduce<uint64_t,collective_add>( &result_count );
+  CHECK_EQ( results, expected_results() );
+
+  auto bytes = sum_all_cores([]{ return static_cast<uint64_t>(hash0.local_bytes()); });
+  double_dht_bytes_per_tuple = static_cast<double>(bytes) / (2.0 * FLAGS_nt);
+  LOG(INFO) << results << " results; " << double_dht_tuples_per_sec.value() << " tuples/s; "
+            << double_dht_bytes_per_tuple.value() << " table bytes/tuple";
+
+  hash0.destroy_global_DHT( &hash0 );
+  global_free( V1.data );
+  global_free( V2.data );
 }
 
 
@@ -176,12 +204,8 @@ int main(int argc, char** argv) {
     init(&argc, &argv);
 
     run([] {
-
-double start = Grappa::walltime();
     	query();
-      double end = Grappa::walltime();
-      query_runtime = end - start;
-      //Metrics::merge_and_print();
+      Metrics::merge_and_print();
     });
 
     finalize();
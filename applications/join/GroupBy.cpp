@@ -0,0 +1,9 @@
+#include "GroupBy.hpp"
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, groupby_updates, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, groupby_local_flushes, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, groupby_shuffled_groups, 0);
+GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, groupby_runtime, 0);
+
+DEFINE_uint64(groupby_local_groups, 1 << 12, "Distinct keys each core pre-aggregates in a GroupBy before flushing to the owners");
+DEFINE_int64(groupby_max_inflight, 64, "Maximum number of GroupBy partial-aggregate chunks each core may have in flight");
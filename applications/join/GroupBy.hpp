@@ -0,0 +1,223 @@
+#pragma once
+
+#include <Grappa.hpp>
+#include <Collective.hpp>
+#include <Delegate.hpp>
+#include "Aggregates.hpp"
+#include "CombiningTable.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, groupby_updates);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, groupby_local_flushes);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, groupby_shuffled_groups);
+GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, groupby_runtime);
+
+DECLARE_uint64(groupby_local_groups);
+DECLARE_int64(groupby_max_inflight);
+
+namespace Aggregates {
+
+namespace impl {
+
+  template < size_t... I > struct indices {};
+  template < size_t N, size_t... I > struct build_indices : build_indices<N-1, N-1, I...> {};
+  template < size_t... I > struct build_indices<0, I...> { typedef indices<I...> type; };
+
+} // namespace impl
+
+/// Distributed group-by over keys `K`, computing one or more aggregates
+/// (see Sum, Count, Min, Max, Avg) per key.
+///
+/// Updates are first folded into a per-core CombiningTable of
+/// --groupby_local_groups keys (sized to stay in cache). When it fills, and
+/// in `complete()`, the partial states are shuffled in bulk messages to the
+/// core owning each key, which merges them into its final groups. After
+/// `complete()` the groups can be scanned with `forall_groups` or ranked
+/// with `top_k`.
+///
+/// GroupBy is a symmetric data structure:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// using G = GroupBy<int64_t, Count, Sum<double>>;
+/// // per source: out-degree and total weight
+/// auto g = group_by<int64_t, Count, Sum<double>>(edges, ne,
+///   [](G& g, Edge& e){ g.update(e.src, 1, e.weight); });
+/// auto heaviest = g->top_k_by<1>(10);
+/// g->destroy();
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+template < typename K, typename... Aggs >
+class GroupBy {
+  typedef typename impl::build_indices<sizeof...(Aggs)>::type Indices;
+
+  public:
+    typedef std::tuple<typename Aggs::State...> State;
+    typedef std::tuple<typename Aggs::Value...> Values;
+
+    /// A finished group: its key and the value of each aggregate.
+    struct Group {
+      K key;
+      Values values;
+    };
+
+    /// A partial aggregate: a key and its state.
+    typedef typename CombiningTable<K,State>::Entry Partial;
+
+    GlobalAddress<GroupBy> self;
+    CombiningTable<K,State> local;  // pre-aggregated updates made on this core
+    CombiningTable<K,State> owned;  // merged partials for keys this core owns
+    Grappa::ChunkSender sender;     // partials sent but not yet merged
+
+    GroupBy( GlobalAddress<GroupBy> self )
+      : self(self)
+      , local(FLAGS_groupby_local_groups, false)
+      , owned(FLAGS_groupby_local_groups, true)
+      , sender(FLAGS_groupby_max_inflight) {}
+
+    static GlobalAddress<GroupBy> create() {
+      auto g = Grappa::symmetric_global_alloc<GroupBy>();
+      Grappa::on_all_cores([g] { new (g.localize()) GroupBy(g); });
+      return g;
+    }
+
+    void destroy() {
+      auto self = this->self;
+      Grappa::on_all_cores([self] { self->~GroupBy(); });
+      Grappa::global_free(self);
+    }
+
+    static Grappa::Core owner_of( const K& key ) {
+      return std::hash<K>()(key) % Grappa::cores();
+    }
+
+    static State init() { return State(Aggs::init()...); }
+
+    /// Fold one input value per aggregate into `key`'s group (called on the
+    /// local proxy, e.g. `g->update(k, 1, w)` for <Count, Sum<double>>).
+    template < typename... In >
+    void update( const K& key, const In&... in ) {
+      static_assert(sizeof...(In) == sizeof...(Aggs), "GroupBy::update takes one input per aggregate");
+      groupby_updates++;
+      update_state(local.find(key, init()), Indices(), in...);
+      if (local.full()) flush();
+    }
+
+    /// Ship this core's pre-aggregated partials to their owners.
+    void flush() {
+      if (local.size() == 0) return;
+      groupby_local_flushes++;
+      auto self = this->self;
+      groupby_shuffled_groups += local.shuffle(sender, &owner_of, [self](const Partial * ps, size_t n) {
+        self->merge(ps, n);
+      });
+    }
+
+    /// Flush every core and wait for all partials to be merged by their
+    /// owners. Call once all updates are done.
+    void complete() {
+      auto self = this->self;
+      Grappa::on_all_cores([self] {
+        self->flush();
+        self->sender.wait();
+      });
+    }
+
+    /// Total number of groups (after `complete()`).
+    size_t size() {
+      auto self = this->self;
+      return Grappa::sum_all_cores([self] { return self->owned.size(); });
+    }
+
+    /// Call `f(group)` on each group, on the core that owns it.
+    template < typename F >
+    void forall_groups( F f ) {
+      auto self = this->self;
+      Grappa::on_all_cores([self,f] {
+        self->owned.each([f](const K& key, const State& s) {
+          f(Group{key, values_of(s, Indices())});
+        });
+      });
+    }
+
+    /// The first `k` groups in the order given by `before(a, b)`, gathered
+    /// on the calling core. Each core ranks its own groups first, so only
+    /// k groups per core are sent.
+    template < typename Before >
+    std::vector<Group> top_k( size_t k, Before before ) {
+      auto self = this->self;
+      std::vector<Group> top;
+      auto out = &top;
+      auto origin = Grappa::mycore();
+      Grappa::finish([=] {
+        Grappa::on_all_cores([=] {
+          std::vector<Group> mine;
+          mine.reserve(self->owned.size());
+          self->owned.each([&mine](const K& key, const State& s) {
+            mine.push_back(Group{key, values_of(s, Indices())});
+          });
+          size_t n = std::min(k, mine.size());
+          std::partial_sort(mine.begin(), mine.begin() + n, mine.end(), before);
+          for (size_t i = 0; i < n; i++) {
+            auto g = mine[i];
+            Grappa::delegate::call<Grappa::SyncMode::Async>(origin, [out,g] { out->push_back(g); });
+          }
+        });
+      });
+      size_t n = std::min(k, top.size());
+      std::partial_sort(top.begin(), top.begin() + n, top.end(), before);
+      top.resize(n);
+      return top;
+    }
+
+    /// The `k` groups with the largest value of aggregate `I` (ties broken
+    /// by smaller key).
+    template < size_t I >
+    std::vector<Group> top_k_by( size_t k ) {
+      return top_k(k, [](const Group& a, const Group& b) {
+        auto& va = std::get<I>(a.values);
+        auto& vb = std::get<I>(b.values);
+        return (vb < va) || (!(va < vb) && a.key < b.key);
+      });
+    }
+
+  private:
+    void merge( const Partial * ps, size_t n ) {
+      for (size_t i = 0; i < n; i++) {
+        merge_state(owned.find(ps[i].first, init()), ps[i].second, Indices());
+      }
+    }
+
+    template < size_t... I, typename... In >
+    static void update_state( State& s, impl::indices<I...>, const In&... in ) {
+      int expand[] = { 0, (Aggs::update(std::get<I>(s), in), 0)... };
+      (void)expand;
+    }
+
+    template < size_t... I >
+    static void merge_state( State& s, const State& o, impl::indices<I...> ) {
+      int expand[] = { 0, (Aggs::merge(std::get<I>(s), std::get<I>(o)), 0)... };
+      (void)expand;
+    }
+
+    template < size_t... I >
+    static Values values_of( const State& s, impl::indices<I...> ) {
+      return Values(Aggs::value(std::get<I>(s))...);
+    }
+} GRAPPA_BLOCK_ALIGNED;
+
+/// Group the `n` elements at `base` with `f(g, element)`, which calls
+/// `g.update(key, inputs...)`; returns the completed GroupBy.
+template < typename K, typename... Aggs, typename T, typename F >
+GlobalAddress<GroupBy<K,Aggs...>> group_by( GlobalAddress<T> base, size_t n, F f ) {
+  auto start = Grappa::walltime();
+  auto g = GroupBy<K,Aggs...>::create();
+  Grappa::forall(base, n, [g,f](T& t) { f(*g.localize(), t); });
+  g->complete();
+  groupby_runtime += Grappa::walltime() - start;
+  return g;
+}
+
+} // namespace Aggregates
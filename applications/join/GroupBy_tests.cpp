@@ -0,0 +1,65 @@
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include "GroupBy.hpp"
+
+using namespace Grappa;
+using namespace Aggregates;
+
+BOOST_AUTO_TEST_SUITE( GroupBy_tests );
+
+DEFINE_int64( groupby_items, 100000, "Number of items to group" );
+DEFINE_int64( groupby_keys, 1000, "Number of distinct keys" );
+
+// item i has key i % keys and value i
+typedef GroupBy<int64_t, Count, Sum<int64_t>, Min<int64_t>, Max<int64_t>, Avg<int64_t>> G;
+
+void check_groups( GlobalAddress<G> g ) {
+  int64_t n = FLAGS_groupby_items, nk = FLAGS_groupby_keys;
+  BOOST_CHECK_EQUAL( g->size(), nk );
+
+  g->forall_groups([n,nk](const G::Group& gr) {
+    int64_t k = gr.key;
+    int64_t count = (n - k + nk - 1) / nk;
+    int64_t max = k + (count - 1) * nk;
+    CHECK_EQ( std::get<0>(gr.values), count );
+    CHECK_EQ( std::get<1>(gr.values), count * (k + max) / 2 );
+    CHECK_EQ( std::get<2>(gr.values), k );
+    CHECK_EQ( std::get<3>(gr.values), max );
+    CHECK_EQ( std::get<4>(gr.values), (k + max) / 2.0 );
+  });
+
+  // largest sums belong to the largest keys
+  auto top = g->top_k_by<1>(5);
+  BOOST_CHECK_EQUAL( top.size(), 5 );
+  for (size_t i = 0; i < top.size(); i++) {
+    BOOST_CHECK_EQUAL( top[i].key, nk - 1 - i );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t n = FLAGS_groupby_items, nk = FLAGS_groupby_keys;
+    auto items = global_alloc<int64_t>(n);
+    forall(items, n, [](int64_t i, int64_t& x){ x = i; });
+
+    auto grouper = [nk](G& g, int64_t& x){ g.update(x % nk, 1, x, x, x, x); };
+
+    // default (cache-sized) local tables
+    auto g = group_by<int64_t, Count, Sum<int64_t>, Min<int64_t>, Max<int64_t>, Avg<int64_t>>(items, n, grouper);
+    check_groups(g);
+    g->destroy();
+
+    // tiny local tables, flushing constantly
+    on_all_cores([]{ FLAGS_groupby_local_groups = 4; });
+    g = group_by<int64_t, Count, Sum<int64_t>, Min<int64_t>, Max<int64_t>, Avg<int64_t>>(items, n, grouper);
+    check_groups(g);
+    g->destroy();
+
+    global_free(items);
+    Metrics::merge_and_print();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
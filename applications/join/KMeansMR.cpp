@@ -23,6 +23,7 @@ DEFINE_uint64(numred, CORES_NUM_REDUCERS, "Number of reducers; default = 0 (indi
 DEFINE_uint64(maxiters, NO_MAX_ITERS, "Number of max iterations; default = 0 (indicates no maximum)");
 DEFINE_bool(combiner, true, "Use local combiner after mapper. This makes communication O(K*SIZE) instead of O(Input*SIZE)");
 DEFINE_uint64(centers_compared, COMPARE_ALL, "How many centers to check");
+DEFINE_bool(flat, false, "Use the flat MapReduce engine (map-side combining tables, bulk shuffle) instead of per-pair delegates");
 
 
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, iterations_runtime, 0);
@@ -233,6 +234,41 @@ void KMeansReduce( MapReduce::Reducer<clusterid_t,Vector<Size>,Cluster<Size>>& c
   emit( ctx, res );
 }
 
+// flat engine: combine points into (sum, count) per cluster on the map side
+template <int Size>
+struct PointSum {
+  Vector<Size> sum;
+  int64_t count;
+};
+
+template <int Size>
+PointSum<Size> add_points( const PointSum<Size>& a, const PointSum<Size>& b ) {
+  PointSum<Size> r = a;
+  r.sum += b.sum;
+  r.count += b.count;
+  return r;
+}
+
+typedef MapReduce::FlatJob<clusterid_t,PointSum<SIZE>,Cluster<SIZE>,&add_points<SIZE>> KMeansFlatJob;
+
+void KMeansMapF( KMeansFlatJob& job, Vector<SIZE>& p ) {
+  PointSum<SIZE> s = { p, 1 };
+  job.emitIntermediate( find_cluster( p ), s );
+}
+
+void KMeansReduceF( KMeansFlatJob& job, clusterid_t id, const PointSum<SIZE> * sums, size_t n ) {
+  auto total = sums[0];
+  for (size_t i=1; i<n; i++) total = add_points( total, sums[i] );
+
+  Vector<SIZE> center = total.sum;
+  center /= total.count;
+  Cluster<SIZE> res = { center, id };
+
+  VLOG(2) << "cluster " << res << " contains " << total.count << " points";
+
+  job.emit( res );
+}
+
 SimpleSymmetric<Vector<SIZE>> normal_reducer;
 
 void kmeans() {
@@ -330,7 +366,11 @@ void kmeans() {
 
   GlobalAddress<MapReduce::Reducer<clusterid_t,Vector<SIZE>,Cluster<SIZE>>> reducers;
   GlobalAddress<MapReduce::Combiner<clusterid_t,Vector<SIZE>>> combiners;
+  GlobalAddress<KMeansFlatJob> flat_job;
   reducers = MapReduce::allocateReducers<clusterid_t,Vector<SIZE>,Cluster<SIZE>>( numred );
+  if (FLAGS_flat) {
+    flat_job = KMeansFlatJob::create();
+  }
   if (FLAGS_combiner) {
     combiners = MapReduce::allocateCombiners<clusterid_t,Vector<SIZE>>();
   }
@@ -343,7 +383,9 @@ void kmeans() {
 
     
     GlobalAddress<MapReduce::Reducer<clusterid_t,Vector<SIZE>,Cluster<SIZE>>> iter_result;
-    if (FLAGS_combiner) {
+    if (FLAGS_flat) {
+      flat_job->execute(points, numpoints, &KMeansMapF, &KMeansReduceF);
+    } else if (FLAGS_combiner) {
       MapReduce::CombiningMapReduceJobExecute<Vector<SIZE>,clusterid_t,Vector<SIZE>,Cluster<SIZE>>(points, numpoints, reducers, combiners, numred, &KMeansMapC<SIZE>, &KMeansCombine<SIZE>, &KMeansReduce<SIZE>);
       iter_result = reducers;
     } else {
@@ -356,21 +398,35 @@ void kmeans() {
     auto start_bc = walltime();
     // send means to all nodes using
     // poor man's all-to-all
-    forall(iter_result, numred, [=](int64_t i, MapReduce::Reducer<clusterid_t,Vector<SIZE>,Cluster<SIZE>>& r) {
-        VLOG(2) << "looking at reducer " << i;
-        for (Cluster<SIZE> clust : *(r.result)) {
-          VLOG(2) << "broadcasting " << clust;
-          for (int c=0; c<Grappa::cores(); c++) {
-            delegate::call<async>(c, [=] {
-              VLOG(2) << "saving to means[" << clust.id << "]";
-              means->means[clust.id] = clust.center;
-            });
+    if (FLAGS_flat) {
+      finish([=] {
+        on_all_cores([=] {
+          for (Cluster<SIZE> clust : flat_job->result) {
+            for (int c=0; c<Grappa::cores(); c++) {
+              delegate::call<async>(c, [=] {
+                means->means[clust.id] = clust.center;
+              });
+            }
           }
-        }
-         // call_on_all_cores([=] {
-         // });
-        //r.result->clear();
-    });
+        });
+      });
+    } else {
+      forall(iter_result, numred, [=](int64_t i, MapReduce::Reducer<clusterid_t,Vector<SIZE>,Cluster<SIZE>>& r) {
+          VLOG(2) << "looking at reducer " << i;
+          for (Cluster<SIZE> clust : *(r.result)) {
+            VLOG(2) << "broadcasting " << clust;
+            for (int c=0; c<Grappa::cores(); c++) {
+              delegate::call<async>(c, [=] {
+                VLOG(2) << "saving to means[" << clust.id << "]";
+                means->means[clust.id] = clust.center;
+              });
+            }
+          }
+           // call_on_all_cores([=] {
+           // });
+          //r.result->clear();
+      });
+    }
     auto stop_bc = walltime();
     kmeans_broadcast_time += stop_bc - start_bc;
 
@@ -388,6 +444,7 @@ void kmeans() {
     LOG(INFO) << "iteration " << iter << ": dist=" << tempDist << " time=" << this_iter_runtime;
   }
   kmeans_runtime = walltime() - start;
+  if (FLAGS_flat) flat_job->destroy();
 }
 
 int main(int argc, char** argv) {
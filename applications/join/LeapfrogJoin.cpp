@@ -0,0 +1,21 @@
+#include "LeapfrogJoin.hpp"
+
+TrieRelation::TrieRelation(std::vector<Edge>& edges) {
+  std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+    return a.src < b.src || (a.src == b.src && a.dst < b.dst);
+  });
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  children.reserve(edges.size());
+  for (auto& e : edges) {
+    if (keys.empty() || keys.back() != e.src) {
+      keys.push_back(e.src);
+      offsets.push_back(children.size());
+    }
+    children.push_back(e.dst);
+  }
+  offsets.push_back(children.size());
+
+  DVLOG(4) << "trie: " << keys.size() << " keys, " << children.size() << " tuples";
+  std::vector<Edge>().swap(edges);
+}
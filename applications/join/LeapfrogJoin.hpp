@@ -0,0 +1,162 @@
+#pragma once
+
+#include "local_graph.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <glog/logging.h>
+
+/// A binary relation stored as a two-level trie: sorted distinct first
+/// attributes, each with a sorted run of distinct second attributes.
+class TrieRelation {
+  public:
+    std::vector<int64_t> keys;      // distinct first attributes
+    std::vector<int64_t> offsets;   // children of keys[i] are children[offsets[i]..offsets[i+1])
+    std::vector<int64_t> children;  // second attributes, grouped by first
+
+    /// Sorts and de-duplicates `edges` (consumed) as (src, dst) pairs.
+    TrieRelation(std::vector<Edge>& edges);
+
+    size_t size() const { return children.size(); }
+};
+
+/// Linear iterator over one TrieRelation, in the sense of leapfrog
+/// triejoin: `open` descends to the children of the current key, `up`
+/// returns to the parent, and `seek` moves forward to the first key >= k.
+class TrieIterator {
+  const TrieRelation * rel;
+  int depth;                  // -1 at the root, then 0 or 1
+  const int64_t * arr[2];
+  size_t pos[2];
+  size_t end[2];
+
+  public:
+    TrieIterator(const TrieRelation& rel) : rel(&rel), depth(-1) {}
+
+    int64_t key() const { return arr[depth][pos[depth]]; }
+    bool atEnd() const { return pos[depth] == end[depth]; }
+    void next() { pos[depth]++; }
+
+    // galloping search, so long skips cost O(log distance)
+    void seek(int64_t k) {
+      auto a = arr[depth];
+      size_t lo = pos[depth], hi = end[depth];
+      if (lo == hi || a[lo] >= k) return;
+      size_t step = 1;
+      while (lo + step < hi && a[lo + step] < k) {
+        lo += step;
+        step *= 2;
+      }
+      pos[depth] = std::lower_bound(a + lo + 1, a + std::min(lo + step, hi), k) - a;
+    }
+
+    void open() {
+      depth++;
+      CHECK_LT(depth, 2) << "binary relations have two levels";
+      if (depth == 0) {
+        arr[0] = rel->keys.data();
+        pos[0] = 0;
+        end[0] = rel->keys.size();
+      } else {
+        arr[1] = rel->children.data();
+        pos[1] = rel->offsets[pos[0]];
+        end[1] = rel->offsets[pos[0] + 1];
+      }
+    }
+
+    void up() { depth--; }
+};
+
+/// Intersection of several TrieIterators at their current level, visiting
+/// the common keys in increasing order.
+class LeapfrogJoin {
+  std::vector<TrieIterator*>& iters;
+  size_t p;
+  bool done;
+
+  void search() {
+    size_t k = iters.size();
+    int64_t xmax = iters[(p + k - 1) % k]->key();
+    while (true) {
+      auto it = iters[p];
+      if (it->key() == xmax) return;
+      it->seek(xmax);
+      if (it->atEnd()) { done = true; return; }
+      xmax = it->key();
+      p = (p + 1) % k;
+    }
+  }
+
+  public:
+    LeapfrogJoin(std::vector<TrieIterator*>& iters) : iters(iters), p(0), done(false) {
+      for (auto it : iters) if (it->atEnd()) { done = true; return; }
+      std::sort(iters.begin(), iters.end(), [](TrieIterator* a, TrieIterator* b) {
+        return a->key() < b->key();
+      });
+      search();
+    }
+
+    bool atEnd() const { return done; }
+    int64_t key() const { return iters[p]->key(); }
+
+    void next() {
+      iters[p]->next();
+      if (iters[p]->atEnd()) { done = true; return; }
+      p = (p + 1) % iters.size();
+      search();
+    }
+};
+
+/// Worst-case-optimal join of binary atoms over variables 0..nvars-1,
+/// binding variables in that order (leapfrog triejoin). Each atom's
+/// relation must be sorted with its earlier variable first.
+///
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// // triangles: R(x,y), S(y,z), T(x,z)
+/// TrieJoin j(3);
+/// j.add(R, 0, 1); j.add(S, 1, 2); j.add(T, 0, 2);
+/// j.run([](const int64_t * xyz) { ... });
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class TrieJoin {
+  int nvars;
+  std::vector<TrieIterator> iters;
+  std::vector<std::vector<size_t>> atoms_at;   // iterators taking part at each variable
+
+  template < typename F >
+  void descend(int d, std::vector<std::vector<TrieIterator*>>& at, int64_t * binding, F& emit) {
+    auto& its = at[d];
+    for (auto it : its) it->open();
+    for (LeapfrogJoin lf(its); !lf.atEnd(); lf.next()) {
+      binding[d] = lf.key();
+      if (d + 1 == nvars) emit(static_cast<const int64_t*>(binding));
+      else descend(d + 1, at, binding, emit);
+    }
+    for (auto it : its) it->up();
+  }
+
+  public:
+    TrieJoin(int nvars) : nvars(nvars), atoms_at(nvars) {}
+
+    /// Add atom `rel(a, b)`; requires a < b.
+    void add(const TrieRelation& rel, int a, int b) {
+      CHECK_LT(a, b) << "atom variables must follow the join order";
+      CHECK_LT(b, nvars);
+      atoms_at[a].push_back(iters.size());
+      atoms_at[b].push_back(iters.size());
+      iters.push_back(TrieIterator(rel));
+    }
+
+    /// Call `emit(binding)` on each result; binding[i] is variable i.
+    template < typename F >
+    void run(F emit) {
+      std::vector<std::vector<TrieIterator*>> at(nvars);
+      for (int d = 0; d < nvars; d++) {
+        CHECK(!atoms_at[d].empty()) << "variable " << d << " appears in no atom";
+        for (auto i : atoms_at[d]) at[d].push_back(&iters[i]);
+      }
+      std::vector<int64_t> binding(nvars);
+      descend(0, at, binding.data(), emit);
+    }
+};
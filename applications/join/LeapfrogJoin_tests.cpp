@@ -0,0 +1,92 @@
+#include <boost/test/unit_test.hpp>
+#include "LeapfrogJoin.hpp"
+
+#include <random>
+#include <set>
+
+BOOST_AUTO_TEST_SUITE( LeapfrogJoin_tests );
+
+// random undirected graph, as the set of (lo, hi) pairs
+std::set<std::pair<int64_t,int64_t>> random_graph(int64_t nv, int64_t ne) {
+  std::mt19937_64 rng(12345);
+  std::set<std::pair<int64_t,int64_t>> es;
+  while (es.size() < ne) {
+    int64_t u = rng() % nv, v = rng() % nv;
+    if (u != v) es.insert(std::make_pair(std::min(u,v), std::max(u,v)));
+  }
+  return es;
+}
+
+std::vector<Edge> oriented(const std::set<std::pair<int64_t,int64_t>>& es) {
+  std::vector<Edge> r;
+  for (auto& e : es) r.push_back(Edge(e.first, e.second));
+  return r;
+}
+
+BOOST_AUTO_TEST_CASE( testTrie ) {
+  std::vector<Edge> edges { {3,1}, {1,5}, {3,1}, {1,2}, {7,0}, {1,9} };
+  TrieRelation t(edges);
+  BOOST_CHECK( t.keys == (std::vector<int64_t>{1, 3, 7}) );
+  BOOST_CHECK( t.offsets == (std::vector<int64_t>{0, 3, 4, 5}) );
+  BOOST_CHECK( t.children == (std::vector<int64_t>{2, 5, 9, 1, 0}) );
+
+  TrieIterator it(t);
+  it.open();
+  it.seek(2);
+  BOOST_CHECK_EQUAL( it.key(), 3 );
+  it.seek(8);
+  BOOST_CHECK( it.atEnd() );
+}
+
+BOOST_AUTO_TEST_CASE( testTriangles ) {
+  int64_t nv = 200;
+  auto es = random_graph(nv, 3000);
+
+  int64_t expected = 0;
+  for (auto& xy : es) {
+    for (int64_t z = xy.second + 1; z < nv; z++) {
+      if (es.count(std::make_pair(xy.second, z)) && es.count(std::make_pair(xy.first, z))) expected++;
+    }
+  }
+
+  auto r = oriented(es), s = oriented(es), t = oriented(es);
+  TrieRelation R(r), S(s), T(t);
+  TrieJoin j(3);
+  j.add(R, 0, 1);
+  j.add(S, 1, 2);
+  j.add(T, 0, 2);
+  int64_t count = 0;
+  j.run([&count](const int64_t * xyz) {
+    CHECK( xyz[0] < xyz[1] && xyz[1] < xyz[2] );
+    count++;
+  });
+  BOOST_MESSAGE( "triangles: " << count );
+  BOOST_CHECK( expected > 0 );
+  BOOST_CHECK_EQUAL( count, expected );
+}
+
+BOOST_AUTO_TEST_CASE( testSquares ) {
+  int64_t nv = 60;
+  auto es = random_graph(nv, 400);
+  auto has = [&es](int64_t u, int64_t v) { return es.count(std::make_pair(std::min(u,v), std::max(u,v))) > 0; };
+
+  // 4-cycles x-y-z-w-x with x < y < z < w
+  int64_t expected = 0;
+  for (int64_t x = 0; x < nv; x++) for (int64_t y = x+1; y < nv; y++) if (has(x,y))
+  for (int64_t z = y+1; z < nv; z++) if (has(y,z))
+  for (int64_t w = z+1; w < nv; w++) if (has(z,w) && has(x,w)) expected++;
+
+  auto r = oriented(es), s = oriented(es), t = oriented(es), u = oriented(es);
+  TrieRelation R(r), S(s), T(t), U(u);
+  TrieJoin j(4);
+  j.add(R, 0, 1);
+  j.add(S, 1, 2);
+  j.add(T, 2, 3);
+  j.add(U, 0, 3);
+  int64_t count = 0;
+  j.run([&count](const int64_t * b) { count++; });
+  BOOST_MESSAGE( "squares: " << count );
+  BOOST_CHECK_EQUAL( count, expected );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
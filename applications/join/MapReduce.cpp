@@ -8,3 +8,9 @@ GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, mr_mapping_runtime, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, mr_combining_runtime, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, mr_reducing_runtime, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, mr_reallocation_runtime, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, mr_combined_emits, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, mr_spills, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, mr_shuffled_pairs, 0);
+
+DEFINE_uint64(mr_combine_slots, 1 << 16, "Distinct keys each core's FlatJob combining table holds before spilling to the reducers");
+DEFINE_int64(mr_max_inflight, 64, "Maximum number of FlatJob shuffle chunks each core may have in flight");
@@ -4,9 +4,12 @@
 #include <GlobalCompletionEvent.hpp>
 #include <Addressing.hpp>
 #include <Collective.hpp>
+#include "CombiningTable.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <cstdint>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -15,6 +18,12 @@ GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, mr_mapping_runtime);
 GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, mr_combining_runtime);
 GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, mr_reducing_runtime);
 GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, mr_reallocation_runtime);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, mr_combined_emits);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, mr_spills);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, mr_shuffled_pairs);
+
+DECLARE_uint64(mr_combine_slots);
+DECLARE_int64(mr_max_inflight);
 
 namespace MapReduce {
 
@@ -301,6 +310,130 @@ GlobalAddress<Reducer<K,V,OutType>> MapReduceJobExecute(GlobalAddress<RA> keyval
 }
 
 
+
+/// MapReduce job with map-side combining and a bulk shuffle.
+///
+/// Mappers (`mf(job, item)`, calling `job.emitIntermediate(key, val)`)
+/// combine into a per-core CombiningTable of --mr_combine_slots keys.
+/// When it fills (and once mapping is done) the table is spilled: its
+/// entries are partitioned by reducer core and sent in bulk messages.
+/// Each core then sorts what it received by key and calls the reducer
+/// (`rf(job, key, vals, n)`, calling `job.emit(out)`) once per key, with
+/// that key's values in one contiguous run. There is one reducer per core.
+///
+/// FlatJob is a symmetric data structure:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// int64_t add(const int64_t& a, const int64_t& b) { return a + b; }
+/// using J = FlatJob<int64_t,int64_t,WordCount,add>;
+/// auto job = J::create();
+/// job->execute(words, n,
+///   [](J& j, int64_t& w){ j.emitIntermediate(w, 1); },
+///   [](J& j, int64_t w, const int64_t * counts, size_t n){
+///     int64_t sum = 0;
+///     for (size_t i=0; i<n; i++) sum += counts[i];
+///     j.emit(WordCount(w, sum));
+///   });
+/// // results are in job->result on each core
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+template <typename K, typename V, typename OutType, V (*Combine)(const V&, const V&)>
+class FlatJob {
+  public:
+    typedef std::pair<K,V> Pair;
+
+    GlobalAddress<FlatJob> self;
+    CombiningTable<K,V> table;      // map-side combining
+    std::vector<Pair> received;     // shuffled pairs for this core's reducer
+    std::vector<OutType> result;    // this core's reducer output
+    Grappa::ChunkSender sender;     // chunks sent but not yet received
+
+    FlatJob( GlobalAddress<FlatJob> self )
+      : self(self)
+      , table(FLAGS_mr_combine_slots)
+      , sender(FLAGS_mr_max_inflight) {}
+
+    static GlobalAddress<FlatJob> create() {
+      auto job = Grappa::symmetric_global_alloc<FlatJob>();
+      Grappa::on_all_cores([job] { new (job.localize()) FlatJob(job); });
+      return job;
+    }
+
+    void destroy() {
+      auto self = this->self;
+      Grappa::on_all_cores([self] { self->~FlatJob(); });
+      Grappa::global_free(self);
+    }
+
+    static Grappa::Core reducer_of( const K& key ) {
+      return std::hash<K>()(key) % Grappa::cores();
+    }
+
+    // called within user map (on the local proxy)
+    void emitIntermediate( K key, V val ) {
+      if (table.insert(key, val, Combine)) mr_combined_emits++;
+      if (table.full()) spill();
+    }
+
+    // called within user reduce
+    void emit( OutType out ) {
+      result.push_back(out);
+    }
+
+    // Send the combined pairs to their reducers, in bulk.
+    void spill() {
+      if (table.size() == 0) return;
+      mr_spills++;
+      mr_shuffled_pairs += table.size();
+      auto self = this->self;
+      table.shuffle(sender, &reducer_of, [self](const Pair * ps, size_t n) {
+        auto& r = self->received;
+        r.insert(r.end(), ps, ps + n);
+      });
+    }
+
+    template < typename T, typename MapF, typename ReduceF, Grappa::GlobalCompletionEvent * GCE=&default_mr_gce >
+    void execute( GlobalAddress<T> keyvals, size_t num, MapF mf, ReduceF rf ) {
+      auto self = this->self;
+      Grappa::on_all_cores([self] {
+        self->received.clear();
+        self->result.clear();
+      });
+
+      auto start_map = Grappa::walltime();
+      VLOG(1) << "map";
+      Grappa::forall<GCE>(keyvals, num, [self,mf]( T& kv ) {
+        mf(*self.localize(), kv);
+      });
+      auto stop_map = Grappa::walltime();
+      mr_mapping_runtime += stop_map - start_map;
+
+      VLOG(1) << "combine/send";
+      Grappa::on_all_cores([self] {
+        self->spill();
+        self->sender.wait();
+      });
+      auto stop_combine = Grappa::walltime();
+      mr_combining_runtime += stop_combine - stop_map;
+
+      VLOG(1) << "reduce";
+      Grappa::on_all_cores([self,rf] {
+        auto& job = *self.localize();
+        auto& r = job.received;
+        std::sort(r.begin(), r.end(), [](const Pair& a, const Pair& b) { return a.first < b.first; });
+        std::vector<V> vals(r.size());
+        for (size_t i = 0; i < r.size(); i++) vals[i] = r[i].second;
+        for (size_t i = 0; i < r.size(); ) {
+          size_t j = i + 1;
+          while (j < r.size() && r[j].first == r[i].first) j++;
+          rf(job, r[i].first, &vals[i], j - i);
+          i = j;
+        }
+        std::vector<Pair>().swap(r);
+      });
+      mr_reducing_runtime += Grappa::walltime() - stop_combine;
+      VLOG(1) << "complete";
+    }
+} GRAPPA_BLOCK_ALIGNED;
+
 } // end namespace
 
         /// TODO: join: quite annoying might as well do parallel(map/map) reduce because otherwise need to marshal data from two tables into an forall() iterator anyway 
@@ -3,6 +3,8 @@
 
 using namespace MapReduce;
 
+DEFINE_uint64( flat_words, 1000, "Number of words for the flat engine word count" );
+
 //////////////////////////////////////
 // Word Count
 /////////////////////////////////////
@@ -42,6 +44,22 @@ void NumCountReduce( Reducer<int64_t,int64_t,WordCount>& ctx, int64_t word, std:
     VLOG(1) << "reducer key " << word << " processed " << i << " values";
 }
 
+int64_t add_counts( const int64_t& a, const int64_t& b ) {
+  return a + b;
+}
+
+typedef FlatJob<int64_t,int64_t,WordCount,add_counts> FlatWordCount;
+
+void NumCountMapF( FlatWordCount& job, int64_t& word ) {
+  job.emitIntermediate( word, 1 );
+}
+
+void NumCountReduceF( FlatWordCount& job, int64_t word, const int64_t * counts, size_t n ) {
+  int64_t sum = 0;
+  for (size_t i=0; i<n; i++) sum += counts[i];
+  job.emit( WordCount(word, sum) );
+}
+
 void NumCountCombiner( const CombiningMapperContext<int64_t,int64_t,WordCount>& ctx, int64_t word, std::vector<int64_t> counts ) {
   int64_t sum = 0; 
   for ( auto local_it = counts.begin(); local_it!= counts.end(); ++local_it ) {
@@ -160,6 +178,44 @@ void test_map_on_symmetric_randomAccess() {
     CHECK( total == numw );
 }
 
+void test_flat_word_count() {
+  LOG(INFO) << "test_flat_word_count";
+  size_t numw = FLAGS_flat_words;
+  size_t dictionary_size = 33;
+  GlobalAddress<int64_t> words = Grappa::global_alloc<int64_t>(numw);
+  Grappa::forall(words, numw, [=](int64_t i, int64_t& w) {
+    w = (i*541) % dictionary_size;
+  });
+
+  // baseline: one delegate per emitted pair
+  auto reds = allocateReducers<int64_t,int64_t,WordCount>( Grappa::cores() );
+  auto start = Grappa::walltime();
+  MapReduceJobExecute<int64_t, int64_t, int64_t, WordCount, decltype(NumCountMap), decltype(NumCountReduce)>(words, numw, reds, Grappa::cores(), &NumCountMap, &NumCountReduce);
+  auto delegate_time = Grappa::walltime() - start;
+
+  auto job = FlatWordCount::create();
+  for (auto slots : { size_t(4), size_t(1) << 16 }) {
+    // a tiny table forces many spills
+    Grappa::on_all_cores([job,slots] { job->table = CombiningTable<int64_t,int64_t>(slots); });
+    start = Grappa::walltime();
+    job->execute(words, numw, &NumCountMapF, &NumCountReduceF);
+    auto flat_time = Grappa::walltime() - start;
+    LOG(INFO) << "word count of " << numw << " words: " << delegate_time << " s with delegates, "
+              << flat_time << " s flat (" << slots << " slots)";
+
+    auto keys = Grappa::sum_all_cores([job] { return static_cast<int64_t>(job->result.size()); });
+    CHECK_EQ( keys, std::min(numw, dictionary_size) );
+    Grappa::on_all_cores([=] {
+      for (auto& wc : job->result) {
+        CHECK_EQ( FlatWordCount::reducer_of(wc.word), Grappa::mycore() );
+        int64_t expected = 0;
+        for (size_t i=0; i<numw; i++) if ((i*541) % dictionary_size == wc.word) expected++;
+        CHECK_EQ( wc.count, expected );
+      }
+    });
+  }
+  job->destroy();
+}
 
 int main(int argc, char** argv) {
   Grappa::init(&argc, &argv);
@@ -167,6 +223,7 @@ int main(int argc, char** argv) {
     test_map_on_array();
     test_map_on_symmetric_randomAccess();
     test_map_on_array_combining();
+    test_flat_word_count();
   });
   Grappa::finalize();
 }
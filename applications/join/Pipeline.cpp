@@ -0,0 +1,9 @@
+#include "Pipeline.hpp"
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, pipeline_batches, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, pipeline_tuples_scanned, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, pipeline_shuffle_chunks, 0);
+GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, pipeline_stage_runtime, 0);
+
+DEFINE_int64(pipeline_batch_size, 2048, "Tuples per batch pushed between Pipeline operators");
+DEFINE_int64(pipeline_max_inflight, 64, "Maximum number of Pipeline shuffle chunks each operator may have in flight");
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <Grappa.hpp>
+#include <Collective.hpp>
+#include <ChunkSender.hpp>
+#include <ConditionVariableLocal.hpp>
+#include "GroupBy.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, pipeline_batches);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, pipeline_tuples_scanned);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, pipeline_shuffle_chunks);
+GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, pipeline_stage_runtime);
+
+DECLARE_int64(pipeline_batch_size);
+DECLARE_int64(pipeline_max_inflight);
+
+/// Push-based query operators that pass batches of tuples to each other.
+///
+/// A Plan is built identically on every core from a builder function that
+/// wires operators together (sources at the top, sinks at the bottom).
+/// Each stage scans the local part of a global array in batches of
+/// --pipeline_batch_size tuples and pushes them down the pipeline; only
+/// Shuffle operators cross cores, in bulk chunks. Operators never keep
+/// partial batches across calls (except Shuffle's per-core buffers), so a
+/// batch may be pushed by several tasks at once.
+///
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// // SELECT r.a, s.c FROM R r, S s WHERE r.b = s.b AND r.a > 10
+/// auto plan = Plan::create([](Plan& p) {
+///   auto out  = sink<Out>(p, [](const Out * t, size_t n) { ... });
+///   auto ht   = hash_build<RT>(p, [](const RT& r) { return r.b; });
+///   p.source(0, shuffle(p, [](const RT& r) { return r.b; }, ht));
+///   auto join = hash_probe<ST>(p, ht, [](const ST& s) { return s.b; },
+///                 [](const ST& s, const RT& r) { return Out{r.a, s.c}; }, out);
+///   p.source(1, shuffle(p, [](const ST& s) { return s.b; }, join));
+/// });
+/// plan->scan(0, R, nr);   // build
+/// plan->scan(1, S, ns);   // probe
+/// plan->destroy();
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+namespace Pipeline {
+
+/// Base of all operators; `finish` signals the end of this core's input.
+class Operator {
+  public:
+    virtual ~Operator() {}
+    virtual void finish() = 0;
+};
+
+/// An operator that accepts batches of T.
+template < typename T >
+class Consumer : public Operator {
+  public:
+    virtual void consume( const T * tuples, size_t n ) = 0;
+};
+
+/// Per-core set of operators making up a query, as a symmetric object.
+class Plan {
+  public:
+    GlobalAddress<Plan> self;
+    std::vector<std::unique_ptr<Operator>> ops;  // owned operators
+    std::vector<Operator*> shuffles;             // by id, the same on every core
+    std::vector<Operator*> sources;              // stage heads
+
+    Plan( GlobalAddress<Plan> self ) : self(self) {}
+
+    template < typename Op >
+    Op * add( Op * op ) {
+      ops.emplace_back(op);
+      return op;
+    }
+
+    /// Make `head` the entry point of stage `i`.
+    void source( size_t i, Operator * head ) {
+      if (sources.size() <= i) sources.resize(i + 1, nullptr);
+      sources[i] = head;
+    }
+
+    /// Build the plan on every core with `build(plan)`.
+    template < typename B >
+    static GlobalAddress<Plan> create( B build ) {
+      auto p = Grappa::symmetric_global_alloc<Plan>();
+      Grappa::on_all_cores([p,build] {
+        build(*new (p.localize()) Plan(p));
+      });
+      return p;
+    }
+
+    void destroy() {
+      auto self = this->self;
+      Grappa::on_all_cores([self] { self->~Plan(); });
+      Grappa::global_free(self);
+    }
+
+    /// Run stage `i`: each core pushes its local part of `base[0,n)`
+    /// through the stage in batches, then finishes it.
+    template < typename T >
+    void scan( size_t i, GlobalAddress<T> base, size_t n ) {
+      auto self = this->self;
+      auto start = Grappa::walltime();
+      Grappa::on_all_cores([self,i,base,n] {
+        CHECK( i < self->sources.size() && self->sources[i] ) << "no source for stage " << i;
+        auto head = static_cast<Consumer<T>*>(self->sources[i]);
+        T * lo = base.localize();
+        T * hi = (base+n).localize();
+        for (T * b = lo; b < hi; b += FLAGS_pipeline_batch_size) {
+          size_t m = std::min<size_t>(FLAGS_pipeline_batch_size, hi - b);
+          pipeline_batches++;
+          pipeline_tuples_scanned += m;
+          head->consume(b, m);
+        }
+        head->finish();
+      });
+      pipeline_stage_runtime += Grappa::walltime() - start;
+    }
+} GRAPPA_BLOCK_ALIGNED;
+
+/// Keeps tuples satisfying `pred`.
+template < typename T, typename Pred >
+class Select : public Consumer<T> {
+  Consumer<T> * next;
+  Pred pred;
+
+  public:
+    Select( Consumer<T> * next, Pred pred ) : next(next), pred(pred) {}
+
+    void consume( const T * in, size_t n ) {
+      std::vector<T> out;
+      out.reserve(n);
+      for (size_t i = 0; i < n; i++) if (pred(in[i])) out.push_back(in[i]);
+      if (!out.empty()) next->consume(out.data(), out.size());
+    }
+
+    void finish() { next->finish(); }
+};
+
+/// Maps each tuple through `f`.
+template < typename In, typename Out, typename F >
+class Project : public Consumer<In> {
+  Consumer<Out> * next;
+  F f;
+
+  public:
+    Project( Consumer<Out> * next, F f ) : next(next), f(f) {}
+
+    void consume( const In * in, size_t n ) {
+      std::vector<Out> out(n);
+      for (size_t i = 0; i < n; i++) out[i] = f(in[i]);
+      next->consume(out.data(), n);
+    }
+
+    void finish() { next->finish(); }
+};
+
+/// Build side of a hash join: collects this core's tuples, and on finish
+/// groups them by key so a probe sees each key's matches contiguously.
+template < typename K, typename T, typename KeyF >
+class HashJoinBuild : public Consumer<T> {
+  KeyF key;
+  std::vector<T> rows;
+  std::unordered_map<K, std::pair<size_t,size_t>> index;  // key -> [begin, end) of rows
+
+  public:
+    typedef K Key;
+    typedef T Row;
+
+    HashJoinBuild( KeyF key ) : key(key) {}
+
+    void consume( const T * in, size_t n ) {
+      rows.insert(rows.end(), in, in + n);
+    }
+
+    void finish() {
+      index.clear();
+      for (auto& r : rows) index[key(r)].second++;
+      size_t off = 0;
+      for (auto& e : index) {
+        auto count = e.second.second;
+        e.second = std::make_pair(off, off);  // second is the fill cursor
+        off += count;
+      }
+      std::vector<T> grouped(rows.size());
+      for (auto& r : rows) grouped[index[key(r)].second++] = r;
+      rows.swap(grouped);
+    }
+
+    size_t size() const { return rows.size(); }
+
+    /// Matches for `k` as [first, last).
+    std::pair<const T*, const T*> lookup( const K& k ) const {
+      auto it = index.find(k);
+      if (it == index.end()) return std::make_pair(nullptr, nullptr);
+      return std::make_pair(rows.data() + it->second.first, rows.data() + it->second.second);
+    }
+};
+
+/// Probe side of a hash join against the same core's HashJoinBuild,
+/// emitting `combine(probe, match)` for each match.
+template < typename L, typename Out, typename Build, typename KeyF, typename Combine >
+class HashJoinProbe : public Consumer<L> {
+  Consumer<Out> * next;
+  Build * build;
+  KeyF key;
+  Combine combine;
+
+  public:
+    HashJoinProbe( Consumer<Out> * next, Build * build, KeyF key, Combine combine )
+      : next(next), build(build), key(key), combine(combine) {}
+
+    void consume( const L * in, size_t n ) {
+      std::vector<Out> out;
+      out.reserve(FLAGS_pipeline_batch_size);
+      for (size_t i = 0; i < n; i++) {
+        auto m = build->lookup(key(in[i]));
+        for (auto r = m.first; r != m.second; r++) {
+          out.push_back(combine(in[i], *r));
+          if (out.size() >= FLAGS_pipeline_batch_size) {
+            next->consume(out.data(), out.size());
+            out.clear();
+          }
+        }
+      }
+      if (!out.empty()) next->consume(out.data(), out.size());
+    }
+
+    void finish() { next->finish(); }
+};
+
+/// Feeds tuples to a GroupBy with `f(group_by, tuple)`; on finish, ships
+/// this core's partial aggregates, so the GroupBy is complete once the
+/// stage is.
+template < typename T, typename G, typename F >
+class Aggregate : public Consumer<T> {
+  G * g;
+  F f;
+
+  public:
+    Aggregate( G * g, F f ) : g(g), f(f) {}
+
+    void consume( const T * in, size_t n ) {
+      for (size_t i = 0; i < n; i++) f(*g, in[i]);
+    }
+
+    void finish() {
+      g->flush();
+      g->sender.wait();
+    }
+};
+
+/// Pushes each batch to two consumers.
+template < typename T >
+class Tee : public Consumer<T> {
+  Consumer<T> * a;
+  Consumer<T> * b;
+
+  public:
+    Tee( Consumer<T> * a, Consumer<T> * b ) : a(a), b(b) {}
+
+    void consume( const T * in, size_t n ) {
+      a->consume(in, n);
+      b->consume(in, n);
+    }
+
+    void finish() {
+      a->finish();
+      b->finish();
+    }
+};
+
+/// Hands each batch to `f(tuples, n)`.
+template < typename T, typename F >
+class Sink : public Consumer<T> {
+  F f;
+
+  public:
+    Sink( F f ) : f(f) {}
+    void consume( const T * in, size_t n ) { f(in, n); }
+    void finish() {}
+};
+
+/// Repartitions tuples by `key` across cores, sending per-core chunks in
+/// bulk. Received chunks are pushed downstream by new tasks on the
+/// destination, and acknowledged once consumed. Finish waits until every
+/// core has finished sending to this core before finishing downstream.
+template < typename T, typename KeyF >
+class Shuffle : public Consumer<T> {
+  static const size_t CHUNK_BYTES = 2048;
+  typedef Grappa::ChunkSender::Chunk<T,CHUNK_BYTES> Chunk;
+
+  GlobalAddress<Plan> plan;
+  size_t id;
+  Consumer<T> * next;
+  KeyF key;
+  std::vector<std::vector<T>> buffers;  // per destination core
+  Grappa::ChunkSender sender;           // chunks sent but not yet consumed
+  int64_t done;                         // cores that finished sending here
+  Grappa::ConditionVariable all_done;   // signaled when done reaches cores()
+
+  static Shuffle * on( GlobalAddress<Plan> plan, size_t id ) {
+    return static_cast<Shuffle*>(plan->shuffles[id]);
+  }
+
+  void send( Grappa::Core c ) {
+    // take the buffer first: the send may block on the window while other
+    // tasks keep pushing to buffers[c]
+    std::vector<T> out;
+    out.swap(buffers[c]);
+    pipeline_shuffle_chunks++;
+    auto plan = this->plan;
+    auto id = this->id;
+    sender.send_with_ack<CHUNK_BYTES>(c, out.data(), out.size(),
+        [plan,id](const T * in, size_t n, size_t offset, Grappa::ChunkSender::Ack ack) {
+      auto tuples = new std::vector<T>(in, in + n);
+      Grappa::spawn([plan,id,tuples,ack] {
+        on(plan, id)->next->consume(tuples->data(), tuples->size());
+        delete tuples;
+        ack();
+      });
+    });
+  }
+
+  public:
+    Shuffle( Plan& p, Consumer<T> * next, KeyF key )
+      : plan(p.self)
+      , id(p.shuffles.size())
+      , next(next)
+      , key(key)
+      , buffers(Grappa::cores())
+      , sender(FLAGS_pipeline_max_inflight)
+      , done(0)
+    {
+      p.shuffles.push_back(this);
+    }
+
+    void consume( const T * in, size_t n ) {
+      for (size_t i = 0; i < n; i++) {
+        Grappa::Core c = std::hash<decltype(key(in[i]))>()(key(in[i])) % Grappa::cores();
+        buffers[c].push_back(in[i]);
+        if (buffers[c].size() == Chunk::capacity) send(c);
+      }
+    }
+
+    void finish() {
+      for (Grappa::Core c = 0; c < Grappa::cores(); c++) {
+        if (!buffers[c].empty()) send(c);
+      }
+      sender.wait();
+      auto plan = this->plan;
+      auto id = this->id;
+      for (Grappa::Core c = 0; c < Grappa::cores(); c++) {
+        Grappa::send_heap_message(c, [plan,id] {
+          auto s = on(plan, id);
+          if (++s->done == Grappa::cores()) Grappa::broadcast(&s->all_done);
+        });
+      }
+      while (done < Grappa::cores()) Grappa::wait(&all_done);
+      done = 0;
+      next->finish();
+    }
+};
+
+/// @name Plan-building helpers (type parameters deduced where possible)
+/// @{
+
+template < typename T, typename Pred >
+Consumer<T> * select( Plan& p, Pred pred, Consumer<T> * next ) {
+  return p.add(new Select<T,Pred>(next, pred));
+}
+
+template < typename In, typename Out, typename F >
+Consumer<In> * project( Plan& p, F f, Consumer<Out> * next ) {
+  return p.add(new Project<In,Out,F>(next, f));
+}
+
+template < typename T, typename KeyF >
+Consumer<T> * shuffle( Plan& p, KeyF key, Consumer<T> * next ) {
+  return p.add(new Shuffle<T,KeyF>(p, next, key));
+}
+
+template < typename T, typename KeyF,
+           typename K = typename std::decay<decltype(std::declval<KeyF>()(std::declval<const T&>()))>::type >
+HashJoinBuild<K,T,KeyF> * hash_build( Plan& p, KeyF key ) {
+  return p.add(new HashJoinBuild<K,T,KeyF>(key));
+}
+
+template < typename L, typename Build, typename KeyF, typename Combine, typename Out >
+Consumer<L> * hash_probe( Plan& p, Build * build, KeyF key, Combine combine, Consumer<Out> * next ) {
+  return p.add(new HashJoinProbe<L,Out,Build,KeyF,Combine>(next, build, key, combine));
+}
+
+template < typename T, typename G, typename F >
+Consumer<T> * aggregate( Plan& p, GlobalAddress<G> g, F f ) {
+  return p.add(new Aggregate<T,G,F>(g.localize(), f));
+}
+
+template < typename T >
+Consumer<T> * tee( Plan& p, Consumer<T> * a, Consumer<T> * b ) {
+  return p.add(new Tee<T>(a, b));
+}
+
+template < typename T, typename F >
+Consumer<T> * sink( Plan& p, F f ) {
+  return p.add(new Sink<T,F>(f));
+}
+
+/// @}
+
+} // namespace Pipeline
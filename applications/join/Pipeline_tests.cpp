@@ -0,0 +1,85 @@
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include "Pipeline.hpp"
+
+using namespace Grappa;
+using namespace Pipeline;
+using Aggregates::GroupBy;
+using Aggregates::Count;
+
+BOOST_AUTO_TEST_SUITE( Pipeline_tests );
+
+DEFINE_int64( pipeline_nr, 10000, "Rows in R" );
+DEFINE_int64( pipeline_ns, 1000, "Rows in S" );
+
+struct RT { int64_t a, b; };
+struct ST { int64_t b, c; };
+struct Out { int64_t a, c; };
+
+typedef GroupBy<int64_t, Count> G;
+
+int64_t joined = 0;
+int64_t reshuffled = 0, reshuffled_sum = 0;
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t nr = FLAGS_pipeline_nr, ns = FLAGS_pipeline_ns;
+    auto R = global_alloc<RT>(nr);
+    auto S = global_alloc<ST>(ns);
+    forall(R, nr, [](int64_t i, RT& r){ r.a = i; r.b = i % 100; });
+    forall(S, ns, [](int64_t j, ST& s){ s.b = j % 100; s.c = j; });
+
+    // SELECT c % 10, count(*) FROM R, S WHERE R.b = S.b AND R.a % 2 = 0 GROUP BY c % 10
+    auto g = G::create();
+    auto plan = Plan::create([g](Plan& p) {
+      auto agg = aggregate<Out>(p, g, [](G& g, const Out& o){ g.update(o.c % 10, 1); });
+      auto count = sink<Out>(p, [](const Out * t, size_t n){ joined += n; });
+      auto both = tee(p, agg, count);
+      auto ht = hash_build<ST>(p, [](const ST& s){ return s.b; });
+      p.source(0, shuffle(p, [](const ST& s){ return s.b; }, ht));
+      auto join = hash_probe<RT>(p, ht, [](const RT& r){ return r.b; },
+                                 [](const RT& r, const ST& s){ return Out{r.a, s.c}; }, both);
+      auto even = select(p, [](const RT& r){ return r.a % 2 == 0; }, join);
+      p.source(1, shuffle(p, [](const RT& r){ return r.b; }, even));
+    });
+    plan->scan(0, S, ns);
+    plan->scan(1, R, nr);
+
+    // each even a matches the ns/100 rows of S with b == a % 100
+    BOOST_CHECK_EQUAL( sum_all_cores([]{ return joined; }), (nr / 2) * (ns / 100) );
+    BOOST_CHECK_EQUAL( g->size(), 5 );
+    g->forall_groups([nr,ns](const G::Group& gr) {
+      CHECK_EQ( gr.key % 2, 0 );
+      CHECK_EQ( std::get<0>(gr.values), (nr / 10) * (ns / 100) );
+    });
+
+    plan->destroy();
+    g->destroy();
+
+    // two chained shuffles, the second with a one-chunk window (Shuffles
+    // read --pipeline_max_inflight when built): chunks arriving from the
+    // first keep pushing into the second's buffers while its sends block
+    auto chained = Plan::create([](Plan& p) {
+      auto max_inflight = FLAGS_pipeline_max_inflight;
+      auto count = sink<RT>(p, [](const RT * t, size_t n){
+        reshuffled += n;
+        for (size_t i = 0; i < n; i++) reshuffled_sum += t[i].a;
+      });
+      FLAGS_pipeline_max_inflight = 1;
+      auto second = shuffle(p, [](const RT& r){ return r.a; }, count);
+      FLAGS_pipeline_max_inflight = max_inflight;
+      p.source(0, shuffle(p, [](const RT& r){ return r.b; }, second));
+    });
+    chained->scan(0, R, nr);
+    BOOST_CHECK_EQUAL( sum_all_cores([]{ return reshuffled; }), nr );
+    BOOST_CHECK_EQUAL( sum_all_cores([]{ return reshuffled_sum; }), nr * (nr - 1) / 2 );
+    chained->destroy();
+    global_free(R);
+    global_free(S);
+    Metrics::merge_and_print();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
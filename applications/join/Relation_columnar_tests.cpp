@@ -0,0 +1,76 @@
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+
+#include <Grappa.hpp>
+#include <GlobalAllocator.hpp>
+
+#include "relation_io.hpp"
+
+using namespace Grappa;
+using namespace Columnar;
+
+BOOST_AUTO_TEST_SUITE( Relation_columnar_tests );
+
+const int64_t NROWS = 100003;
+const int64_t BLOCK = 1000;
+
+// exercises each encoding: packed ids, dictionary, plain, constant, negatives
+int64_t value(int64_t row, int col) {
+  switch (col) {
+    case 0: return row;
+    case 1: return (row % 7) * 1000000007L;
+    case 2: return int64_t((uint64_t(row) * 0x9E3779B97F4A7C15ULL) ^ (uint64_t(row) << 17));
+    case 3: return 42;
+    default: return -((row * 31) % 1000);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  Grappa::init( GRAPPA_TEST_ARGS );
+  Grappa::run([]{
+    std::string fn = "columnar_test.col";
+    {
+      ColumnarWriter w(FLAGS_relations+"/"+fn, 5, BLOCK);
+      int64_t row[5];
+      for (int64_t r = 0; r < NROWS; r++) {
+        for (int c = 0; c < 5; c++) row[c] = value(r, c);
+        w.append(row);
+      }
+    }
+
+    // everything
+    auto all = ColumnarRelation::load(fn, {});
+    BOOST_CHECK_EQUAL( all->size(), NROWS );
+    all->forall_rows([](const ColumnarRelation& r, size_t i) {
+      int64_t row = r.data[0][i];
+      for (int c = 1; c < 5; c++) CHECK_EQ( r.data[c][i], value(row, c) );
+    });
+    all->destroy();
+
+    // projection + range filter: only the blocks overlapping [2500,5499] are read
+    on_all_cores([]{ Metrics::reset(); });
+    auto some = ColumnarRelation::load(fn, {2, 0}, {{0, 2500, 5499}});
+    BOOST_CHECK_EQUAL( some->size(), 3000 );
+    some->forall_rows([](const ColumnarRelation& r, size_t i) {
+      int64_t row = r.data[1][i];
+      CHECK( row >= 2500 && row <= 5499 );
+      CHECK_EQ( r.data[0][i], value(row, 2) );
+    });
+    some->destroy();
+
+    auto read = sum_all_cores([]{ return columnar_blocks_read.value(); });
+    auto skipped = sum_all_cores([]{ return columnar_blocks_skipped.value(); });
+    BOOST_CHECK_EQUAL( read, 4 );
+    BOOST_CHECK_EQUAL( read + skipped, (NROWS + BLOCK - 1) / BLOCK );
+
+    // filter on a dictionary column
+    auto odd = ColumnarRelation::load(fn, {0}, {{1, 1000000007L, 1000000007L}});
+    BOOST_CHECK_EQUAL( odd->size(), (NROWS + 5) / 7 );
+    odd->destroy();
+
+    std::remove((FLAGS_relations+"/"+fn).c_str());
+  });
+  Grappa::finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -3,13 +3,20 @@
 int main(int argc, char** argv) {
 
   if (argc < 5) {
-    std::cerr << "Usage: " << argv[0] << " FILE TYPE{i,d} SEPS BURNS" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " FILE TYPE{i,d} SEPS BURNS [col]" << std::endl;
     exit(1);
   }
+
+  bool columnar = argc > 5 && strcmp(argv[5], "col") == 0;
   
   if (strncmp(argv[2], "i", 1) == 0) {
-    convert2bin<int64_t,decltype(&toInt)>( argv[1], &toInt, argv[3], atoi(argv[4]) );
+    convert2bin<int64_t,decltype(&toInt)>( argv[1], &toInt, argv[3], atoi(argv[4]), columnar );
   } else if (strncmp(argv[2], "d", 1) == 0) {
+    if (columnar) {
+      // zone maps and packing assume integer columns
+      std::cerr << "columnar output supports only integer columns" << std::endl;
+      exit(1);
+    }
     convert2bin<double,decltype(&toDouble)>( argv[1], &toDouble, argv[3], atoi(argv[4]) );
   } else {
     std::cerr << "unrecognized type " << argv[2] << std::endl;
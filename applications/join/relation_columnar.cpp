@@ -0,0 +1,286 @@
+#include "relation_columnar.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, columnar_blocks_read, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, columnar_blocks_skipped, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, columnar_bytes_decoded, 0);
+GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, columnar_load_runtime, 0);
+
+namespace Columnar {
+
+  // bits needed to represent 0..range
+  static uint8_t bits_for(uint64_t range) {
+    uint8_t b = 0;
+    while (b < 64 && (range >> b) != 0) b++;
+    return b;
+  }
+
+  static size_t packed_words(size_t n, uint8_t bits) {
+    return (n * bits + 63) / 64;
+  }
+
+  static void pack(const uint64_t * vals, size_t n, uint8_t bits, std::vector<uint64_t>& words) {
+    words.assign(packed_words(n, bits), 0);
+    if (bits == 0) return;
+    for (size_t i = 0; i < n; i++) {
+      size_t bit = i * bits, w = bit / 64, off = bit % 64;
+      words[w] |= vals[i] << off;
+      if (off + bits > 64) words[w+1] |= vals[i] >> (64 - off);
+    }
+  }
+
+  static inline uint64_t unpack(const uint64_t * words, size_t i, uint8_t bits) {
+    if (bits == 0) return 0;
+    size_t bit = i * bits, w = bit / 64, off = bit % 64;
+    uint64_t v = words[w] >> off;
+    if (off + bits > 64) v |= words[w+1] << (64 - off);
+    return v & ((bits == 64) ? ~0ULL : ((1ULL << bits) - 1));
+  }
+
+  ////////////////////////////////////////////////////////////////////
+  // ColumnarWriter
+
+  ColumnarWriter::ColumnarWriter(std::string path, int64_t ncols, int64_t rows_per_block)
+    : out(path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary)
+    , pending(ncols)
+  {
+    CHECK( out.is_open() ) << path << " failed to open";
+    CHECK( ncols > 0 && rows_per_block > 0 && rows_per_block <= UINT32_MAX );
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.ncols = ncols;
+    header.nrows = 0;
+    header.rows_per_block = rows_per_block;
+    header.nblocks = 0;
+    header.directory_offset = 0;
+    // placeholder, rewritten by close()
+    out.write((char*)&header, sizeof(header));
+  }
+
+  ColumnarWriter::~ColumnarWriter() {
+    if (out.is_open()) close();
+  }
+
+  void ColumnarWriter::append(const int64_t * row) {
+    for (int64_t c = 0; c < header.ncols; c++) pending[c].push_back(row[c]);
+    header.nrows++;
+    if (pending[0].size() == header.rows_per_block) flush_block();
+  }
+
+  void ColumnarWriter::flush_block() {
+    if (pending[0].empty()) return;
+    for (auto& vals : pending) {
+      write_column_block(vals);
+      vals.clear();
+    }
+    header.nblocks++;
+  }
+
+  void ColumnarWriter::write_column_block(std::vector<int64_t>& vals) {
+    size_t n = vals.size();
+    ColumnBlock cb;
+    cb.min = *std::min_element(vals.begin(), vals.end());
+    cb.max = *std::max_element(vals.begin(), vals.end());
+    cb.offset = out.tellp();
+    cb.nrows = n;
+    cb.ndict = 0;
+
+    uint8_t range_bits = bits_for(uint64_t(cb.max) - uint64_t(cb.min));
+
+    std::vector<int64_t> dict(vals);
+    std::sort(dict.begin(), dict.end());
+    dict.erase(std::unique(dict.begin(), dict.end()), dict.end());
+    uint8_t code_bits = bits_for(dict.size() - 1);
+    size_t dict_bytes = 8 * (dict.size() + packed_words(n, code_bits));
+    size_t packed_bytes = 8 * packed_words(n, range_bits);
+
+    std::vector<uint64_t> raw(n), words;
+    if (dict.size() <= UINT16_MAX && dict_bytes < packed_bytes) {
+      cb.encoding = DICT;
+      cb.bits = code_bits;
+      cb.ndict = dict.size();
+      for (size_t i = 0; i < n; i++) {
+        raw[i] = std::lower_bound(dict.begin(), dict.end(), vals[i]) - dict.begin();
+      }
+      pack(raw.data(), n, code_bits, words);
+      out.write((char*)dict.data(), 8 * dict.size());
+      out.write((char*)words.data(), 8 * words.size());
+    } else if (range_bits < 64) {
+      cb.encoding = PACKED;
+      cb.bits = range_bits;
+      for (size_t i = 0; i < n; i++) raw[i] = uint64_t(vals[i]) - uint64_t(cb.min);
+      pack(raw.data(), n, range_bits, words);
+      out.write((char*)words.data(), 8 * words.size());
+    } else {
+      cb.encoding = PLAIN;
+      cb.bits = 64;
+      out.write((char*)vals.data(), 8 * n);
+    }
+    directory.push_back(cb);
+  }
+
+  void ColumnarWriter::close() {
+    flush_block();
+    // directory is stored block-major: directory[b * ncols + c]
+    header.directory_offset = out.tellp();
+    out.write((char*)directory.data(), sizeof(ColumnBlock) * directory.size());
+    out.seekp(0);
+    out.write((char*)&header, sizeof(header));
+    CHECK( out.good() ) << "failed writing columnar file";
+    out.close();
+  }
+
+  ////////////////////////////////////////////////////////////////////
+  // ColumnarFile
+
+  ColumnarFile::ColumnarFile(std::string path) {
+    fd = open(path.c_str(), O_RDONLY);
+    CHECK( fd >= 0 ) << path << " failed to open";
+    struct stat st;
+    CHECK( fstat(fd, &st) == 0 );
+    length = st.st_size;
+    CHECK( length >= sizeof(ColumnarHeader) ) << path << " is too short to be a columnar file";
+    base = (const char*)mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    CHECK( base != MAP_FAILED ) << "mmap of " << path << " failed";
+    header = reinterpret_cast<const ColumnarHeader*>(base);
+    CHECK( memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 ) << path << " is not a columnar file";
+    CHECK( header->directory_offset + sizeof(ColumnBlock) * header->nblocks * header->ncols <= length );
+    directory = reinterpret_cast<const ColumnBlock*>(base + header->directory_offset);
+  }
+
+  ColumnarFile::~ColumnarFile() {
+    munmap((void*)base, length);
+    ::close(fd);
+  }
+
+  void ColumnarFile::decode(int64_t b, int64_t col, int64_t * out) const {
+    auto& cb = block(b, col);
+    const char * data = base + cb.offset;
+    size_t n = cb.nrows;
+    switch (cb.encoding) {
+      case PLAIN:
+        memcpy(out, data, 8 * n);
+        break;
+      case PACKED: {
+        // every block starts on an 8-byte boundary, so words are aligned
+        auto words = reinterpret_cast<const uint64_t*>(data);
+        for (size_t i = 0; i < n; i++) out[i] = cb.min + int64_t(unpack(words, i, cb.bits));
+        break;
+      }
+      case DICT: {
+        auto dict = reinterpret_cast<const int64_t*>(data);
+        auto words = reinterpret_cast<const uint64_t*>(data) + cb.ndict;
+        for (size_t i = 0; i < n; i++) out[i] = dict[unpack(words, i, cb.bits)];
+        break;
+      }
+      default:
+        LOG(FATAL) << "unknown column encoding " << int(cb.encoding);
+    }
+    columnar_bytes_decoded += 8 * n;
+  }
+
+  ////////////////////////////////////////////////////////////////////
+  // ColumnarRelation
+
+  void ColumnarRelation::load_local(const char * path, const int32_t * cols, int ncols,
+                                    const ColumnFilter * filters, int nfilters) {
+    ColumnarFile f(path);
+    if (ncols == 0) {
+      for (int c = 0; c < f.ncols(); c++) columns.push_back(c);
+    } else {
+      columns.assign(cols, cols + ncols);
+    }
+    for (auto c : columns) CHECK( c >= 0 && c < f.ncols() ) << "no column " << c;
+    for (int i = 0; i < nfilters; i++) CHECK( filters[i].col >= 0 && filters[i].col < f.ncols() );
+    data.assign(columns.size(), std::vector<int64_t>());
+
+    // this core's contiguous range of blocks
+    int64_t nb = f.nblocks();
+    int64_t b_start = nb * Grappa::mycore() / Grappa::cores();
+    int64_t b_end = nb * (Grappa::mycore() + 1) / Grappa::cores();
+
+    std::vector<int64_t> scratch, fvals;
+    std::vector<uint32_t> selected;
+
+    for (int64_t b = b_start; b < b_end; b++) {
+      size_t n = f.block(b, 0).nrows;
+      scratch.resize(n);
+
+      // zone maps: skip the block, or learn that every row passes
+      bool skip = false, all = true;
+      for (int i = 0; i < nfilters; i++) {
+        if (!f.may_match(b, filters[i])) { skip = true; break; }
+        if (!f.all_match(b, filters[i])) all = false;
+      }
+      if (skip) {
+        columnar_blocks_skipped++;
+        continue;
+      }
+      columnar_blocks_read++;
+
+      selected.clear();
+      if (!all) {
+        std::vector<bool> pass(n, true);
+        fvals.resize(n);
+        for (int i = 0; i < nfilters; i++) {
+          if (f.all_match(b, filters[i])) continue;
+          f.decode(b, filters[i].col, fvals.data());
+          for (size_t r = 0; r < n; r++) {
+            if (fvals[r] < filters[i].lo || fvals[r] > filters[i].hi) pass[r] = false;
+          }
+        }
+        for (size_t r = 0; r < n; r++) if (pass[r]) selected.push_back(r);
+        if (selected.empty()) continue;
+      }
+
+      for (size_t i = 0; i < columns.size(); i++) {
+        auto& dst = data[i];
+        f.decode(b, columns[i], scratch.data());
+        if (all) {
+          dst.insert(dst.end(), scratch.begin(), scratch.begin() + n);
+        } else {
+          for (auto r : selected) dst.push_back(scratch[r]);
+        }
+      }
+    }
+    VLOG(2) << "loaded " << local_rows() << " rows from blocks [" << b_start << "," << b_end << ")";
+  }
+
+  GlobalAddress<ColumnarRelation> ColumnarRelation::load(std::string fn,
+                                                         std::vector<int> columns,
+                                                         std::vector<ColumnFilter> filters) {
+    auto start = Grappa::walltime();
+    std::string data_path = FLAGS_relations+"/"+fn;
+
+    // broadcast the request as plain bytes
+    struct Request {
+      char path[2048];
+      int32_t cols[MAX_COLUMNS];
+      int ncols;
+      ColumnFilter filters[MAX_FILTERS];
+      int nfilters;
+    } req;
+    CHECK( data_path.size() <= 2040 );
+    CHECK( columns.size() <= MAX_COLUMNS ) << "at most " << MAX_COLUMNS << " projected columns";
+    CHECK( filters.size() <= MAX_FILTERS ) << "at most " << MAX_FILTERS << " filters";
+    sprintf(req.path, "%s", data_path.c_str());
+    req.ncols = columns.size();
+    std::copy(columns.begin(), columns.end(), req.cols);
+    req.nfilters = filters.size();
+    std::copy(filters.begin(), filters.end(), req.filters);
+
+    auto r = Grappa::symmetric_global_alloc<ColumnarRelation>();
+    Grappa::on_all_cores([r,req] {
+      auto self = new (r.localize()) ColumnarRelation(r);
+      self->load_local(req.path, req.cols, req.ncols, req.filters, req.nfilters);
+    });
+    columnar_load_runtime += Grappa::walltime() - start;
+    return r;
+  }
+
+} // namespace Columnar
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <Grappa.hpp>
+#include <Collective.hpp>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, columnar_blocks_read);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, columnar_blocks_skipped);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, columnar_bytes_decoded);
+GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, columnar_load_runtime);
+
+DECLARE_string(relations);
+
+/// Columnar relation file format.
+///
+/// Rows are split into blocks of `rows_per_block` rows; each block of each
+/// column is stored separately with a zone map (min/max) and its own
+/// encoding, so readers can skip columns they do not project and blocks
+/// whose zone maps miss a range filter.
+///
+///   ColumnarHeader
+///   block data (8-byte aligned; for each block, each column)
+///   directory: ColumnBlock[nblocks][ncols]
+///
+/// Encodings:
+///   PLAIN:  nrows int64 values
+///   PACKED: values - min, packed in `bits` bits each (bits may be 0)
+///   DICT:   ndict sorted int64 values, then codes packed in `bits` bits
+namespace Columnar {
+
+  const char MAGIC[8] = { 'G','R','C','O','L','0','0','1' };
+
+  enum Encoding : uint8_t { PLAIN = 0, PACKED = 1, DICT = 2 };
+
+  struct ColumnarHeader {
+    char magic[8];
+    int64_t ncols;
+    int64_t nrows;
+    int64_t rows_per_block;
+    int64_t nblocks;
+    uint64_t directory_offset;
+  };
+
+  struct ColumnBlock {
+    int64_t min;
+    int64_t max;
+    uint64_t offset;   // of the block data in the file
+    uint32_t nrows;
+    uint8_t encoding;
+    uint8_t bits;
+    uint16_t ndict;
+  };
+
+  /// Inclusive range predicate on one column, lo <= col <= hi.
+  struct ColumnFilter {
+    int32_t col;
+    int64_t lo;
+    int64_t hi;
+  };
+
+  /// Streams rows into a columnar file, one block of rows at a time.
+  class ColumnarWriter {
+    std::ofstream out;
+    ColumnarHeader header;
+    std::vector<std::vector<int64_t>> pending;  // buffered rows, by column
+    std::vector<ColumnBlock> directory;
+
+    void flush_block();
+    void write_column_block(std::vector<int64_t>& vals);
+
+    public:
+      ColumnarWriter(std::string path, int64_t ncols, int64_t rows_per_block = 1 << 16);
+      ~ColumnarWriter();
+
+      void append(const int64_t * row);
+
+      /// Write the directory and header; called by the destructor if needed.
+      void close();
+  };
+
+  /// Read-only view of a columnar file through mmap.
+  class ColumnarFile {
+    int fd;
+    const char * base;
+    size_t length;
+    const ColumnarHeader * header;
+    const ColumnBlock * directory;
+
+    public:
+      ColumnarFile(std::string path);
+      ~ColumnarFile();
+
+      int64_t ncols() const { return header->ncols; }
+      int64_t nrows() const { return header->nrows; }
+      int64_t nblocks() const { return header->nblocks; }
+
+      const ColumnBlock& block(int64_t b, int64_t col) const {
+        return directory[b * header->ncols + col];
+      }
+
+      /// Can block `b` hold rows satisfying the filter?
+      bool may_match(int64_t b, const ColumnFilter& f) const {
+        auto& cb = block(b, f.col);
+        return !(cb.max < f.lo || cb.min > f.hi);
+      }
+
+      /// Do all rows of block `b` satisfy the filter?
+      bool all_match(int64_t b, const ColumnFilter& f) const {
+        auto& cb = block(b, f.col);
+        return cb.min >= f.lo && cb.max <= f.hi;
+      }
+
+      /// Decode column `col` of block `b` into `out` (block(b,col).nrows values).
+      void decode(int64_t b, int64_t col, int64_t * out) const;
+  };
+
+  /// A relation loaded column-wise into per-core arrays: each core holds
+  /// a contiguous range of the file's blocks, keeping only the projected
+  /// columns and the rows passing all filters.
+  ///
+  /// ColumnarRelation is a symmetric data structure:
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// // columns 0 and 3 of rows with 100 <= col 1 <= 200
+  /// auto r = ColumnarRelation::load("edges.col", {0, 3}, {{1, 100, 200}});
+  /// r->forall_rows([](const ColumnarRelation& r, size_t i) {
+  ///   use(r.data[0][i], r.data[1][i]);
+  /// });
+  /// r->destroy();
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  class ColumnarRelation {
+    public:
+      static const int MAX_COLUMNS = 32;
+      static const int MAX_FILTERS = 8;
+
+      GlobalAddress<ColumnarRelation> self;
+      std::vector<int> columns;                 // file column of each loaded column
+      std::vector<std::vector<int64_t>> data;   // data[i][r]: column columns[i] of local row r
+
+      ColumnarRelation(GlobalAddress<ColumnarRelation> self) : self(self) {}
+
+      size_t local_rows() const { return data.empty() ? 0 : data[0].size(); }
+
+      /// Load `columns` (all if empty) of the rows of file `fn` in
+      /// --relations that pass every filter.
+      static GlobalAddress<ColumnarRelation> load(std::string fn,
+                                                  std::vector<int> columns,
+                                                  std::vector<ColumnFilter> filters = std::vector<ColumnFilter>());
+
+      /// Total rows loaded on all cores.
+      size_t size() {
+        auto self = this->self;
+        return Grappa::sum_all_cores([self] { return self->local_rows(); });
+      }
+
+      /// Call `f(relation, row)` for each local row on each core.
+      template < typename F >
+      void forall_rows(F f) {
+        auto self = this->self;
+        Grappa::on_all_cores([self,f] {
+          auto& r = *self.localize();
+          for (size_t i = 0; i < r.local_rows(); i++) f(r, i);
+        });
+      }
+
+      void destroy() {
+        auto self = this->self;
+        Grappa::on_all_cores([self] { self->~ColumnarRelation(); });
+        Grappa::global_free(self);
+      }
+
+    private:
+      void load_local(const char * path, const int32_t * cols, int ncols,
+                      const ColumnFilter * filters, int nfilters);
+  } GRAPPA_BLOCK_ALIGNED;
+
+  /// Write the tuples of `vec` (with get(j)/numFields(), as for
+  /// writeTuplesUnordered) as columnar file `fn` in --relations.
+  template < typename T >
+  void writeColumnar(std::vector<T>& vec, std::string fn, int64_t rows_per_block = 1 << 16) {
+    CHECK( !vec.empty() ) << "cannot infer the columns of an empty relation";
+    int64_t ncols = vec[0].numFields();
+    ColumnarWriter w(FLAGS_relations+"/"+fn, ncols, rows_per_block);
+    std::vector<int64_t> row(ncols);
+    for (auto& t : vec) {
+      for (int64_t j = 0; j < ncols; j++) row[j] = t.get(j);
+      w.append(row.data());
+    }
+    w.close();
+  }
+
+} // namespace Columnar
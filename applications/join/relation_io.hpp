@@ -5,6 +5,7 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <memory>
 //#include <regex>
 
 #include <boost/filesystem.hpp>
@@ -15,6 +16,7 @@ namespace fs = boost::filesystem;
 #include <ParallelLoop.hpp>
 #include "Tuple.hpp"
 #include "relation.hpp"
+#include "relation_columnar.hpp"
 
 #include "grappa/graph.hpp"
 
@@ -262,14 +264,19 @@ double toDouble(std::string& s) {
   return std::stod(s);
 }
 #include <boost/tokenizer.hpp>
+// columnar: write fn.col in the Columnar format instead of row-major fn.bin
 template< typename N=int64_t, typename Parser=decltype(toInt) >
-void convert2bin( std::string fn, Parser parser=&toInt, char * separators=" ", uint64_t burn=0 ) {
+void convert2bin( std::string fn, Parser parser=&toInt, char * separators=" ", uint64_t burn=0, bool columnar=false ) {
   std::ifstream infile(fn, std::ifstream::in);
   CHECK( infile.is_open() ) << fn << " failed to open";
   
-  std::string outpath = fn+".bin";
-  std::ofstream outfile(outpath, std::ios_base::out | std::ios_base::binary );
-  CHECK( outfile.is_open() ) << outpath << " failed to open";
+  std::string outpath = fn+(columnar ? ".col" : ".bin");
+  std::ofstream outfile;
+  std::unique_ptr<Columnar::ColumnarWriter> colfile;
+  if (!columnar) {
+    outfile.open(outpath, std::ios_base::out | std::ios_base::binary );
+    CHECK( outfile.is_open() ) << outpath << " failed to open";
+  }
     
   std::string line;
   int64_t expected_numcols = -1;
@@ -297,18 +304,24 @@ void convert2bin( std::string fn, Parser parser=&toInt, char * separators=" ", u
     if (expected_numcols < 0) { 
       expected_numcols = readFields.size();
       std::cout << expected_numcols << " cols from example " << readFields << std::endl;
+      if (columnar) colfile.reset(new Columnar::ColumnarWriter(outpath, expected_numcols));
     }
     CHECK (expected_numcols == readFields.size()) << "line " << linenum 
                                                   << " does not have " << expected_numcols << " columns";
 
 
-    outfile.write((char*) &readFields[0], sizeof(int64_t)*readFields.size()); 
+    if (colfile) {
+      colfile->append(reinterpret_cast<int64_t*>(&readFields[0]));
+    } else {
+      outfile.write((char*) &readFields[0], sizeof(int64_t)*readFields.size()); 
+    }
     ++linenum;
   }
 
   infile.close();
-  outfile.close();
-  std::cout << "binary: " << outpath << std::endl;
+  if (colfile) colfile->close();
+  else outfile.close();
+  std::cout << (columnar ? "columnar: " : "binary: ") << outpath << std::endl;
   std::cout << "rows: " << linenum << std::endl;
   std::cout << "cols: " << expected_numcols << std::endl;
 
@@ -6,6 +6,7 @@
 #include <Delegate.hpp>
 #include <Grappa.hpp>
 #include "local_graph.hpp"
+#include "LeapfrogJoin.hpp"
 #include "utility.hpp"
 
 #ifdef PROGRESS
@@ -31,12 +32,14 @@ using namespace Grappa;
 DEFINE_uint64( scale, 7, "Graph will have ~ 2^scale vertices" );
 DEFINE_uint64( edgefactor, 16, "Median degree; graph will have ~ 2*edgefactor*2^scale edges" );
 DEFINE_uint64( progressInterval, 5, "interval between progress updates" );
+DEFINE_bool( leapfrog, false, "Count each core's triangles with a leapfrog triejoin instead of nested adjacency lookups" );
 
 GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, edges_transfered, 0);
 
 //outputs
 GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, triangle_count, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, triangles_runtime, 0);
+GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, triangles_local_runtime, 0);
 
 double generation_time;
 double construction_time;
@@ -143,6 +146,28 @@ void triangles(GlobalAddress<Graph<Vertex>> g) {
     // hash function
     auto hf = makeHash( sidelength );
 
+    if (FLAGS_leapfrog) {
+      // each undirected edge (u,v), u<v, once per role in R(x,y), S(y,z), T(x,z);
+      // only the core at (hf(x),hf(y),hf(z)) sees all three edges of triangle x<y<z
+      for (auto& dst : v.adj_iter()) {
+        if (!(i < dst)) continue;
+        Edge e(i, dst);
+        for (auto l : Loc3d(sidelength, hf(i), hf(dst), Loc3d::ALL)) {
+          delegate::call<async>( l, [e] { localAssignedEdges_R1.push_back(e); });
+          edgesSent++;
+        }
+        for (auto l : Loc3d(sidelength, Loc3d::ALL, hf(i), hf(dst))) {
+          delegate::call<async>( l, [e] { localAssignedEdges_R2.push_back(e); });
+          edgesSent++;
+        }
+        for (auto l : Loc3d(sidelength, hf(i), Loc3d::ALL, hf(dst))) {
+          delegate::call<async>( l, [e] { localAssignedEdges_R3.push_back(e); });
+          edgesSent++;
+        }
+      }
+      return;
+    }
+
     for (auto& dst : v.adj_iter()) {
       
       const int64_t from = i;
@@ -206,6 +231,22 @@ void triangles(GlobalAddress<Graph<Vertex>> g) {
 #endif
 
     LOG(INFO) << "received (" << localAssignedEdges_R1.size() << ", " << localAssignedEdges_R2.size() << ", " << localAssignedEdges_R3.size() << ") edges";
+    double local_start = Grappa::walltime();
+
+    if (FLAGS_leapfrog) {
+      TrieRelation R(localAssignedEdges_R1), S(localAssignedEdges_R2), T(localAssignedEdges_R3);
+      TrieJoin j(3);
+      j.add(R, 0, 1);
+      j.add(S, 1, 2);
+      j.add(T, 0, 2);
+      j.run([](const int64_t * xyz) {
+        emit( xyz[0], xyz[1], xyz[2] );
+        triangle_count++;
+      });
+      triangles_local_runtime += Grappa::walltime() - local_start;
+      LOG(INFO) << "counted " << count << " triangles (leapfrog); tuples=(" << R.size() << ", " << S.size() << ", " << T.size() << ")";
+      return;
+    }
 
 #ifdef DEDUP_EDGES
     // construct local graphs
@@ -270,6 +311,7 @@ void triangles(GlobalAddress<Graph<Vertex>> g) {
       }
     }
 
+    triangles_local_runtime += Grappa::walltime() - local_start;
     LOG(INFO) << "counted " << count << " triangles; R1adjs="<<R1adjs;
   });
   end = Grappa::walltime();
@@ -19,6 +19,7 @@
 #include <GlobalCompletionEvent.hpp>
 #include <AsyncDelegate.hpp>
 #include <Metrics.hpp>
+#include <BloomFilter.hpp>
 
 // Data structure includes
 #include "MatchesDHT.hpp"
@@ -34,6 +35,7 @@ DEFINE_string( fin, "", "Input file relation" );
 DEFINE_uint64( file_num_tuples, 0, "Number of lines in file" );
 
 DEFINE_bool( print, false, "Print results" );
+DEFINE_bool( bloom, false, "Filter probes with a replicated Bloom filter of the join keys before looking them up" );
 
 
 // outputs
@@ -44,6 +46,7 @@ GRAPPA_DEFINE_METRIC(SimpleMetric<double>, hash_runtime, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, twohop_runtime, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, count_reduction_runtime, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, read_runtime, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<double>, bloom_build_runtime, 0);
 
 
 using namespace Grappa;
@@ -113,6 +116,15 @@ void twohop( GlobalAddress<Tuple> tuples, size_t num_tuples ) {
   VLOG(1) << "insertions: " << num_tuples/(end-start) << " per sec";
   hash_runtime = end - start;
 
+  // replicated filter of the join keys, so probes with no match stay local
+  GlobalAddress<BloomFilter<int64_t>> key_filter;
+  if (FLAGS_bloom) {
+    start = Grappa::walltime();
+    key_filter = BloomFilter<int64_t>::create( num_tuples );
+    key_filter->build( tuples, num_tuples, [](Tuple& t) { return t.columns[0]; } );
+    bloom_build_runtime = Grappa::walltime() - start;
+  }
+
 
 #if DEBUG
   printAll(tuples, num_tuples);
@@ -133,8 +145,9 @@ void twohop( GlobalAddress<Tuple> tuples, size_t num_tuples ) {
   //on_all_cores([]{Grappa_start_profiling();});
   start = Grappa::walltime();
   VLOG(1) << "Starting 1st join";
-  forall( tuples, num_tuples, [](int64_t i, Tuple& t) {
+  forall( tuples, num_tuples, [key_filter](int64_t i, Tuple& t) {
     int64_t key = t.columns[1];
+    if ( FLAGS_bloom && !key_filter->may_contain( key ) ) return;
    
     // will pass on this first vertex to compare in the select 
     int64_t x1 = t.columns[0];
@@ -209,6 +222,8 @@ void twohop( GlobalAddress<Tuple> tuples, size_t num_tuples ) {
     count_reduction_runtime = Grappa::walltime() - end;
 #endif 
 
+  if (FLAGS_bloom) key_filter->destroy();
+
 //  Metrics::stop_tracing();
   Grappa::Metrics::merge_and_print();
 }
@@ -18,6 +18,7 @@ Igor do
     nbfs: 3,
     beamer_alpha: 20.0,
     beamer_beta: 20.0,
+    vertex_order: 'original',
   })
   GFLAGS.delete :flat_combining
   
@@ -45,6 +46,7 @@ Igor do
   
   expect :total_time
   @cols << :total_time_mean
+  @cols << :graph_core_adj_max
   @order = :total_time_mean
   
   interact # enter interactive mode
@@ -47,6 +47,7 @@ DEFINE_int32(nbfs, 1, "Number of BFS traversals to do.");
 
 DEFINE_string(path, "", "Path to graph source file.");
 DEFINE_string(format, "bintsv4", "Format of graph source file.");
+DEFINE_string(vertex_order, "original", "Vertex numbering/partitioning: original, degree or balanced.");
 
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, init_time, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, tuple_time, 0);
@@ -80,7 +81,7 @@ int main(int argc, char* argv[]) {
     double t = walltime();
     
     // construct the compact graph representation (roughly CSR)
-    auto g = G::Undirected( tg );
+    auto g = G::create( tg, false, true, vertex_order_from_string(FLAGS_vertex_order) );
     
     construction_time = (walltime()-t);
     LOG(INFO) << construction_time;
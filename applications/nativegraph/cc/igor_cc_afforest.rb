@@ -0,0 +1,48 @@
+#!/usr/bin/env ruby
+require 'igor'
+
+# inherit parser, sbatch_flags
+require_relative '../../util/igor_common.rb'
+
+# Library Afforest vs. Kahan's 3-phase CC on Kronecker and road-like grid graphs.
+Igor do
+  include Isolatable
+  
+  database '~/osdi.sqlite', :cc
+  
+  isolate(['cc_kahan.exe'])
+  
+  GFLAGS.merge!({
+    scale: 24,
+    edgefactor: 16,
+    cc_impl: ['afforest', 'kahan'],
+    generator: ['kronecker', 'grid'],
+    grid_keep: 0.7,
+  })
+  GFLAGS.delete :flat_combining
+  
+  params.merge!(GFLAGS)
+  
+  @c = ->{ %Q[ %{tdir}/grappa_srun --no-freeze-on-error
+    -- %{tdir}/cc_kahan.exe --metrics
+    #{GFLAGS.expand}
+  ].gsub(/\s+/,' ') }
+  command @c[]
+  
+  sbatch_flags << "--time=30:00"
+  
+  params {
+    nnode       1, 4, 16
+    ppn         16
+    loop_threshold 1024
+    num_starting_workers 512
+    global_heap_fraction 0.2
+    shared_pool_chunk_size 2**15
+  }
+  
+  expect :total_time
+  @cols << :total_time
+  @order = :total_time
+  
+  interact # enter interactive mode
+end
@@ -37,6 +37,7 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include <Grappa.hpp>
+#include <graph/ConnectedComponents.hpp>
 #include "cc_kahan.hpp"
 
 DEFINE_bool( metrics, false, "Dump metrics");
@@ -47,6 +48,10 @@ DEFINE_int32(edgefactor, 16, "Average number of edges per vertex.");
 DEFINE_string(path, "", "Path to graph source file.");
 DEFINE_string(format, "bintsv4", "Format of graph source file.");
 
+DEFINE_string(cc_impl, "kahan", "Connected components implementation: 'kahan' (3-phase, below) or 'afforest' (Graph library)");
+DEFINE_string(generator, "kronecker", "Synthetic graph when no --path: 'kronecker' or 'grid' (road-like, 2^scale vertices)");
+DEFINE_double(grid_keep, 0.7, "Fraction of grid edges kept by --generator=grid");
+
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, init_time, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, tuple_time, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<double>, construction_time, 0);
@@ -79,7 +84,10 @@ int main(int argc, char* argv[]) {
     TupleGraph tg;
     
     GRAPPA_TIME_REGION(tuple_time) {
-      if (FLAGS_path.empty()) {
+      if (FLAGS_path.empty() && FLAGS_generator == "grid") {
+        int64_t rows = 1L << (FLAGS_scale / 2);
+        tg = TupleGraph::Grid(rows, (1L << FLAGS_scale) / rows, FLAGS_grid_keep, 111);
+      } else if (FLAGS_path.empty()) {
         int64_t NE = (1L << FLAGS_scale) * FLAGS_edgefactor;
         tg = TupleGraph::Kronecker(FLAGS_scale, NE, 111, 222);
       } else {
@@ -97,7 +105,12 @@ int main(int argc, char* argv[]) {
     LOG(INFO) << construction_time;
     
     GRAPPA_TIME_REGION(total_time) {
-      ncomponents = connected_components(g);
+      if (FLAGS_cc_impl == "afforest") {
+        ncomponents = Grappa::connected_components(g, [](G::Vertex& v) -> VertexID& { return v->color; });
+      } else {
+        CHECK_EQ(FLAGS_cc_impl, "kahan") << "unknown --cc_impl";
+        ncomponents = connected_components(g);
+      }
     }
     LOG(INFO) << total_time;
     
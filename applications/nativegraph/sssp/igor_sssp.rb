@@ -0,0 +1,47 @@
+#!/usr/bin/env ruby
+require 'igor'
+
+# inherit parser, sbatch_flags
+require_relative '../../util/igor_common.rb'
+
+# Strong scaling of library delta-stepping vs. the iterative relaxation
+# in this app (see ../../graphlab/igor_graphlab_sssp.rb for GraphLab's).
+Igor do
+  include Isolatable
+  
+  database '~/osdi.sqlite', :sssp
+  
+  isolate(['sssp.exe'])
+  
+  GFLAGS.merge!({
+    scale: 23,
+    edgefactor: 16,
+    sssp_impl: ['delta', 'bellman'],
+    delta: 0,
+  })
+  GFLAGS.delete :flat_combining
+  
+  params.merge!(GFLAGS)
+  
+  @c = ->{ %Q[ %{tdir}/grappa_srun --no-freeze-on-error
+    -- %{tdir}/sssp.exe --metrics
+    #{GFLAGS.expand}
+  ].gsub(/\s+/,' ') }
+  command @c[]
+  
+  sbatch_flags << "--time=30:00"
+  
+  params {
+    nnode       1, 2, 4, 8, 16
+    ppn         16
+    loop_threshold 1024
+    num_starting_workers 512
+    global_heap_fraction 0.25
+  }
+  
+  expect :sssp_time
+  @cols << :sssp_time_mean
+  @order = :sssp_time_mean
+  
+  interact # enter interactive mode
+end
@@ -1,6 +1,7 @@
 #include <Grappa.hpp>
 #include <GlobalVector.hpp>
 #include <graph/Graph.hpp>
+#include <graph/SSSP.hpp>
 
 #include "sssp.hpp"
 
@@ -9,6 +10,8 @@ DEFINE_bool(metrics, false, "Dump metrics");
 DEFINE_int32(scale, 10, "Log2 number of vertices.");
 DEFINE_int32(edgefactor, 16, "Average number of edges per vertex.");
 DEFINE_int64(root, 16, "Average number of edges per vertex.");
+DEFINE_string(sssp_impl, "delta", "SSSP implementation: 'delta' (library delta-stepping) or 'bellman' (relax all reached vertices until nothing changes)");
+DEFINE_double(delta, 0, "Bucket width for delta-stepping (0: max weight / average degree)");
 
 using namespace Grappa;
 
@@ -108,7 +111,12 @@ int main(int argc, char* argv[]) {
     t = walltime();
 
     auto root = FLAGS_root;
-    do_sssp(g, root);
+    if (FLAGS_sssp_impl == "delta") {
+      Grappa::sssp(g, root, [](G::Edge& e){ return e->weight; }, FLAGS_delta);
+    } else {
+      CHECK_EQ(FLAGS_sssp_impl, "bellman") << "unknown --sssp_impl";
+      do_sssp(g, root);
+    }
 
     double this_sssp_time = walltime() - t;
     LOG(INFO) << "(root=" << root << ", time=" << this_sssp_time << ")";
@@ -79,6 +79,9 @@ public:
       CHECK(!(j > max_bfsvtx && i <= max_bfsvtx)) << "Error!";
       if (i > max_bfsvtx) // both i & j are on the same side of max_bfsvtx
       return;
+      
+      // edges use input IDs; the graph may have been relabeled
+      i = g->internal_id(i); j = g->internal_id(j);
 
       // All neighbors must be in the tree.
       auto ti = get_parent(g,i), tj = get_parent(g,j);
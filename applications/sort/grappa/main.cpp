@@ -200,21 +200,30 @@ void bucket_sort(GlobalAddress<uint64_t> array, size_t nelems, size_t nbuckets)
   VLOG(3) << "scattering...";
       t = Grappa::walltime();
 
-  // scatter into buckets
-  // forall_local<uint64_t,scatter>(array, nelems);
-  forall(array, nelems, [bucketlist](int64_t s, int64_t n, uint64_t * first){
+  // scatter into buckets: group each core's elements by the core owning
+  // their bucket, exchange them in bulk, then append to local buckets
+  on_all_cores([array,nelems,bucketlist]{
     size_t nbuckets = counts.size();
-    
-    for (int i=0; i<n; i++) {
-      auto v = first[i];
-      size_t b = v >> LOBITS;
+    uint64_t * first = array.localize();
+    uint64_t * last = (array+nelems).localize();
+
+    std::vector<Core> owner(nbuckets);
+    for (size_t b=0; b<nbuckets; b++) owner[b] = (bucketlist+b).core();
+
+    std::vector<size_t> send_counts(cores(), 0);
+    for (auto p = first; p < last; p++) {
+      size_t b = *p >> LOBITS;
       CHECK( b < nbuckets ) << "bucket id = " << b << ", nbuckets = " << nbuckets;
-      // ff_delegate<bucket_t,uint64_t,ff_append>(bucketlist+b, v);
-      auto destb = bucketlist+b;
-      delegate::call<async>(destb.core(), [destb,v]{
-        destb.pointer()->append(v);
-      });
+      send_counts[owner[b]]++;
     }
+    std::vector<size_t> pos(cores(), 0);
+    for (Core c=1; c<cores(); c++) pos[c] = pos[c-1] + send_counts[c-1];
+    std::vector<uint64_t> send(last - first);
+    for (auto p = first; p < last; p++) send[pos[owner[*p >> LOBITS]]++] = *p;
+
+    std::vector<uint64_t> recv;
+    alltoallv(send.data(), send_counts.data(), recv);
+    for (auto v : recv) (bucketlist + (v >> LOBITS)).pointer()->append(v);
   });
     
   scatter_time = Grappa::walltime() - t;
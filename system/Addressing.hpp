@@ -45,6 +45,7 @@
 /// 2D addresses are a PGAS-style tuple of ( core, address on core )
 ///
 /// Linear addresses are block cyclic across all the cores in the system.
+/// The block size defaults to 64 bytes, but may be chosen per allocation.
 ///
 /// TODO: update "core" to mean "core" in all the right places.  
 ///
@@ -94,6 +95,50 @@ static const intptr_t core_mask = (1L << core_bits) - 1;
 static const intptr_t pool_mask = (1L << pool_bits) - 1;
 static const intptr_t pointer_mask = (1L << pointer_bits) - 1;
 
+/// Linear addresses with a non-default distribution block size store
+/// it in the bits between the pointer and the tag: a flag in the top
+/// bit of the field, then a (exponent, mantissa) pair giving a block of
+/// (mantissa * block_size) << exponent bytes. Default linear addresses
+/// leave the flag clear and are unchanged.
+static const int block_field_bits = 64 - pointer_bits - tag_bits;
+static const int block_field_shift_val = pointer_bits;
+static const intptr_t block_field_mask = (1L << block_field_bits) - 1;
+static const intptr_t block_field_flag = 1L << (block_field_bits - 1);
+static const int block_mantissa_bits = 10;
+static const intptr_t block_mantissa_mask = (1L << block_mantissa_bits) - 1;
+static const int block_exponent_max = (1 << (block_field_bits - 1 - block_mantissa_bits)) - 1;
+
+namespace Grappa {
+namespace impl {
+
+/// Decode the block size field of a linear address.
+inline size_t decode_block_field( intptr_t field ) {
+  if( !(field & block_field_flag) ) return block_size;
+  int exponent = (field & ~block_field_flag) >> block_mantissa_bits;
+  return static_cast< size_t >( (field & block_mantissa_mask) * block_size ) << exponent;
+}
+
+/// Encode a distribution block size, rounding up to the next size the
+/// address field can represent.
+inline intptr_t encode_block_bytes( size_t bytes ) {
+  intptr_t units = (bytes + block_size - 1) / block_size;
+  if( units <= 1 ) return 0;
+  int exponent = 0;
+  while( ((units + (1L << exponent) - 1) >> exponent) > block_mantissa_mask ) exponent++;
+  CHECK_LE( exponent, block_exponent_max ) << "block size " << bytes << " too large for linear address";
+  intptr_t mantissa = (units + (1L << exponent) - 1) >> exponent;
+  if( mantissa == 1 && exponent == 0 ) return 0;
+  return block_field_flag | (static_cast< intptr_t >( exponent ) << block_mantissa_bits) | mantissa;
+}
+
+/// Smallest representable distribution block size of at least `bytes` bytes.
+inline size_t round_block_bytes( size_t bytes ) {
+  return decode_block_field( encode_block_bytes( bytes ) );
+}
+
+}
+}
+
 /// @addtogroup Memory
 /// @{
 
@@ -125,11 +170,12 @@ private:
                << " pointer " << static_cast<void *>( pointer() )
                << ">";
     } else {
-        return o << "<GA Linear " << (void*)storage_ 
+        o << "<GA Linear " << (void*)storage_ 
 //                 << ": pool " << pool() 
-                 << " core " << core()
-                 << " pointer " << static_cast<void *>( pointer()  )
-                 << ">";
+          << " core " << core()
+          << " pointer " << static_cast<void *>( pointer()  );
+        if( !default_blocks() ) o << " block " << block_bytes();
+        return o << ">";
     }
   }
 
@@ -163,21 +209,31 @@ public:
   /// TODO: the pool argument is currenly unused
   static GlobalAddress Linear( T * t, Pool p = 0 )
   {
+    return LinearBlocked( t, block_size );
+  }
+
+  /// Construct a linear global address from a local pointer into an
+  /// allocation distributed in blocks of `block_bytes` bytes.
+  static GlobalAddress LinearBlocked( T * t, size_t block_bytes )
+  {
+    intptr_t field = Grappa::impl::encode_block_bytes( block_bytes );
+    intptr_t bs = Grappa::impl::decode_block_field( field );
+
     // adjust for chunk offset
     intptr_t tt = reinterpret_cast< intptr_t >( t ) - 
       reinterpret_cast< intptr_t >( Grappa::impl::global_memory_chunk_base );
 
-    intptr_t offset = tt % block_size;
-    intptr_t block = tt / block_size;
+    intptr_t offset = tt % bs;
+    intptr_t block = tt / bs;
     // intptr_t core_from_address = block % global_communicator.cores;
     // CHECK_EQ( core_from_address, 0 ) << "Core from address should be zero. (Check alignment?)";
-    intptr_t ga = ( block * global_communicator.cores + global_communicator.mycore ) * block_size + offset;
+    intptr_t ga = ( block * global_communicator.cores + global_communicator.mycore ) * bs + offset;
     
     T * ttt = reinterpret_cast< T * >( ga );
     
     GlobalAddress g;
     g.storage_ = ( ( 0L << tag_shift_val ) |
-                   //( ( n & core_mask) << core_shift_val ) |
+                   ( field << block_field_shift_val ) |
                    ( reinterpret_cast<intptr_t>( ttt ) ) );
 
     CHECK_EQ( g.core(), global_communicator.mycore ) << "converted linear address core doesn't match";
@@ -199,17 +255,34 @@ public:
     return storage_;
   }
 
+  /// byte offset of a linear address, without the block size field
+  inline intptr_t linear_offset() const {
+    return default_blocks() ? storage_ : storage_ & pointer_mask;
+  }
+
+  /// is this a linear address with the default block size?
+  inline bool default_blocks() const {
+    return !( storage_ & (block_field_flag << block_field_shift_val) );
+  }
+
   /// Return the home core of a global address
   inline Core core() const {
     if( is_2D() ) {
       return (storage_ >> core_shift_val) & core_mask;
+    } else if( default_blocks() ) {
+      return (storage_ / block_size) % global_communicator.cores;
     } else {
-      intptr_t offset = storage_ % block_size;
-      intptr_t core = (storage_ / block_size) % global_communicator.cores;
-      intptr_t core_block = (storage_ / block_size) / global_communicator.cores;
-      return core;
+      intptr_t bs = block_bytes();
+      return (linear_offset() / bs) % global_communicator.cores;
     }
   }
+
+  /// Number of contiguous bytes placed on one core before a linear
+  /// address range moves on to the next core.
+  inline size_t block_bytes() const {
+    if( is_2D() || default_blocks() ) return block_size;
+    return Grappa::impl::decode_block_field( (storage_ >> block_field_shift_val) & block_field_mask );
+  }
   
   /// Return the home core of a global address
   /// TODO: implement this.
@@ -223,14 +296,19 @@ public:
     if( is_2D() ) {
       intptr_t signextended = (storage_ << pointer_shift_val) >> pointer_shift_val;
       return reinterpret_cast< T * >( signextended ); 
-    } else {
+    } else if( default_blocks() ) {
       intptr_t offset = storage_ % block_size;
-      intptr_t block = (storage_ / block_size);
-      intptr_t core = (storage_ / block_size) % global_communicator.cores;
       intptr_t core_block = (storage_ / block_size) / global_communicator.cores;
       intptr_t address = core_block * block_size + offset + 
         reinterpret_cast< intptr_t >( Grappa::impl::global_memory_chunk_base );
       return reinterpret_cast< T * >( address );
+    } else {
+      intptr_t bs = block_bytes();
+      intptr_t offset = linear_offset() % bs;
+      intptr_t core_block = (linear_offset() / bs) / global_communicator.cores;
+      intptr_t address = core_block * bs + offset + 
+        reinterpret_cast< intptr_t >( Grappa::impl::global_memory_chunk_base );
+      return reinterpret_cast< T * >( address );
     }
   }
 
@@ -241,7 +319,7 @@ public:
     
   	if (nid == -1) nid = global_communicator.mycore;
     T * local_base;
-    size_t block_elems = block_size / sizeof(T);
+    size_t block_elems = block_bytes() / sizeof(T);
     T * block_base = block_min().pointer();
     if (nid < core()) {
       local_base = block_base+block_elems;
@@ -270,10 +348,8 @@ public:
       //GlobalAddress< U > u = GlobalAddress< U >::Raw( storage_ );
       return GlobalAddress< T >::TwoDimensional( (T*) 0, core() );
     } else {
-      intptr_t first_byte = storage_;
-      intptr_t first_byte_offset = first_byte % block_size;
-      intptr_t core = (first_byte / block_size) %   global_communicator.cores;
-      intptr_t core_block = (first_byte / block_size) / global_communicator.cores;
+      intptr_t first_byte = linear_offset();
+      intptr_t first_byte_offset = first_byte % block_bytes();
       return GlobalAddress< T >::Raw( this->raw_bits() - first_byte_offset );
     }
   }
@@ -295,13 +371,11 @@ public:
       //return reinterpret_cast< T * >( -1 ); 
       return GlobalAddress< T >::TwoDimensional( (T*) 1, core() );
     } else {
-      intptr_t first_byte = storage_;
-      intptr_t first_byte_offset = first_byte % block_size;
+      intptr_t bs = block_bytes();
+      intptr_t first_byte = linear_offset();
       intptr_t last_byte = first_byte + sizeof(T) - 1;
-      intptr_t last_byte_offset = last_byte % block_size;
-      intptr_t core = (last_byte / block_size) % global_communicator.cores;
-      intptr_t core_block = (last_byte / block_size) / global_communicator.cores;
-      return GlobalAddress< T >::Raw( this->raw_bits() + sizeof(T) + block_size - (last_byte_offset + 1) );
+      intptr_t last_byte_offset = last_byte % bs;
+      return GlobalAddress< T >::Raw( this->raw_bits() + sizeof(T) + bs - (last_byte_offset + 1) );
     }
   }
 
@@ -315,10 +389,6 @@ public:
     return !( storage_ & tag_mask );
   }
 
-  // inline size_t block_size() const {
-  //   return block_size_;
-  // }
-
   /// increment address by one T
   inline GlobalAddress< T >& operator++() {
     storage_ += sizeof(T); 
@@ -444,6 +514,13 @@ GlobalAddress< T > make_linear( T * t ) {
   return GlobalAddress< T >::Linear( t );
 }
 
+/// like make_linear(), for memory allocated with a non-default block
+/// size (see global_alloc(count, block_bytes)).
+template< typename T >
+GlobalAddress< T > make_linear( T * t, size_t block_bytes ) {
+  return GlobalAddress< T >::LinearBlocked( t, block_bytes );
+}
+
 /// output human-readable version of global address
 template< typename T >
 std::ostream& operator<<( std::ostream& o, const GlobalAddress< T >& ga ) {
@@ -467,6 +544,34 @@ inline GlobalAddress< M > global_pointer_to_member( const GlobalAddress< T > t,
   return GlobalAddress< M >::Raw( reinterpret_cast< intptr_t >( mp ) );
 }
 
+/// Largest payload sent in one message when acquiring or releasing a
+/// linear range; blocks larger than this take several messages.
+static const size_t max_transfer_bytes = 1 << 12;
+
+/// Number of bytes the next acquire/release message moves starting at
+/// `a` with `remaining` bytes left: up to the end of a's block, capped
+/// at max_transfer_bytes. 2D addresses go in a single message.
+inline size_t transfer_bytes( GlobalAddress< char > a, size_t remaining ) {
+  if( a.is_2D() ) return remaining;
+  size_t n = a.block_max() - a;
+  if( n > max_transfer_bytes ) n = max_transfer_bytes;
+  return n < remaining ? n : remaining;
+}
+
+/// Number of messages transfer_bytes() splits a linear range of
+/// `nbytes` bytes starting at `a` into.
+inline int transfer_message_count( GlobalAddress< char > a, size_t nbytes ) {
+  if( a.block_bytes() <= max_transfer_bytes ) {
+    ptrdiff_t byte_diff = (a + nbytes - 1).block_max() - a.block_min();
+    return byte_diff / a.block_bytes();
+  }
+  int n = 0;
+  for( size_t offset = 0; offset < nbytes; n++ ) {
+    offset += transfer_bytes( a + offset, nbytes - offset );
+  }
+  return n;
+}
+
 template<typename T>
 struct LocalIterator {
   GlobalAddress<T> base;
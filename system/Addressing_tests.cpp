@@ -38,6 +38,7 @@
 
 #include "Grappa.hpp"
 #include "Addressing.hpp"
+#include "Cache.hpp"
 
 
 BOOST_AUTO_TEST_SUITE( Addressing_tests );
@@ -351,6 +352,76 @@ BOOST_AUTO_TEST_CASE( test1 ) {
         BOOST_CHECK_EQUAL( brandonm2_byte_diff, 128 );
         BOOST_CHECK_EQUAL( brandonm2_block_diff, 2 );
       }
+
+      // undo the hack so the allocations below see the real heap
+      Grappa::impl::global_memory_chunk_base = prev_base;
+    }
+
+    BOOST_MESSAGE( "Testing per-allocation block sizes" );
+    {
+      BOOST_CHECK_EQUAL( Grappa::impl::encode_block_bytes( 64 ), 0 );
+      BOOST_CHECK_EQUAL( Grappa::impl::round_block_bytes( 4096 ), 4096 );
+      BOOST_CHECK_EQUAL( Grappa::impl::round_block_bytes( 65 ), 128 );
+      BOOST_CHECK_GE( Grappa::impl::round_block_bytes( 1000001 ), 1000001 );
+
+      const int64_t n = 5000;
+      auto d = Grappa::global_alloc< int64_t >( n );
+      auto a = Grappa::global_alloc< int64_t >( n, 4096 );
+      auto b = Grappa::global_alloc_blocked< int64_t >( n );
+
+      BOOST_CHECK_EQUAL( d.block_bytes(), block_size );
+      BOOST_CHECK_EQUAL( a.block_bytes(), 4096 );
+      BOOST_CHECK_GE( b.block_bytes(), n * sizeof(int64_t) / Grappa::cores() );
+      BOOST_CHECK_EQUAL( a.core(), 0 );
+      BOOST_CHECK_EQUAL( b.core(), 0 );
+
+      const int64_t per_block = 4096 / sizeof(int64_t);
+      for( int64_t i = 0; i < n; i += 97 ) {
+        BOOST_CHECK_EQUAL( (a+i).core(), (i / per_block) % Grappa::cores() );
+        BOOST_CHECK_EQUAL( (a+i).block_bytes(), 4096 );
+        BOOST_CHECK_EQUAL( (a+i) - a, i );
+      }
+      BOOST_CHECK_EQUAL( (b+n-1).core(), ((n-1) * sizeof(int64_t) / b.block_bytes()) % Grappa::cores() );
+
+      Grappa::forall( d, n, []( int64_t i, int64_t& e ) { e = -i; } );
+      Grappa::forall( a, n, [a]( int64_t i, int64_t& e ) {
+        CHECK_EQ( (a+i).core(), Grappa::mycore() );
+        e = i;
+      });
+      Grappa::forall( b, n, []( int64_t i, int64_t& e ) { e = 2*i; } );
+
+      // each core's part of the range is one contiguous local run
+      Grappa::on_all_cores( [a,b,n] {
+        size_t na = 0, nb = 0;
+        for( int64_t i = 0; i < n; i++ ) {
+          if( (a+i).core() == Grappa::mycore() ) na++;
+          if( (b+i).core() == Grappa::mycore() ) nb++;
+        }
+        CHECK_EQ( iterate_local( a, n ).size(), na );
+        CHECK_EQ( iterate_local( b, n ).size(), nb );
+        for( auto& e : iterate_local( b, n ) ) {
+          CHECK_EQ( make_linear( &e, b.block_bytes() ), b + e/2 );
+        }
+      });
+
+      for( int64_t i = 0; i < n; i++ ) {
+        BOOST_CHECK_EQUAL( Grappa::delegate::read( d+i ), -i );
+        BOOST_CHECK_EQUAL( Grappa::delegate::read( a+i ), i );
+        BOOST_CHECK_EQUAL( Grappa::delegate::read( b+i ), 2*i );
+      }
+
+      Grappa::memcpy( d, a, n );
+      Grappa::memcpy( b, d, n );
+      int64_t buf[ 1000 ];
+      Incoherent< int64_t >::RO c( b+1234, 1000, buf );
+      c.block_until_acquired();
+      for( int64_t i = 0; i < 1000; i++ ) {
+        BOOST_CHECK_EQUAL( buf[i], 1234+i );
+      }
+
+      Grappa::global_free( b );
+      Grappa::global_free( a );
+      Grappa::global_free( d );
     }
   });
   Grappa::finalize();
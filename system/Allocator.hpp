@@ -205,11 +205,15 @@ public:
     }
   }
 
-  /// Free a previously-allocated chunk.
+  /// Free a previously-allocated chunk. The address may point
+  /// anywhere inside the chunk, so callers that align the start of an
+  /// allocation don't have to remember the original pointer.
   void free( void * void_address ) {
     intptr_t address = reinterpret_cast< intptr_t >( void_address ) - base_;
-    ChunkMap::iterator block_to_free_iterator = chunks_.find( address );
-    assert( block_to_free_iterator != chunks_.end() );
+    ChunkMap::iterator block_to_free_iterator = chunks_.upper_bound( address );
+    assert( block_to_free_iterator != chunks_.begin() );
+    --block_to_free_iterator;
+    assert( address < static_cast< intptr_t >( block_to_free_iterator->second.address + block_to_free_iterator->second.size ) );
     assert( block_to_free_iterator->second.in_use == true );
     add_to_free_list( block_to_free_iterator );
 
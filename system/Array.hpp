@@ -86,7 +86,7 @@ namespace impl {
     int64_t nlastcore = src_end - src_end.block_min();
     int64_t nmiddle = nelem - nfirstcore - nlastcore;
     
-    const size_t nblock = block_size / sizeof(T);
+    const size_t nblock = src.block_bytes() / sizeof(T);
     
     CHECK_EQ(nmiddle % nblock, 0);
 
@@ -116,7 +116,7 @@ namespace impl {
     size_t nlocalblocks = nlocal_trimmed/nblock;
     Writeback * ws = locale_alloc<Writeback>(nlocalblocks);
     for (size_t i=0; i<nlocalblocks; i++) {
-      size_t j = make_linear(local_base+(i*nblock))-src;
+      size_t j = make_linear(local_base+(i*nblock), src.block_bytes())-src;
       new (ws+i) Writeback(dst+j, nblock, local_base+(i*nblock));
       ws[i].start_release();
     }
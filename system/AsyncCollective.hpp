@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Collective.hpp"
+#include "AsyncDelegate.hpp"
+#include "Metrics.hpp"
+
+#include <map>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, async_collectives);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, async_collectives_ready);
+
+namespace Grappa {
+  
+  /// @addtogroup Collectives
+  /// @{
+  
+  /// Handle to the result of a split-phase collective (`iallreduce`,
+  /// `ibarrier`, `ibroadcast`). The collective proceeds in the background;
+  /// `get()` blocks only if it has not finished yet.
+  ///
+  /// Handles may be moved but not copied. Destroying one waits for its
+  /// collective to finish, since the result is delivered into it.
+  template< typename T >
+  class CollectiveFuture {
+    delegate::Promise<T> * p;
+    
+    void release() {
+      if (p) {
+        p->get();
+        delete p;
+        p = nullptr;
+      }
+    }
+    
+  public:
+    explicit CollectiveFuture(delegate::Promise<T> * p): p(p) {}
+    CollectiveFuture(CollectiveFuture&& o): p(o.p) { o.p = nullptr; }
+    CollectiveFuture& operator=(CollectiveFuture&& o) {
+      if (this != &o) {
+        release();
+        p = o.p;
+        o.p = nullptr;
+      }
+      return *this;
+    }
+    CollectiveFuture(const CollectiveFuture&) = delete;
+    CollectiveFuture& operator=(const CollectiveFuture&) = delete;
+    
+    ~CollectiveFuture() { release(); }
+    
+    /// Has the collective finished on this core?
+    bool ready() const { return p->ready(); }
+    
+    /// Result of the collective, suspending this task until it is available.
+    T get() {
+      if (p->ready()) async_collectives_ready++;
+      return p->get();
+    }
+  };
+  
+  namespace impl {
+    
+    /// Split-phase collectives of one type/op, matched up by sequence number.
+    /// Each core contributes to the entry at HOME_CORE, which replies to every
+    /// core once all have arrived. Any number may be outstanding at once.
+    template< typename T, T (*ReduceOp)(const T&, const T&) >
+    struct SplitPhaseReduction {
+      struct Entry {
+        T total;
+        bool has_value;
+        Core cores_in;
+        std::vector<delegate::Promise<T>*> waiters;  // by core
+        Entry(): total(), has_value(false), cores_in(0), waiters(cores(), nullptr) {}
+      };
+      
+      // at HOME_CORE: collectives some cores have joined
+      static std::map<int64_t,Entry>& pending() {
+        static std::map<int64_t,Entry> entries;
+        return entries;
+      }
+      
+      // join the next collective, contributing `val` if `has_value`
+      static CollectiveFuture<T> start(bool has_value, const T& val) {
+        static int64_t next_seq = 0;
+        int64_t seq = next_seq++;
+        auto p = new delegate::Promise<T>();
+        Core origin = mycore();
+        async_collectives++;
+        
+        send_heap_message(HOME_CORE, [seq,has_value,val,origin,p]{
+          auto it = pending().find(seq);
+          if (it == pending().end()) it = pending().insert(std::make_pair(seq, Entry())).first;
+          auto& e = it->second;
+          if (has_value) {
+            e.total = e.has_value ? ReduceOp(e.total, val) : val;
+            e.has_value = true;
+          }
+          e.waiters[origin] = p;
+          
+          if (++e.cores_in == cores()) {
+            T total = e.total;
+            for (Core c = 0; c < cores(); c++) {
+              auto w = e.waiters[c];
+              send_heap_message(c, [w,total]{ w->fill(total); });
+            }
+            pending().erase(it);
+          }
+        });
+        return CollectiveFuture<T>(p);
+      }
+    };
+    
+    inline bool ibarrier_op(const bool& a, const bool& b) { return a && b; }
+    
+    template< typename T >
+    T ibroadcast_op(const T& a, const T& b) { return a; }
+    
+  } // namespace impl
+  
+  /// Split-phase `allreduce`: called from SPMD context, contributes `myval`
+  /// and returns immediately; the handle yields the reduction over all
+  /// cores. Unlike `allreduce`, several may be outstanding at once, but
+  /// every core must issue the ones of a given type/op in the same order.
+  ///
+  /// @b Example (overlap the convergence check with the next iteration):
+  /// @code
+  ///   on_all_cores([]{
+  ///     auto delta = iallreduce<double,collective_add>(local_iteration());
+  ///     while (true) {
+  ///       double next = local_iteration();   // runs while the reduction is in flight
+  ///       if (delta.get() < epsilon) break;
+  ///       delta = iallreduce<double,collective_add>(next);
+  ///     }
+  ///   });
+  /// @endcode
+  template< typename T, T (*ReduceOp)(const T&, const T&) >
+  CollectiveFuture<T> iallreduce(T myval) {
+    return impl::SplitPhaseReduction<T,ReduceOp>::start(true, myval);
+  }
+  
+  /// Split-phase barrier: called from SPMD context; `get()` on the handle
+  /// returns once every core has called `ibarrier`.
+  inline CollectiveFuture<bool> ibarrier() {
+    return impl::SplitPhaseReduction<bool,impl::ibarrier_op>::start(true, true);
+  }
+  
+  /// Split-phase broadcast: called from SPMD context on all cores; the
+  /// handle yields the value passed on core `root` (others' are ignored).
+  template< typename T >
+  CollectiveFuture<T> ibroadcast(Core root, const T& val) {
+    return impl::SplitPhaseReduction<T,impl::ibroadcast_op<T>>::start(mycore() == root, val);
+  }
+  
+  /// @}
+  
+} // namespace Grappa
@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <AsyncCollective.hpp>
+
+BOOST_AUTO_TEST_SUITE( AsyncCollective_tests );
+
+using namespace Grappa;
+
+bool arrived = false;
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t n = cores();
+    
+    BOOST_MESSAGE("iallreduce");
+    on_all_cores([n]{
+      auto sum = iallreduce<int64_t,collective_add>(mycore() + 1);
+      auto max = iallreduce<int64_t,collective_max>(mycore());
+      // several outstanding at once, waited on in any order
+      auto sum2 = iallreduce<int64_t,collective_add>(2 * (mycore() + 1));
+      BOOST_CHECK_EQUAL(sum2.get(), n * (n + 1));
+      BOOST_CHECK_EQUAL(max.get(), n - 1);
+      BOOST_CHECK_EQUAL(sum.get(), n * (n + 1) / 2);
+    });
+    
+    BOOST_MESSAGE("overlapped convergence check");
+    on_all_cores([n]{
+      // "converges" once the per-core delta reaches 0
+      int64_t iters = 0;
+      int64_t delta = 10 + mycore();
+      auto total = iallreduce<int64_t,collective_add>(delta);
+      while (true) {
+        delta = std::max<int64_t>(0, delta - 1);
+        iters++;
+        if (total.get() == 0) break;
+        total = iallreduce<int64_t,collective_add>(delta);
+      }
+      // one speculative iteration past the slowest core's 10 + (n-1)
+      BOOST_CHECK_EQUAL(iters, 10 + n);
+    });
+    
+    BOOST_MESSAGE("ibarrier");
+    on_all_cores([]{
+      arrived = true;
+      auto b = ibarrier();
+      b.get();
+      for (Core c = 0; c < cores(); c++) {
+        BOOST_CHECK(delegate::call(c, []{ return arrived; }));
+      }
+    });
+    
+    BOOST_MESSAGE("ibroadcast");
+    on_all_cores([]{
+      auto root = ibroadcast<Core>(0, cores() - 1);
+      auto v = ibroadcast<double>(root.get(), mycore() * 1.5);
+      BOOST_CHECK_EQUAL(v.get(), (cores() - 1) * 1.5);
+    });
+    
+    BOOST_CHECK_EQUAL(sum_all_cores([]{ return async_collectives.value(); }), n * (16 + n));
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
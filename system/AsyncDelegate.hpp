@@ -86,10 +86,14 @@ namespace Grappa {
       inline const R get() {
         // ... and wait for the result
         const R r = _result.readFF();
-        Grappa::impl::record_wakeup_latency(start_time, network_time);
+        // only remote calls are timed (not short-circuits or direct fills)
+        if (start_time != 0) Grappa::impl::record_wakeup_latency(start_time, network_time);
         return r;
       }
       
+      /// True once the result is available (`get` will not block).
+      inline bool ready() const { return _result.full(); }
+      
       /// Call `func` on remote node, returning immediately.
       template <typename F>
       void call_async(Core dest, F func) {
@@ -103,6 +107,7 @@ namespace Grappa {
           // short-circuit if local
           delegate_targets++;
           delegate_short_circuits++;
+          start_time = 0;
           fill(func());
         } else {
           start_time = Grappa::timestamp();
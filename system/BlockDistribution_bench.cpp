@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+/// Compares the default 64-byte block-cyclic distribution with larger
+/// per-allocation blocks (see global_alloc(count, block_bytes)) on a
+/// neighbor-reading range loop and on bulk transfers.
+
+#include "Grappa.hpp"
+#include "Cache.hpp"
+#include "Metrics.hpp"
+
+DEFINE_int64( bench_elements, 1 << 22, "Number of int64_t elements in each benchmark array" );
+DEFINE_int64( bench_block_bytes, 4096, "Block size in bytes for the large-block variant" );
+DEFINE_int64( bench_acquire_elements, 1 << 16, "Number of elements moved by each cache acquire" );
+
+using namespace Grappa;
+
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_default_loop_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_large_loop_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_blocked_loop_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_default_memcpy_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_large_memcpy_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_blocked_memcpy_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_default_acquire_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_large_acquire_time, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, block_bench_blocked_acquire_time, 0 );
+
+/// Time b[i] = a[i] + a[i+1]; neighbors are remote only at block boundaries.
+double time_range_loop( GlobalAddress<int64_t> a, GlobalAddress<int64_t> b, int64_t n ) {
+  forall(a, n, [](int64_t i, int64_t& e){ e = i; });
+  double start = walltime();
+  forall(b, n-1, [a](int64_t i, int64_t& e){ e = i + delegate::read(a+i+1); });
+  double t = walltime() - start;
+  for (int64_t i = 0; i < n-1; i += n/16+1) {
+    CHECK_EQ(delegate::read(b+i), 2*i+1);
+  }
+  return t;
+}
+
+/// Time a global memcpy and a series of contiguous cache acquires from core 0.
+std::pair<double,double> time_bulk( GlobalAddress<int64_t> a, GlobalAddress<int64_t> b, int64_t n ) {
+  double start = walltime();
+  Grappa::memcpy(b, a, n);
+  double copy_time = walltime() - start;
+  
+  int64_t m = std::min(FLAGS_bench_acquire_elements, n);
+  std::unique_ptr<int64_t[]> buf( new int64_t[m] );
+  start = walltime();
+  for (int64_t i = 0; i+m <= n; i += m) {
+    Incoherent<int64_t>::RO c(b+i, m, buf.get());
+    c.block_until_acquired();
+    CHECK_EQ(buf[m-1], i+m-1);
+  }
+  return std::make_pair(copy_time, walltime() - start);
+}
+
+int main(int argc, char* argv[]) {
+  init(&argc, &argv);
+  run([]{
+    int64_t n = FLAGS_bench_elements;
+    
+    struct Variant {
+      const char * name;
+      GlobalAddress<int64_t> a, b;
+      SimpleMetric<double> *loop, *copy, *acquire;
+    } variants[] = {
+      { "default", global_alloc<int64_t>(n), global_alloc<int64_t>(n),
+        &block_bench_default_loop_time, &block_bench_default_memcpy_time, &block_bench_default_acquire_time },
+      { "large", global_alloc<int64_t>(n, FLAGS_bench_block_bytes), global_alloc<int64_t>(n, FLAGS_bench_block_bytes),
+        &block_bench_large_loop_time, &block_bench_large_memcpy_time, &block_bench_large_acquire_time },
+      { "blocked", global_alloc_blocked<int64_t>(n), global_alloc_blocked<int64_t>(n),
+        &block_bench_blocked_loop_time, &block_bench_blocked_memcpy_time, &block_bench_blocked_acquire_time },
+    };
+    
+    for (auto& v : variants) {
+      *v.loop = time_range_loop(v.a, v.b, n);
+      auto bulk = time_bulk(v.a, v.b, n);
+      *v.copy = bulk.first;
+      *v.acquire = bulk.second;
+      LOG(INFO) << v.name << " (block " << v.a.block_bytes() << " bytes): "
+                << "range loop " << v.loop->value() << " s, "
+                << "memcpy " << v.copy->value() << " s, "
+                << "acquire " << v.acquire->value() << " s";
+      global_free(v.a);
+      global_free(v.b);
+    }
+    
+    Metrics::merge_and_print();
+  });
+  finalize();
+}
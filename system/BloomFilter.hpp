@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Grappa.hpp"
+#include "Collective.hpp"
+#include "GlobalAllocator.hpp"
+#include "ParallelLoop.hpp"
+#include "Metrics.hpp"
+#include "ChunkSender.hpp"
+#include "Hashing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, bloom_inserts);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, bloom_checks);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, bloom_rejects);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, bloom_replication_bytes);
+
+namespace Grappa {
+
+/// Blocked Bloom filter, replicated on every core.
+///
+/// Each key sets `k` bits within one 512-bit block (a cache line), so a
+/// check touches a single line. The filter is built in parallel: every
+/// core inserts keys into its own replica, then `replicate()` ORs the
+/// replicas together (each core reduces one slice of the bitset and
+/// broadcasts it back). Afterwards the filter is read-only and
+/// `may_contain` is a purely local check, so probe-side tuples can be
+/// dropped before any communication. `bloom_rejects` counts the keys
+/// turned away, i.e. the remote lookups avoided.
+///
+/// BloomFilter is a symmetric data structure:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// auto f = BloomFilter<int64_t>::create(nbuild);
+/// f->build(build_side, nbuild, [](const Tuple& t){ return t.key; });
+/// forall(probe_side, nprobe, [f](Tuple& t){
+///   if (f->may_contain(t.key)) lookup(t.key, ...);   // remote
+/// });
+/// f->destroy();
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+template< typename K, typename Hash = std::hash<K> >
+class BloomFilter {
+  static const size_t WORDS_PER_BLOCK = 8;    // 512 bits
+
+  GlobalAddress<BloomFilter> self;
+  std::vector<uint64_t> bits;
+  size_t nblocks;
+  int k;
+  ChunkSender sender;
+
+  BloomFilter(GlobalAddress<BloomFilter> self, size_t nblocks, int k)
+    : self(self), bits(nblocks * WORDS_PER_BLOCK, 0), nblocks(nblocks), k(k) {}
+
+  // words [begin,end) of the slice reduced by core `c`
+  std::pair<size_t,size_t> slice(Core c) const {
+    size_t n = bits.size();
+    return std::make_pair(n * c / cores(), n * (c + 1) / cores());
+  }
+
+  // send words [begin,end) of the local replica to core `c`, ORed in there
+  // (or copied, once reduced)
+  void send_words(Core c, size_t begin, size_t end, bool copy) {
+    auto self = this->self;
+    bloom_replication_bytes += (end - begin) * sizeof(uint64_t);
+    sender.send(c, bits.data() + begin, end - begin,
+                [self,begin,copy](const uint64_t * words, size_t n, size_t offset){
+      auto w = self->bits.data() + begin + offset;
+      for (size_t j = 0; j < n; j++) w[j] = copy ? words[j] : (w[j] | words[j]);
+    });
+  }
+
+public:
+  /// Create an empty filter sized for `expected_keys` at `bits_per_key`
+  /// bits each; `k` (bits set per key) defaults to the usual optimum.
+  static GlobalAddress<BloomFilter> create(size_t expected_keys, double bits_per_key = 10.0, int k = 0) {
+    size_t nbits = std::max<size_t>(512, std::ceil(expected_keys * bits_per_key));
+    size_t nblocks = (nbits + 511) / 512;
+    if (k <= 0) k = std::max(1, std::min(7, int(std::round(bits_per_key * std::log(2.0)))));
+    CHECK_LE(k, 7) << "at most 7 bits per key (9 hash bits each from one 64-bit hash)";
+
+    auto f = symmetric_global_alloc<BloomFilter>();
+    on_all_cores([f,nblocks,k]{ new (f.localize()) BloomFilter(f, nblocks, k); });
+    return f;
+  }
+
+  void destroy() {
+    auto self = this->self;
+    on_all_cores([self]{ self->~BloomFilter(); });
+    global_free(self);
+  }
+
+  /// Add `key` to this core's replica (visible everywhere after `replicate`).
+  void insert(const K& key) {
+    uint64_t h = mix64(Hash()(key));
+    uint64_t * block = &bits[((h >> 32) * nblocks >> 32) * WORDS_PER_BLOCK];
+    uint64_t g = mix64(h);
+    for (int i = 0; i < k; i++, g >>= 9) {
+      block[(g & 511) >> 6] |= 1ULL << (g & 63);
+    }
+    bloom_inserts++;
+  }
+
+  /// False only if `key` was never inserted (checks the local replica).
+  bool may_contain(const K& key) const {
+    uint64_t h = mix64(Hash()(key));
+    const uint64_t * block = &bits[((h >> 32) * nblocks >> 32) * WORDS_PER_BLOCK];
+    uint64_t g = mix64(h);
+    bloom_checks++;
+    for (int i = 0; i < k; i++, g >>= 9) {
+      if (!(block[(g & 511) >> 6] & (1ULL << (g & 63)))) {
+        bloom_rejects++;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// OR every core's replica together, leaving the union on all cores.
+  void replicate() {
+    auto self = this->self;
+    if (cores() == 1) return;
+    // reduce-scatter: send each core the slice it owns
+    on_all_cores([self]{
+      for (Core c = 0; c < cores(); c++) if (c != mycore()) {
+        auto s = self->slice(c);
+        self->send_words(c, s.first, s.second, false);
+      }
+      self->sender.wait();
+    });
+    // all-gather: each core broadcasts its reduced slice
+    on_all_cores([self]{
+      auto s = self->slice(mycore());
+      for (Core c = 0; c < cores(); c++) if (c != mycore()) {
+        self->send_words(c, s.first, s.second, true);
+      }
+      self->sender.wait();
+    });
+  }
+
+  /// Insert `key_of(t)` for every element of a global array, in parallel,
+  /// then replicate.
+  template< typename T, typename F >
+  void build(GlobalAddress<T> base, size_t n, F key_of) {
+    auto self = this->self;
+    forall(base, n, [self,key_of](T& t){ self->insert(key_of(t)); });
+    replicate();
+  }
+
+  /// Fraction of bits set (for estimating the false-positive rate).
+  double fill() const {
+    size_t set = 0;
+    for (auto w : bits) set += __builtin_popcountll(w);
+    return double(set) / (bits.size() * 64);
+  }
+
+  size_t bytes() const { return bits.size() * sizeof(uint64_t); }
+} GRAPPA_BLOCK_ALIGNED;
+
+} // namespace Grappa
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <BloomFilter.hpp>
+
+BOOST_AUTO_TEST_SUITE( BloomFilter_tests );
+
+using namespace Grappa;
+
+DEFINE_int64(bloom_keys, 100000, "Number of keys inserted in the filter.");
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t n = FLAGS_bloom_keys;
+    auto keys = global_alloc<int64_t>(n);
+    forall(keys, n, [](int64_t i, int64_t& k){ k = 2*i; });
+
+    auto f = BloomFilter<int64_t>::create(n);
+    f->build(keys, n, [](int64_t& k){ return k; });
+
+    // no false negatives, on any core
+    on_all_cores([f,n]{
+      for (int64_t i = 0; i < n; i++) CHECK(f->may_contain(2*i));
+    });
+
+    // odd keys were never inserted: a few false positives at most
+    on_all_cores([]{ Metrics::reset(); });
+    forall(keys, n, [f](int64_t& k){ f->may_contain(k+1); });
+    auto checks = sum_all_cores([]{ return bloom_checks.value(); });
+    auto rejects = sum_all_cores([]{ return bloom_rejects.value(); });
+    BOOST_CHECK_EQUAL(checks, n);
+    double fp = 1.0 - double(rejects) / checks;
+    BOOST_MESSAGE("false positive rate: " << fp << ", fill: " << f->fill());
+    BOOST_CHECK_LT(fp, 0.03);
+
+    f->destroy();
+    global_free(keys);
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -126,6 +126,28 @@ namespace Grappa {
     }
     
     virtual void merge_all(impl::MetricBase* static_stat_ptr);
+
+    virtual void pack(std::string& out) const {
+      T v = is_merged_ ? merging_value_ : value();
+      impl::pack_value(out, v);
+    }
+    
+    virtual const char* merge_packed(const char* in) {
+      T v;
+      in = impl::unpack_value(in, &v);
+      if (!is_merged_) {
+        // switch to value mode, starting from this core's own value
+        T mine = value();
+        start_merging();
+        merging_value_ = mine;
+      }
+      merging_value_ += v;
+      return in;
+    }
+    
+    virtual std::string type_name() const {
+      return std::string("CallbackMetric<") + impl::metric_value_type<T>() + ">";
+    }
   
     };
     /// @}
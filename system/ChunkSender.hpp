@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Addressing.hpp"
+#include "CompletionEvent.hpp"
+#include "ConditionVariableLocal.hpp"
+#include "SharedMessagePool.hpp"
+
+#include <algorithm>
+
+namespace Grappa {
+  
+  /// @addtogroup Communication
+  /// @{
+  
+  /// Sends arrays of items to other cores in chunks of up to `Bytes` bytes,
+  /// one message per chunk, and counts the chunks until their destinations
+  /// acknowledge them. At most `max_inflight` chunks may be unacknowledged
+  /// at once (0 for no limit); `wait()` blocks on a CompletionEvent until
+  /// all have been. Items are copied into the messages as bytes, as for
+  /// message captures.
+  ///
+  /// Acknowledgements are addressed to the sender itself, so it must stay
+  /// in place until `wait()` returns: usually it is a member of a symmetric
+  /// object, or a local of the sending task.
+  ///
+  /// @b Example:
+  /// @code
+  ///   ChunkSender sender(64);
+  ///   sender.send(dest, vals.data(), vals.size(),
+  ///               [](const int64_t * v, size_t n, size_t offset){ ... });
+  ///   sender.wait();
+  /// @endcode
+  class ChunkSender {
+    CompletionEvent acked;     // counts chunks not yet acknowledged
+    ConditionVariable window;  // signaled as each chunk is acknowledged
+    int64_t max_inflight;
+    
+    void acknowledge() {
+      acked.complete();
+      signal(&window);
+    }
+    
+  public:
+    template< typename T, size_t Bytes >
+    struct Chunk {
+      static const size_t capacity = sizeof(T) >= Bytes ? 1 : Bytes / sizeof(T);
+      size_t offset;  // position of items[0] in the array sent
+      size_t n;
+      T items[capacity];
+    };
+    
+    /// Acknowledges one chunk to its sender when called (once) on the
+    /// chunk's destination core.
+    class Ack {
+      GlobalAddress<ChunkSender> sender;
+    public:
+      Ack(GlobalAddress<ChunkSender> sender): sender(sender) {}
+      
+      void operator()() const {
+        auto s = sender;
+        if (s.core() == mycore()) {
+          s.pointer()->acknowledge();
+        } else {
+          send_heap_message(s.core(), [s]{ s.pointer()->acknowledge(); });
+        }
+      }
+    };
+    
+    explicit ChunkSender(int64_t max_inflight = 0): acked(0), max_inflight(max_inflight) {}
+    
+    /// Send `items[0..n)` to core `dest`. On `dest`, each chunk is handed to
+    /// `f(items, count, offset, ack)` in a message handler (so `f` must not
+    /// block), where `offset` is the position of its first item in
+    /// `items`; `f` must call `ack()` once it is done with the chunk, which
+    /// may be later, from another task.
+    template< size_t Bytes = 1024, typename T, typename F >
+    void send_with_ack(Core dest, const T * items, size_t n, F f) {
+      auto self = make_global(this);
+      for (size_t i = 0; i < n; i += Chunk<T,Bytes>::capacity) {
+        Chunk<T,Bytes> chunk;
+        chunk.offset = i;
+        chunk.n = std::min(Chunk<T,Bytes>::capacity, n - i);
+        std::copy(items + i, items + i + chunk.n, chunk.items);
+        while (max_inflight > 0 && acked.get_count() >= max_inflight) Grappa::wait(&window);
+        acked.enroll();
+        send_heap_message(dest, [self,chunk,f]{
+          f(chunk.items, chunk.n, chunk.offset, Ack(self));
+        });
+      }
+    }
+    
+    /// Send `items[0..n)` to core `dest`. On `dest`, each chunk is handed to
+    /// `f(items, count, offset)` in a message handler (so `f` must not
+    /// block), where `offset` is the position of its first item in
+    /// `items`, and acknowledged when `f` returns.
+    template< size_t Bytes = 1024, typename T, typename F >
+    void send(Core dest, const T * items, size_t n, F f) {
+      send_with_ack<Bytes>(dest, items, n, [f](const T * items, size_t count, size_t offset, Ack ack){
+        f(items, count, offset);
+        ack();
+      });
+    }
+    
+    /// Number of chunks sent but not yet acknowledged.
+    int64_t inflight() const { return acked.get_count(); }
+    
+    /// Block until every chunk sent so far has been acknowledged.
+    void wait() { acked.wait(); }
+  };
+  
+  /// @}
+  
+} // namespace Grappa
@@ -35,3 +35,9 @@
 #include "Collective.hpp"
 #include "Delegate.hpp"
 
+DEFINE_int64(alltoallv_max_inflight, 64, "Maximum payload messages each core may have in flight in alltoallv");
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, alltoallv_calls, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, alltoallv_messages, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, alltoallv_bytes, 0);
+
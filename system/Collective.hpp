@@ -42,13 +42,24 @@
 #include "CountingSemaphoreLocal.hpp"
 #include "Barrier.hpp"
 #include "MessagePool.hpp"
+#include "LocaleSharedMemory.hpp"
+#include "Metrics.hpp"
 
+#include <gflags/gflags.h>
 #include <functional>
 #include <algorithm>
+#include <cstring>
+#include <vector>
 
 // TODO/FIXME: use actual max message size (have Communicator be able to tell us)
 const size_t MAX_MESSAGE_SIZE = 3192;
 
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, alltoallv_calls);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, alltoallv_messages);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, alltoallv_bytes);
+
+DECLARE_int64(alltoallv_max_inflight);
+
 #define COLL_MAX &collective_max
 #define COLL_MIN &collective_min
 #define COLL_ADD &collective_add
@@ -498,6 +509,170 @@ namespace Grappa {
     return total;
   }
   
+  namespace impl {
+    
+    /// Per-core state of the `alltoallv` in progress on elements of type T.
+    template< typename T >
+    struct AllToAllV {
+      T * recv;
+      std::vector<size_t> recv_counts;   // by source core
+      std::vector<int64_t> send_displs;  // by destination: where our part starts there (-1 until known)
+      Core counts_in;
+      Core displs_in;
+      size_t received;                   // elements delivered into `recv`
+      int64_t inflight;                  // payload messages not yet acknowledged
+      std::vector<size_t> free_slots;    // staging slots whose piece was acknowledged
+      
+      static AllToAllV& get() {
+        static AllToAllV state;
+        return state;
+      }
+    };
+    
+  } // namespace impl
+  
+  /// Called from SPMD context: bulk exchange of variable-size blocks between
+  /// all pairs of cores. Each core passes `send`, holding `send_counts[c]`
+  /// elements for each core `c` in core order. Afterwards `recv` holds
+  /// everything sent to this core, grouped by source core in core order;
+  /// if `recv_counts` is given, it gets the number of elements from each.
+  ///
+  /// Runs in three phases: counts are exchanged, each receiver scans them
+  /// into offsets and sizes `recv` once, then sends each source where its
+  /// block goes. Payload then goes out in message-sized pieces, at most
+  /// --alltoallv_max_inflight at a time per core, and is copied into place
+  /// on arrival. Each piece is staged in a slot of locale shared memory
+  /// (where message payloads must live), reused once the piece has been
+  /// acknowledged, so besides `recv` each core needs at most
+  /// --alltoallv_max_inflight * MAX_MESSAGE_SIZE bytes of locale memory,
+  /// however much it sends. Elements are copied as bytes, as for message
+  /// captures.
+  ///
+  /// @warning Only one alltoallv per element type may be in progress at a
+  ///          time, as it uses a function-private static state object.
+  ///
+  /// @b Example (route values to the core that owns them):
+  /// @code
+  ///   on_all_cores([]{
+  ///     std::vector<int64_t> out;             // local values, grouped by owner core
+  ///     std::vector<size_t> counts(cores());  // number of values for each owner
+  ///     // ... fill out and counts ...
+  ///     std::vector<int64_t> in;
+  ///     alltoallv(out.data(), counts.data(), in);  // values this core owns
+  ///   });
+  /// @endcode
+  template< typename T >
+  void alltoallv(const T * send, const size_t * send_counts, std::vector<T>& recv,
+                 size_t * recv_counts = nullptr) {
+    static_assert(sizeof(T) <= MAX_MESSAGE_SIZE, "alltoallv elements must fit in a message");
+    typedef impl::AllToAllV<T> State;
+    auto& s = State::get();
+    Core me = mycore();
+    Core n = cores();
+    
+    s.recv = nullptr;
+    s.recv_counts.assign(n, 0);
+    s.send_displs.assign(n, -1);
+    s.counts_in = 0;
+    s.displs_in = 0;
+    s.received = 0;
+    s.inflight = 0;
+    s.free_slots.clear();
+    alltoallv_calls++;
+    
+    // make sure every core has reset its state before messages arrive
+    barrier();
+    
+    // counts: tell each core how much to expect from us
+    for (Core c = 0; c < n; c++) {
+      size_t count = send_counts[c];
+      send_heap_message(c, [me,count]{
+        auto& s = State::get();
+        s.recv_counts[me] = count;
+        s.counts_in++;
+      });
+    }
+    while (s.counts_in < n) yield();
+    
+    // scan: lay sources out in core order, and tell each where its block starts
+    size_t total = 0;
+    std::vector<size_t> displs(n);
+    for (Core c = 0; c < n; c++) {
+      displs[c] = total;
+      total += s.recv_counts[c];
+    }
+    recv.resize(total);
+    s.recv = recv.data();
+    for (Core c = 0; c < n; c++) {
+      int64_t displ = displs[c];
+      send_heap_message(c, [me,displ]{
+        auto& s = State::get();
+        s.send_displs[me] = displ;
+        s.displs_in++;
+      });
+    }
+    
+    // payload: stream each block as soon as its destination is ready,
+    // starting at a different destination on each core
+    std::vector<size_t> send_offsets(n);
+    for (Core c = 1; c < n; c++) send_offsets[c] = send_offsets[c-1] + send_counts[c-1];
+    const size_t per_msg = MAX_MESSAGE_SIZE / sizeof(T);
+    size_t npieces = 0;
+    for (Core c = 0; c < n; c++) {
+      if (c != me) npieces += (send_counts[c] + per_msg - 1) / per_msg;
+    }
+    size_t nslots = std::min<size_t>(npieces, std::max<int64_t>(FLAGS_alltoallv_max_inflight, 1));
+    T * staged = nslots > 0 ? locale_alloc<T>(nslots * per_msg) : nullptr;
+    for (size_t i = nslots; i > 0; i--) s.free_slots.push_back(i - 1);
+    std::vector<bool> sent(n, false);
+    Core nsent = 0;
+    while (nsent < n) {
+      for (Core i = 0; i < n; i++) {
+        Core c = (me + i) % n;
+        if (sent[c] || s.send_displs[c] < 0) continue;
+        const T * block = send + send_offsets[c];
+        size_t count = send_counts[c];
+        size_t displ = s.send_displs[c];
+        if (c == me) {
+          ::memcpy(s.recv + displ, block, count * sizeof(T));
+          s.received += count;
+        } else {
+          for (size_t k = 0; k < count; k += per_msg) {
+            size_t m = std::min(per_msg, count - k);
+            while (s.free_slots.empty()) yield();
+            size_t slot = s.free_slots.back();
+            s.free_slots.pop_back();
+            T * piece = staged + slot * per_msg;
+            ::memcpy(piece, block + k, m * sizeof(T));
+            s.inflight++;
+            alltoallv_messages++;
+            alltoallv_bytes += m * sizeof(T);
+            size_t at = displ + k;
+            send_heap_message(c, [me,at,slot](void * payload, size_t size){
+              auto& s = State::get();
+              ::memcpy(s.recv + at, payload, size);
+              s.received += size / sizeof(T);
+              send_heap_message(me, [slot]{
+                auto& s = State::get();
+                s.free_slots.push_back(slot);
+                s.inflight--;
+              });
+            }, (void*)piece, m * sizeof(T));
+          }
+        }
+        sent[c] = true;
+        nsent++;
+      }
+      if (nsent < n) yield();
+    }
+    
+    // a slot must stay untouched until its piece has been delivered
+    while (s.inflight > 0 || s.received < total) yield();
+    if (staged) locale_free(staged);
+    
+    if (recv_counts) std::copy(s.recv_counts.begin(), s.recv_counts.end(), recv_counts);
+  }
+  
   /// @}
 } // namespace Grappa
 
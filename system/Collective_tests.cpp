@@ -117,6 +117,39 @@ BOOST_AUTO_TEST_CASE( test1 ) {
     auto total = Grappa::sum_all_cores([]{ return global_x; });
     CHECK_EQ(total, cores());
     
+    BOOST_MESSAGE("testing alltoallv");
+    Grappa::on_all_cores([]{
+      // block sizes vary by pair, some empty, some spanning many messages
+      auto count = [](Core src, Core dst) -> size_t { return ((src + 2*dst) % 3) * 1500; };
+      auto value = [](Core src, Core dst, size_t i) -> int64_t { return src * 1000000000L + dst * 1000000L + i; };
+      
+      auto max_inflight = FLAGS_alltoallv_max_inflight;
+      for (int round = 0; round < 2; round++) {
+        // second round: a two-piece window, so staging slots are reused
+        if (round == 1) FLAGS_alltoallv_max_inflight = 2;
+        std::vector<size_t> send_counts(cores());
+        std::vector<int64_t> send;
+        for (Core d = 0; d < cores(); d++) {
+          send_counts[d] = count(mycore(), d);
+          for (size_t i = 0; i < send_counts[d]; i++) send.push_back(value(mycore(), d, i));
+        }
+        
+        std::vector<int64_t> recv;
+        std::vector<size_t> recv_counts(cores());
+        Grappa::alltoallv(send.data(), send_counts.data(), recv, recv_counts.data());
+        
+        size_t k = 0;
+        for (Core src = 0; src < cores(); src++) {
+          BOOST_CHECK_EQUAL(recv_counts[src], count(src, mycore()));
+          for (size_t i = 0; i < count(src, mycore()); i++, k++) {
+            CHECK_EQ(recv[k], value(src, mycore(), i));
+          }
+        }
+        BOOST_CHECK_EQUAL(recv.size(), k);
+      }
+      FLAGS_alltoallv_max_inflight = max_inflight;
+    });
+    
   });
   Grappa::finalize();
 }
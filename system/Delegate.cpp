@@ -52,6 +52,9 @@ GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, delegate_roundtrip_latency, 0.0)
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, delegate_network_latency, 0.0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, delegate_wakeup_latency, 0.0);
 
+GRAPPA_DEFINE_METRIC(LatencyHistogram, delegate_roundtrip_latency_histogram, 4);
+GRAPPA_DEFINE_METRIC(LatencyHistogram, delegate_network_latency_histogram, 4);
+
 GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, delegate_ops, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, delegate_targets, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, delegate_reads, 0);
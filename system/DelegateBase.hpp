@@ -45,6 +45,9 @@ GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, delegate_roundtrip_latency);
 GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, delegate_network_latency);
 GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, delegate_wakeup_latency);
 
+GRAPPA_DECLARE_METRIC(LatencyHistogram, delegate_roundtrip_latency_histogram);
+GRAPPA_DECLARE_METRIC(LatencyHistogram, delegate_network_latency_histogram);
+
 GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, delegate_ops);
 GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, delegate_targets);
 
@@ -55,6 +58,7 @@ namespace Grappa {
     inline void record_network_latency(int64_t start_time) {
       auto latency = Grappa::timestamp() - start_time;
       delegate_network_latency += latency;
+      delegate_network_latency_histogram.record(latency);
     }
 
     inline void record_wakeup_latency(int64_t start_time, int64_t network_time) {
@@ -62,6 +66,7 @@ namespace Grappa {
       auto blocked_time = current_time - start_time;
       auto wakeup_latency = current_time - network_time;
       delegate_roundtrip_latency += blocked_time;
+      delegate_roundtrip_latency_histogram.record(blocked_time);
       delegate_wakeup_latency += wakeup_latency;
     }
     
@@ -72,7 +72,7 @@ private:
   // release data at pointer in local heap
   /// (should be called only on node responsible for allocator)
   void local_free( GlobalAddress< void > address ) {
-    void * va = reinterpret_cast< void * >( address.raw_bits() );
+    void * va = reinterpret_cast< void * >( address.linear_offset() );
     a_p_->free( va );
   }
 
@@ -153,6 +153,41 @@ GlobalAddress<T> global_alloc(size_t count) {
   return static_cast<GlobalAddress<T>>(GlobalAllocator::remote_malloc(sizeof(T)*count));
 }
 
+/// Allocate `count` T's from the global shared heap, distributed
+/// block-cyclically in blocks of (at least) `block_bytes` bytes instead
+/// of the default `block_size`. Larger blocks keep neighboring elements
+/// on the same core, so range loops and bulk transfers need fewer
+/// messages. The block size is rounded up to one the address can
+/// encode that holds a whole number of T's (see `block_bytes()` on the
+/// returned address); `localize()`, `forall` and address arithmetic work
+/// as usual, and the result is freed with `global_free`.
+template< typename T = int8_t >
+GlobalAddress<T> global_alloc(size_t count, size_t block_bytes) {
+  CHECK_GT(count, 0) << "allocation must be greater than 0";
+  size_t bs = impl::round_block_bytes(block_bytes);
+  while (bs % sizeof(T) != 0) bs = impl::round_block_bytes(bs+1);
+  if (bs == block_size) return global_alloc<T>(count);
+  
+  // aligning the allocation to a whole row of blocks makes each core's
+  // part occupy the same local range it would with the default blocks
+  size_t row = bs * cores();
+  size_t nbytes = (sizeof(T)*count + row - 1) / row * row;
+  // buddy chunks are only aligned to powers of 2
+  size_t request = (row & (row-1)) ? nbytes + row : nbytes;
+  
+  auto a = GlobalAllocator::remote_malloc(request);
+  intptr_t offset = (a.raw_bits() + row - 1) / row * row;
+  return GlobalAddress<T>::Raw(offset | (impl::encode_block_bytes(bs) << block_field_shift_val));
+}
+
+/// Allocate `count` T's with a pure block distribution: each core gets
+/// one contiguous run of about count/cores() elements.
+template< typename T = int8_t >
+GlobalAddress<T> global_alloc_blocked(size_t count) {
+  size_t per_core = (count + cores() - 1) / cores();
+  return global_alloc<T>(count, per_core * sizeof(T));
+}
+
 /// Free memory allocated from global shared heap.
 template< typename T >
 void global_free(GlobalAddress<T> address) {
@@ -113,6 +113,11 @@ namespace Grappa {
       // call_on_all_cores([this]{ if (log_initialized) log.flush(); });
 #endif
     }
+    
+    // samples live in the per-core histogram logs, nothing to merge
+    virtual void pack(std::string& out) const { }
+    virtual const char* merge_packed(const char* in) { return in; }
+    virtual std::string type_name() const { return "HistogramMetric"; }
 
     /// Get the current value
     inline int64_t value() const { return value_; }
@@ -45,6 +45,7 @@ GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, acquire_blocked, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<uint64_t>, acquire_blocked_ticks_total, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<uint64_t>, acquire_network_ticks_total, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<uint64_t>, acquire_wakeup_ticks_total, 0);
+GRAPPA_DEFINE_METRIC(LatencyHistogram, acquire_network_ticks_histogram, 4);
 
     
 void IAMetrics::count_acquire_ams( uint64_t bytes ) {
@@ -65,5 +66,6 @@ void IAMetrics::record_network_latency( int64_t start_time ) {
   int64_t current_time = Grappa::timestamp();
   int64_t latency = current_time - start_time;
   acquire_network_ticks_total += latency;
+  acquire_network_ticks_histogram.record(latency);
 }
 
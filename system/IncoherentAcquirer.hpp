@@ -130,7 +130,7 @@ public:
       DVLOG(5) << " address + count block max is " << (*request_address_ + *count_).block_max();
       DVLOG(5) << " address block min " << request_address_->block_min();
       DVLOG(5) << "Straddle: diff is " << byte_diff << " bs " << block_size;
-      num_messages_ = byte_diff / block_size;
+      num_messages_ = transfer_message_count( request_address_->first_byte(), *count_ * sizeof(T) );
     }
 
     if( num_messages_ > 1 ) DVLOG(5) << "****************************** MULTI BLOCK CACHE REQUEST ******************************";
@@ -172,12 +172,7 @@ public:
          args.offset < total_bytes; 
          args.offset += args.request_bytes, i++) {
 
-      args.request_bytes = args.request_address.first_byte().block_max() - args.request_address.first_byte();
-
-
-      if( args.request_bytes > total_bytes - args.offset ) {
-        args.request_bytes = total_bytes - args.offset;
-      }
+      args.request_bytes = transfer_bytes( args.request_address.first_byte(), total_bytes - args.offset );
 
       DVLOG(5) << "sending acquire request for " << args.request_bytes
                << " of total bytes = " << *count_ * sizeof(T)
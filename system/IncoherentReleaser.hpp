@@ -115,7 +115,7 @@ public:
       DVLOG(5) << " multiplied difference is " << ( (*request_address_ + *count_ - 1).block_max() - request_address_->block_min() ) * sizeof(T);
       DVLOG(5) << " address block min " << request_address_->block_min();
       DVLOG(5) << "Straddle: diff is " << byte_diff << " bs " << block_size;
-      num_messages_ = byte_diff / block_size;
+      num_messages_ = transfer_message_count( request_address_->first_byte(), *count_ * sizeof(T) );
     }
 
     if( num_messages_ > 1 ) DVLOG(5) << "****************************** MULTI BLOCK CACHE REQUEST ******************************";
@@ -159,11 +159,7 @@ public:
          offset < total_bytes; 
          offset += request_bytes, i++) {
 
-      request_bytes = args.request_address.first_byte().block_max() - args.request_address.first_byte();
-
-      if( request_bytes > total_bytes - offset ) {
-        request_bytes = total_bytes - offset;
-      }
+      request_bytes = transfer_bytes( args.request_address.first_byte(), total_bytes - offset );
 
       DVLOG(5) << "sending release request with " << request_bytes
                << " of total bytes = " << *count_ * sizeof(T)
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include "LatencyHistogram.hpp"
+#include "Communicator.hpp"
+#include "Addressing.hpp"
+#include "Message.hpp"
+#include "CompletionEvent.hpp"
+
+namespace Grappa {
+
+  namespace impl {
+    /// Non-empty buckets of one core's LatencyHistogram, shipped to the merging core.
+    struct LatencyHistogramChunk {
+      static const int capacity = 32;
+      uint16_t nchunks;   ///< total chunks the source core is sending
+      uint16_t nentries;
+      uint16_t index[capacity];
+      uint64_t count[capacity];
+      uint64_t n;
+      double sum;
+      int64_t min;
+      int64_t max;
+    };
+  }
+
+  void LatencyHistogram::merge_all(impl::MetricBase* static_stat_ptr) {
+    reset();
+
+    LatencyHistogram* this_static = reinterpret_cast<LatencyHistogram*>(static_stat_ptr);
+    GlobalAddress<LatencyHistogram> combined_addr = make_global(this);
+
+    // each core sends a variable number of chunks; count them down per core and
+    // complete once per core when its last chunk arrives
+    std::vector<int> remaining(Grappa::cores(), -1);
+    auto remaining_ptr = &remaining[0];
+
+    CompletionEvent ce(Grappa::cores());
+    auto ce_ptr = &ce;
+
+    for (Core c = 0; c < Grappa::cores(); c++) {
+      // pointers to globals are the same on all cores
+      GlobalAddress<LatencyHistogram> remote_stat = make_global(this_static, c);
+
+      send_heap_message(c, [remote_stat, combined_addr, remaining_ptr, ce_ptr] {
+        LatencyHistogram* s = remote_stat.pointer();
+        Core src = Grappa::mycore();
+
+        size_t nonzero = 0;
+        for (auto& x : s->counts) if (x != 0) nonzero++;
+        const int cap = impl::LatencyHistogramChunk::capacity;
+        uint16_t nchunks = std::max<size_t>(1, (nonzero + cap - 1) / cap);
+
+        impl::LatencyHistogramChunk chunk;
+        chunk.nchunks = nchunks;
+        chunk.n = s->n; chunk.sum = s->sum; chunk.min = s->min; chunk.max = s->max;
+
+        size_t i = 0;
+        for (uint16_t k = 0; k < nchunks; k++) {
+          chunk.nentries = 0;
+          for (; i < s->counts.size() && chunk.nentries < cap; i++) {
+            if (s->counts[i] != 0) {
+              chunk.index[chunk.nentries] = i;
+              chunk.count[chunk.nentries] = s->counts[i];
+              chunk.nentries++;
+            }
+          }
+          // only the first chunk carries the summary, so it is folded in exactly once
+          if (k > 0) chunk.n = 0;
+
+          send_heap_message(combined_addr.core(), [combined_addr, remaining_ptr, ce_ptr, src, chunk] {
+            LatencyHistogram* combined_ptr = combined_addr.pointer();
+            for (int j = 0; j < chunk.nentries; j++) {
+              combined_ptr->counts[chunk.index[j]] += chunk.count[j];
+            }
+            combined_ptr->merge_summary(chunk.n, chunk.sum, chunk.min, chunk.max);
+
+            if (remaining_ptr[src] < 0) remaining_ptr[src] = chunk.nchunks;
+            if (--remaining_ptr[src] == 0) ce_ptr->complete();
+          });
+        }
+      });
+    }
+    ce.wait();
+  }
+
+}
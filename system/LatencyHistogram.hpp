@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MetricBase.hpp"
+#include <glog/logging.h>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+namespace Grappa {
+  /// @addtogroup Utility
+  /// @{
+
+  /// Log-linear ("HDR-style") histogram of non-negative values, typically latencies in
+  /// ticks. Each power-of-two range is split into 2^precision linear sub-buckets, so
+  /// any recorded value is reported with a relative error of at most 2^-precision.
+  ///
+  /// Recording is a couple of bit operations and an increment on the local core's
+  /// bucket array; histograms from all cores are merged bucket-by-bucket when metrics
+  /// are merged, and percentiles (p50/p90/p99/p999) are printed in the stats blob.
+  ///
+  /// @b Example:
+  /// @code
+  ///   GRAPPA_DEFINE_METRIC(LatencyHistogram, my_latency, 4); // ~6% precision
+  ///   ...
+  ///   my_latency.record( Grappa::timestamp() - start );
+  /// @endcode
+  class LatencyHistogram : public impl::MetricBase {
+  protected:
+    int precision;
+    std::vector<uint64_t> counts;
+    uint64_t n;
+    double sum;
+    int64_t min;
+    int64_t max;
+
+    inline size_t index_of( int64_t v ) const {
+      uint64_t u = v < 0 ? 0 : v;
+      const uint64_t sub = 1UL << precision;
+      if( u < sub ) return u;
+      int e = 63 - __builtin_clzll(u);   // index of highest set bit (>= precision)
+      int shift = e - precision;
+      return ((shift + 1) << precision) + ((u >> shift) & (sub - 1));
+    }
+
+    /// smallest value that lands in bucket `i`
+    inline int64_t lowest_value( size_t i ) const {
+      const size_t sub = 1UL << precision;
+      if( i < sub ) return i;
+      int shift = (i >> precision) - 1;
+      return static_cast<int64_t>( (sub + (i & (sub - 1))) << shift );
+    }
+
+    /// largest value that lands in bucket `i`
+    inline int64_t highest_value( size_t i ) const {
+      const size_t sub = 1UL << precision;
+      if( i < sub ) return i;
+      int shift = (i >> precision) - 1;
+      return lowest_value(i) + ((int64_t(1) << shift) - 1);
+    }
+
+    static size_t nbuckets_for( int precision ) {
+      return static_cast<size_t>(64 - precision + 1) << precision;
+    }
+
+    /// fold another core's summary into this one (used by merge_all)
+    inline void merge_summary( uint64_t o_n, double o_sum, int64_t o_min, int64_t o_max ) {
+      if( o_n == 0 ) return;
+      if( n == 0 ) {
+        min = o_min;
+        max = o_max;
+      } else {
+        if( o_min < min ) min = o_min;
+        if( o_max > max ) max = o_max;
+      }
+      n += o_n;
+      sum += o_sum;
+    }
+
+  public:
+
+    /// @param precision  number of sub-bucket bits per power of two (1-7)
+    LatencyHistogram(const char * name, int precision, bool reg_new = true)
+      : impl::MetricBase(name, reg_new)
+      , precision(precision)
+      , counts(nbuckets_for(precision), 0)
+      , n(0)
+      , sum(0)
+      , min(0)
+      , max(0)
+    {
+      CHECK( precision >= 1 && precision <= 7 ) << "LatencyHistogram precision must be in [1,7]";
+    }
+
+    LatencyHistogram(const LatencyHistogram& h)
+      : impl::MetricBase(h.name, false)
+      , precision(h.precision)
+      , counts(h.counts)
+      , n(h.n)
+      , sum(h.sum)
+      , min(h.min)
+      , max(h.max)
+    { }
+
+    /// Record one value (negative values are clamped to 0).
+    inline void record( int64_t v ) {
+      if( v < 0 ) v = 0;
+      counts[ index_of(v) ]++;
+      if( n == 0 ) {
+        min = max = v;
+      } else {
+        if( v < min ) min = v;
+        if( v > max ) max = v;
+      }
+      n++;
+      sum += v;
+    }
+
+    inline LatencyHistogram& operator+=( int64_t v ) { record(v); return *this; }
+
+    inline uint64_t count() const { return n; }
+    inline double mean() const { return n ? sum / n : 0.0; }
+    inline int64_t minimum() const { return min; }
+    inline int64_t maximum() const { return max; }
+
+    /// Value at or below which `p` percent of recorded values fall (0 < p <= 100).
+    /// Reported as the highest value equivalent to the bucket it falls in (clamped to
+    /// the largest value recorded), so it is never an under-estimate.
+    int64_t percentile( double p ) const {
+      if( n == 0 ) return 0;
+      uint64_t target = static_cast<uint64_t>( p / 100.0 * n + 0.5 );
+      if( target < 1 ) target = 1;
+      if( target > n ) target = n;
+      uint64_t seen = 0;
+      for( size_t i = 0; i < counts.size(); i++ ) {
+        seen += counts[i];
+        if( seen >= target ) return std::min( highest_value(i), max );
+      }
+      return max;
+    }
+
+    virtual std::ostream& json(std::ostream& o) const {
+      o << '"' << name << "_count\": " << n << ", ";
+      o << '"' << name << "_mean\": " << mean() << ", ";
+      o << '"' << name << "_min\": " << min << ", ";
+      o << '"' << name << "_p50\": " << percentile(50) << ", ";
+      o << '"' << name << "_p90\": " << percentile(90) << ", ";
+      o << '"' << name << "_p99\": " << percentile(99) << ", ";
+      o << '"' << name << "_p999\": " << percentile(99.9) << ", ";
+      o << '"' << name << "_max\": " << max;
+      return o;
+    }
+
+    virtual void reset() {
+      std::fill( counts.begin(), counts.end(), 0 );
+      n = 0;
+      sum = 0;
+      min = max = 0;
+    }
+
+    virtual void sample() { }
+
+    virtual LatencyHistogram* clone() const {
+      return new LatencyHistogram( *this );
+    }
+
+    virtual void merge_all(impl::MetricBase* static_stat_ptr);
+
+    /// sparse encoding: summary, then (index, count) for each non-empty bucket
+    virtual void pack(std::string& out) const {
+      uint32_t nonzero = 0;
+      for (auto& x : counts) if (x != 0) nonzero++;
+      impl::pack_value(out, n);
+      impl::pack_value(out, sum);
+      impl::pack_value(out, min);
+      impl::pack_value(out, max);
+      impl::pack_value(out, nonzero);
+      for (uint16_t i = 0; i < counts.size(); i++) {
+        if (counts[i] != 0) {
+          impl::pack_value(out, i);
+          impl::pack_value(out, counts[i]);
+        }
+      }
+    }
+
+    virtual const char* merge_packed(const char* in) {
+      uint64_t o_n; double o_sum; int64_t o_min, o_max; uint32_t nonzero;
+      in = impl::unpack_value(in, &o_n);
+      in = impl::unpack_value(in, &o_sum);
+      in = impl::unpack_value(in, &o_min);
+      in = impl::unpack_value(in, &o_max);
+      in = impl::unpack_value(in, &nonzero);
+      for (uint32_t j = 0; j < nonzero; j++) {
+        uint16_t i; uint64_t c;
+        in = impl::unpack_value(in, &i);
+        in = impl::unpack_value(in, &c);
+        counts[i] += c;
+      }
+      merge_summary(o_n, o_sum, o_min, o_max);
+      return in;
+    }
+
+    /// precision is part of the type so offline decoding uses the same bucket layout
+    virtual std::string type_name() const {
+      return "LatencyHistogram<" + std::to_string(precision) + ">";
+    }
+  };
+
+  /// @}
+} // namespace Grappa
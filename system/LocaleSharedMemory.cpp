@@ -42,6 +42,8 @@ DEFINE_double( locale_user_heap_fraction, 0.1, "Fraction of locale shared memory
 
 DEFINE_double( global_heap_fraction, 0.25, "Fraction of locale shared memory to set aside for global shared heap" );
 
+DEFINE_bool( locale_shared_cache, true, "Serve small locale shared memory allocations from per-core size-class caches instead of the locked shared heap" );
+
 DECLARE_int64( node_memsize );
 DECLARE_bool( global_memory_use_hugepages );
 
@@ -101,6 +103,13 @@ void LocaleSharedMemory::create() {
     failure_function();
     throw;
   }
+
+  // shared state for size-class caches
+  span_count = segment.get_size() / SizeClassCache::span_size + 1;
+  span_classes = segment.construct<uint8_t>("SizeClassSpans")[span_count](0);
+  remote_frees = segment.construct<SizeClassCache::RemoteFreeList>("SizeClassRemoteFrees")
+    [ Grappa::locale_cores() * SizeClassCache::nclasses ]();
+
   VLOG(2) << "Created LocaleSharedMemory region " << region_name 
           << " with " << region_size << " bytes"
           << " on " << global_communicator.mycore 
@@ -128,6 +137,14 @@ void LocaleSharedMemory::attach() {
     failure_function();
     throw;
   }
+
+  auto spans = segment.find<uint8_t>("SizeClassSpans");
+  CHECK( spans.first ) << "Size-class span table missing from locale shared memory";
+  span_classes = spans.first;
+  span_count = spans.second;
+  remote_frees = segment.find<SizeClassCache::RemoteFreeList>("SizeClassRemoteFrees").first;
+  CHECK( remote_frees ) << "Size-class remote free lists missing from locale shared memory";
+
   VLOG(2) << "Attached to LocaleSharedMemory region " << region_name 
           << " on " << global_communicator.mycore 
           << " of " << global_communicator.cores;
@@ -154,7 +171,20 @@ LocaleSharedMemory::LocaleSharedMemory()
   , base_address( reinterpret_cast<void*>( 0x400000000000L ) )
   , segment() // default constructor; initialize later
   , allocated(0)
+  , span_classes(nullptr)
+  , span_count(0)
+  , remote_frees(nullptr)
+  , cache_stats()
 { 
+  for( int c = 0; c < SizeClassCache::nclasses; ++c ) {
+    available_spans[c] = nullptr;
+  }
+  int c = 0;
+  for( size_t i = 0; i <= SizeClassCache::max_size / 16; ++i ) {
+    while( SizeClassCache::class_sizes[c] < i * 16 ) ++c;
+    class_for_size[i] = c;
+  }
+
   boost::interprocess::shared_memory_object::remove( region_name.c_str() );
 
   // TODO: figure out reasonable region size
@@ -190,6 +220,11 @@ void LocaleSharedMemory::finish() {
 }
 
 void * LocaleSharedMemory::allocate( size_t size ) {
+  if( FLAGS_locale_shared_cache && span_classes && size <= SizeClassCache::max_size ) {
+    allocated += size;
+    return cache_allocate( class_for_size[ (size + 15) / 16 ] );
+  }
+
   void * p = NULL;
   try {
     p = segment.allocate( size );
@@ -206,6 +241,13 @@ void * LocaleSharedMemory::allocate( size_t size ) {
 }
 
 void * LocaleSharedMemory::allocate_aligned( size_t size, size_t alignment ) {
+  // objects of classes >= 64 bytes are 64-byte aligned; smaller ones are 16-byte aligned
+  if( FLAGS_locale_shared_cache && span_classes && size <= SizeClassCache::max_size && alignment <= 64 ) {
+    allocated += size;
+    size_t class_size = ( alignment > 16 && size < 64 ) ? 64 : size;
+    return cache_allocate( class_for_size[ (class_size + 15) / 16 ] );
+  }
+
   void * p = NULL;
   try {
     p = segment.allocate_aligned( size, alignment );
@@ -222,6 +264,12 @@ void * LocaleSharedMemory::allocate_aligned( size_t size, size_t alignment ) {
 }
 
 void LocaleSharedMemory::deallocate( void * ptr ) {
+  // check spans even when caching is disabled, in case it was turned off at runtime
+  if( auto s = span_of( ptr ) ) {
+    cache_deallocate( s, ptr );
+    return;
+  }
+
   try {
     segment.deallocate( ptr );
   }
@@ -234,6 +282,120 @@ void LocaleSharedMemory::deallocate( void * ptr ) {
 }
 
 
+void LocaleSharedMemory::cache_link( SizeClassCache::Span * s ) {
+  auto& head = available_spans[ s->size_class ];
+  s->prev = nullptr;
+  s->next = head;
+  if( head ) head->prev = s;
+  head = s;
+  s->available = true;
+}
+
+void LocaleSharedMemory::cache_unlink( SizeClassCache::Span * s ) {
+  if( s->prev ) s->prev->next = s->next;
+  else available_spans[ s->size_class ] = s->next;
+  if( s->next ) s->next->prev = s->prev;
+  s->prev = s->next = nullptr;
+  s->available = false;
+}
+
+SizeClassCache::Span * LocaleSharedMemory::cache_new_span( int size_class ) {
+  void * p = NULL;
+  try {
+    p = segment.allocate_aligned( SizeClassCache::span_size, SizeClassCache::span_size );
+  }
+  catch(...){
+    LOG(ERROR) << "Allocation of size class span failed with "
+               << get_free_memory() << " free and "
+               << allocated << " allocated locally";
+    failure_function();
+    throw;
+  }
+
+  auto s = reinterpret_cast<SizeClassCache::Span*>( p );
+  s->owner = Grappa::locale_mycore();
+  s->size_class = size_class;
+  s->live = 0;
+
+  // thread all objects onto the free list, in address order
+  size_t sz = SizeClassCache::class_sizes[ size_class ];
+  char * first = reinterpret_cast<char*>( p ) + SizeClassCache::span_header_size;
+  char * end = reinterpret_cast<char*>( p ) + SizeClassCache::span_size;
+  s->free = nullptr;
+  for( size_t i = (end - first) / sz; i > 0; --i ) {
+    char * o = first + (i-1) * sz;
+    *reinterpret_cast<void**>( o ) = s->free;
+    s->free = o;
+  }
+
+  size_t index = ( reinterpret_cast<char*>(p) - reinterpret_cast<char*>(base_address) ) / SizeClassCache::span_size;
+  CHECK_LT( index, span_count );
+  span_classes[ index ] = size_class + 1;
+  cache_stats.spans_allocated++;
+
+  cache_link( s );
+  return s;
+}
+
+void LocaleSharedMemory::cache_collect_remote( int size_class ) {
+  auto& list = remote_frees[ Grappa::locale_mycore() * SizeClassCache::nclasses + size_class ];
+  void * p = list.head.exchange( nullptr, std::memory_order_acquire );
+  while( p ) {
+    void * next = *reinterpret_cast<void**>( p );
+    cache_free_local( span_of( p ), p );
+    cache_stats.remote_collected++;
+    p = next;
+  }
+}
+
+void * LocaleSharedMemory::cache_allocate( int size_class ) {
+  auto s = available_spans[ size_class ];
+  if( !s ) {
+    cache_collect_remote( size_class );
+    s = available_spans[ size_class ];
+  }
+  if( !s ) {
+    s = cache_new_span( size_class );
+  }
+
+  void * p = s->free;
+  s->free = *reinterpret_cast<void**>( p );
+  s->live++;
+  if( !s->free ) cache_unlink( s );
+  cache_stats.allocs++;
+  return p;
+}
+
+void LocaleSharedMemory::cache_free_local( SizeClassCache::Span * s, void * ptr ) {
+  *reinterpret_cast<void**>( ptr ) = s->free;
+  s->free = ptr;
+  s->live--;
+  if( !s->available ) cache_link( s );
+
+  // release empty spans, but keep one around so alternating alloc/free doesn't thrash
+  if( s->live == 0 && ( s->prev || s->next ) ) {
+    cache_unlink( s );
+    size_t index = ( reinterpret_cast<char*>(s) - reinterpret_cast<char*>(base_address) ) / SizeClassCache::span_size;
+    span_classes[ index ] = 0;
+    segment.deallocate( s );
+    cache_stats.spans_released++;
+  }
+}
+
+void LocaleSharedMemory::cache_deallocate( SizeClassCache::Span * s, void * ptr ) {
+  if( s->owner == static_cast<uint32_t>( Grappa::locale_mycore() ) ) {
+    cache_free_local( s, ptr );
+  } else {
+    auto& list = remote_frees[ s->owner * SizeClassCache::nclasses + s->size_class ];
+    void * head = list.head.load( std::memory_order_relaxed );
+    do {
+      *reinterpret_cast<void**>( ptr ) = head;
+    } while( !list.head.compare_exchange_weak( head, ptr, std::memory_order_release,
+                                               std::memory_order_relaxed ) );
+    cache_stats.remote_frees++;
+  }
+}
+
 
 } // namespace impl
 } // namespace Grappa
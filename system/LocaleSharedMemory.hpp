@@ -40,6 +40,7 @@
 #include <glog/logging.h>
 
 #include <string>
+#include <atomic>
 
 #include <boost/interprocess/managed_shared_memory.hpp>
 
@@ -48,6 +49,45 @@
 namespace Grappa {
 namespace impl {
 
+/// Size-class caching for small locale shared heap allocations.
+///
+/// Allocating from the boost segment takes an interprocess mutex shared
+/// by every core on the locale. Instead, small requests are rounded up to
+/// one of a few size classes and served from 64KB spans, each carved from
+/// the segment in one allocation and owned by a single core. The owner
+/// allocates from and frees to a span's free list without synchronization;
+/// other cores free by pushing onto a lock-free list per (owner, class)
+/// in shared memory, which the owner collects when it runs out of free
+/// objects. Fully free spans are returned to the segment, keeping at most
+/// one empty span per class.
+namespace SizeClassCache {
+  const size_t span_size = 1 << 16;
+  const size_t span_header_size = 64;
+  const size_t max_size = 4096;
+  const int nclasses = 14;
+  const size_t class_sizes[nclasses] = { 16, 32, 64, 128, 192, 256, 384, 512,
+                                         768, 1024, 1536, 2048, 3072, 4096 };
+  
+  /// Header at the start of each span. Objects start at span_header_size,
+  /// so objects of classes >= 64 bytes are cache-line aligned.
+  struct Span {
+    uint32_t owner;          ///< locale core that carved this span
+    uint32_t size_class;
+    void * free;             ///< owner's free list
+    Span * prev;             ///< in owner's list of spans with free objects
+    Span * next;
+    int64_t live;            ///< objects handed out (including remote frees not yet collected)
+    bool available;          ///< on owner's list of spans with free objects
+  };
+  static_assert( sizeof(Span) <= span_header_size, "span header too large" );
+  
+  /// Objects freed by other cores, waiting for the owner to collect them.
+  struct RemoteFreeList {
+    std::atomic<void*> head;
+    RemoteFreeList(): head(nullptr) {}
+  };
+}
+
 class LocaleSharedMemory {
 private:
   size_t region_size;
@@ -56,10 +96,37 @@ private:
   
   size_t allocated;
 
+  /// Per-span size class + 1 (0 if not a span), shared by the locale.
+  uint8_t * span_classes;
+  size_t span_count;
+  /// [locale core][size class] lists of remotely-freed objects, shared by the locale.
+  SizeClassCache::RemoteFreeList * remote_frees;
+  /// This core's spans with free objects, by size class.
+  SizeClassCache::Span * available_spans[ SizeClassCache::nclasses ];
+  uint8_t class_for_size[ SizeClassCache::max_size / 16 + 1 ];
+
   void create();
   void attach();
   void unlink();
 
+  void * cache_allocate( int size_class );
+  void cache_deallocate( SizeClassCache::Span * s, void * ptr );
+  void cache_free_local( SizeClassCache::Span * s, void * ptr );
+  void cache_collect_remote( int size_class );
+  SizeClassCache::Span * cache_new_span( int size_class );
+  void cache_link( SizeClassCache::Span * s );
+  void cache_unlink( SizeClassCache::Span * s );
+
+  /// Span containing `ptr`, or nullptr if it wasn't allocated from a span.
+  inline SizeClassCache::Span * span_of( void * ptr ) {
+    if( !span_classes ) return nullptr;
+    uintptr_t offset = reinterpret_cast<char*>(ptr) - reinterpret_cast<char*>(base_address);
+    size_t index = offset / SizeClassCache::span_size;
+    if( index >= span_count || span_classes[index] == 0 ) return nullptr;
+    return reinterpret_cast<SizeClassCache::Span*>( reinterpret_cast<char*>(base_address)
+                                                    + index * SizeClassCache::span_size );
+  }
+
   friend class RDMAAggregator;
 
 public: // TODO: fix Gups
@@ -96,6 +163,15 @@ public:
   const size_t get_free_memory() const { return segment.get_free_memory(); }
   const size_t get_size() const { return segment.get_size(); }
   const size_t get_allocated() const { return allocated; }
+
+  /// Size-class cache statistics for this core.
+  struct CacheStats {
+    int64_t allocs;           ///< allocations served from spans
+    int64_t spans_allocated;  ///< spans carved from the segment
+    int64_t spans_released;   ///< empty spans returned to the segment
+    int64_t remote_frees;     ///< objects this core freed to other cores' spans
+    int64_t remote_collected; ///< objects other cores freed to this core's spans
+  } cache_stats;
 };
 
 
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+/// Measures locale shared heap allocation rate with 1 to all cores of each
+/// locale allocating at once, with and without the size-class cache
+/// (--locale_shared_cache), for local frees and for frees by another core.
+
+#include "Grappa.hpp"
+#include "Metrics.hpp"
+#include "LocaleSharedMemory.hpp"
+
+DEFINE_int64( bench_allocs, 1 << 20, "Number of allocations per active core" );
+DEFINE_int64( bench_batch, 64, "Number of allocations outstanding before they are freed" );
+DEFINE_int64( bench_size, 128, "Bytes per allocation" );
+
+DECLARE_bool( locale_shared_cache );
+
+using namespace Grappa;
+
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, locale_alloc_bench_cached_rate, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, locale_alloc_bench_uncached_rate, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, locale_alloc_bench_cached_remote_rate, 0 );
+GRAPPA_DEFINE_METRIC( SimpleMetric<double>, locale_alloc_bench_uncached_remote_rate, 0 );
+
+/// Allocations per second across the system with `active` cores per locale
+/// allocating. With `remote`, each batch is freed by the next active core.
+double alloc_rate( int active, bool remote ) {
+  auto start = walltime();
+  on_all_cores([active,remote]{
+    if( locale_mycore() >= active ) return;
+    Core next = mylocale() * locale_cores() + (locale_mycore() + 1) % active;
+    int64_t nbatch = FLAGS_bench_batch;
+    auto batch = locale_alloc<void*>( nbatch );
+    
+    for( int64_t i = 0; i < FLAGS_bench_allocs; i += nbatch ) {
+      for( int64_t j = 0; j < nbatch; ++j ) {
+        batch[j] = locale_alloc( FLAGS_bench_size );
+      }
+      auto free_batch = [batch,nbatch]{
+        for( int64_t j = 0; j < nbatch; ++j ) locale_free( batch[j] );
+      };
+      if( remote ) delegate::call( next, free_batch );
+      else free_batch();
+    }
+    
+    locale_free( batch );
+  });
+  double t = walltime() - start;
+  return active * locales() * FLAGS_bench_allocs / t;
+}
+
+int main(int argc, char* argv[]) {
+  init(&argc, &argv);
+  run([]{
+    std::vector<int> actives;
+    for( int a = 1; a < locale_cores(); a *= 2 ) actives.push_back( a );
+    actives.push_back( locale_cores() );
+    
+    for( bool remote : { false, true } ) {
+      for( int active : actives ) {
+        for( bool cached : { true, false } ) {
+          call_on_all_cores([cached]{ FLAGS_locale_shared_cache = cached; });
+          double rate = alloc_rate( active, remote );
+          if( active == locale_cores() ) {
+            if( remote ) {
+              (cached ? locale_alloc_bench_cached_remote_rate : locale_alloc_bench_uncached_remote_rate) = rate;
+            } else {
+              (cached ? locale_alloc_bench_cached_rate : locale_alloc_bench_uncached_rate) = rate;
+            }
+          }
+          LOG(INFO) << (cached ? "cached" : "uncached") << (remote ? ", remote free" : ", local free")
+                    << ", " << active << " of " << locale_cores() << " cores per locale: "
+                    << rate << " allocs/s";
+        }
+      }
+    }
+    call_on_all_cores([]{ FLAGS_locale_shared_cache = true; });
+    
+    Metrics::merge_and_print();
+  });
+  finalize();
+}
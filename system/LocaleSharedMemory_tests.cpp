@@ -40,6 +40,9 @@
 #include "Grappa.hpp"
 #include "LocaleSharedMemory.hpp"
 #include "ParallelLoop.hpp"
+#include "Delegate.hpp"
+
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE( LocaleSharedMemory_tests );
 
@@ -75,6 +78,63 @@ BOOST_AUTO_TEST_CASE( test1 ) {
         BOOST_CHECK_EQUAL( arr[ Grappa::locale_mycore() ], other_index );
       });
 
+    LOG(INFO) << "Checking size-class cache";
+    Grappa::on_all_cores( [] {
+        auto& lsm = Grappa::impl::locale_shared_memory;
+        struct Chunk { char * p; size_t size; int fill; };
+        std::vector< Chunk > cs;
+        for( size_t sz : { 1, 8, 16, 17, 63, 64, 100, 1000, 4096, 4097, 100000 } ) {
+          for( size_t align : { 8, 16, 64 } ) {
+            for( int i = 0; i < 100; ++i ) {
+              auto p = static_cast<char*>( lsm.allocate_aligned( sz, align ) );
+              BOOST_CHECK_EQUAL( reinterpret_cast<uintptr_t>(p) % align, 0 );
+              cs.push_back( Chunk{ p, sz, static_cast<int>(cs.size() % 251) } );
+            }
+          }
+          cs.push_back( Chunk{ static_cast<char*>( lsm.allocate( sz ) ), sz, static_cast<int>(cs.size() % 251) } );
+        }
+        // make sure nothing overlaps
+        for( auto& c : cs ) memset( c.p, c.fill, c.size );
+        for( auto& c : cs ) {
+          for( size_t j = 0; j < c.size; ++j ) BOOST_CHECK_EQUAL( c.p[j], static_cast<char>(c.fill) );
+        }
+        for( auto& c : cs ) lsm.deallocate( c.p );
+        BOOST_CHECK_GT( lsm.cache_stats.allocs, 0 );
+        BOOST_CHECK_GT( lsm.cache_stats.spans_allocated, 0 );
+      });
+
+    LOG(INFO) << "Checking cross-core frees";
+    Grappa::on_all_cores( [] {
+        auto& lsm = Grappa::impl::locale_shared_memory;
+        // two spans' worth of the largest size class
+        const int n = 30;
+        const size_t sz = 4096;
+        auto ps = Grappa::locale_alloc<int64_t*>( n );
+        for( int i = 0; i < n; ++i ) {
+          ps[i] = static_cast<int64_t*>( Grappa::locale_alloc( sz ) );
+          ps[i][0] = i;
+        }
+        // free them from the next core on this locale
+        Grappa::Core next = Grappa::mylocale() * Grappa::locale_cores()
+                            + (Grappa::locale_mycore() + 1) % Grappa::locale_cores();
+        Grappa::delegate::call( next, [ps] {
+            for( int i = 0; i < n; ++i ) {
+              BOOST_CHECK_EQUAL( ps[i][0], i );
+              Grappa::locale_free( ps[i] );
+            }
+          });
+        Grappa::locale_free( ps );
+        Grappa::barrier();
+        BOOST_CHECK_GE( lsm.cache_stats.remote_frees, n );
+        
+        // remote frees are reclaimed once the size class runs dry
+        auto collected = lsm.cache_stats.remote_collected;
+        std::vector<void*> qs;
+        for( int i = 0; i < 2*n; ++i ) qs.push_back( Grappa::locale_alloc( sz ) );
+        for( auto q : qs ) Grappa::locale_free( q );
+        BOOST_CHECK_GE( lsm.cache_stats.remote_collected - collected, n );
+      });
+
     LOG(INFO) << "Done";
   });
   Grappa::finalize();
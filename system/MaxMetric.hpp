@@ -103,6 +103,21 @@ namespace Grappa {
     
     virtual void merge_all(impl::MetricBase* static_stat_ptr);
 
+    virtual void pack(std::string& out) const {
+      impl::pack_value(out, value_);
+    }
+    
+    virtual const char* merge_packed(const char* in) {
+      T v;
+      in = impl::unpack_value(in, &v);
+      add(v);
+      return in;
+    }
+    
+    virtual std::string type_name() const {
+      return std::string("MaxMetric<") + impl::metric_value_type<T>() + ">";
+    }
+
     inline const MaxMetric<T>& count() { return (*this)++; }
 
     /// Get the current value
@@ -35,6 +35,9 @@
 #pragma once
 
 #include <ostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
 
 namespace Grappa {
   namespace impl {
@@ -47,6 +50,9 @@ namespace Grappa {
       /// registers stat with global stats vector by default (reg_new=false to disable)
       MetricBase(const char * name, bool reg_new = true);
       
+      /// clones made by clone() are deleted through MetricBase pointers
+      virtual ~MetricBase() {}
+      
       /// prints as a JSON entry
       virtual std::ostream& json(std::ostream&) const = 0;
       
@@ -62,7 +68,40 @@ namespace Grappa {
       
       /// create new copy of the class of the right instance (needed so we can create new copies of stats from their MetricBase pointer
       virtual MetricBase* clone() const = 0;
+      
+      /// append a compact binary encoding of this stat's value to `out`
+      /// (used for tree merging, binary stats dumps and the sample ring buffer)
+      virtual void pack(std::string& out) const = 0;
+      
+      /// fold a value encoded by `pack` (usually on another core) into this stat,
+      /// returning a pointer just past the bytes consumed
+      virtual const char* merge_packed(const char* in) = 0;
+      
+      /// type name recorded in binary dumps so they can be decoded offline (see impl::make_metric)
+      virtual std::string type_name() const = 0;
+      
+      const char * metric_name() const { return name; }
     };
     
+    /// raw (memcpy) encoding helpers for `pack`/`merge_packed`
+    template< typename T >
+    inline void pack_value(std::string& out, const T& v) {
+      out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    template< typename T >
+    inline const char* unpack_value(const char* in, T* v) {
+      std::memcpy(v, in, sizeof(T));
+      return in + sizeof(T);
+    }
+    
+    /// name of the value type used in `type_name()` strings
+    template< typename T > inline const char* metric_value_type() { return "unknown"; }
+    template<> inline const char* metric_value_type<int>()           { return "int"; }
+    template<> inline const char* metric_value_type<unsigned>()      { return "unsigned"; }
+    template<> inline const char* metric_value_type<long>()          { return "int64_t"; }
+    template<> inline const char* metric_value_type<unsigned long>() { return "uint64_t"; }
+    template<> inline const char* metric_value_type<double>()        { return "double"; }
+    template<> inline const char* metric_value_type<float>()         { return "float"; }
+    
   }
 }
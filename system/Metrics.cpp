@@ -42,6 +42,8 @@
 #include <sstream>
 #include <cstdint>
 #include "Collective.hpp"
+#include "HistogramMetric.hpp"
+#include <map>
 #include <boost/filesystem.hpp>
 namespace fs = boost::filesystem;
 
@@ -49,6 +51,12 @@ namespace fs = boost::filesystem;
 DEFINE_int64( stats_blob_ticks, 300000000000L, "number of ticks to wait before dumping stats blob");
 DEFINE_string( stats_blob_filename, "stats.json", "Stats blob filename" );
 DEFINE_bool( stats_blob_enable, true, "Enable stats dumping" );
+DEFINE_string( stats_blob_format, "json", "Format of stats blob: 'json', or 'binary' (decode with metrics_convert.exe)" );
+
+DEFINE_int64( metrics_merge_fanout, 8, "Fan-out of the tree used to merge metrics from all cores (0: every core sends each metric straight to the root)" );
+
+DEFINE_int64( metrics_ring_samples, 0, "Number of periodic metric samples each core keeps in a local ring buffer (0 disables)" );
+DEFINE_int64( metrics_ring_ticks, 1000000000L, "Ticks between samples taken into the metrics ring buffer" );
 
 
 DECLARE_string(stats_blob_filename);
@@ -115,6 +123,113 @@ namespace Grappa {
     // which profiling phase are we in? 
     static int profiler_phase = 0;
     
+    ///
+    /// Binary stats format. A header followed by a descriptor (name, type_name()) per
+    /// metric, then a sequence of records, each holding every metric's `pack()`ed value:
+    ///
+    ///   "GRPMETR1" | u32 core | u32 ncores | u32 nmetrics | descriptors | records...
+    ///   descriptor: u16 len, name, u16 len, type
+    ///   record:     i64 timestamp, u32 nbytes, packed values
+    ///
+    /// Merged dumps contain one record; ring buffer dumps one per sample.
+    ///
+    const char binary_magic[8] = { 'G','R','P','M','E','T','R','1' };
+    
+    void write_binary_header(std::ostream& o, MetricList& stats, Core core) {
+      std::string h(binary_magic, sizeof(binary_magic));
+      pack_value(h, static_cast<uint32_t>(core));
+      pack_value(h, static_cast<uint32_t>(cores()));
+      pack_value(h, static_cast<uint32_t>(stats.size()));
+      for (auto* s : stats) {
+        std::string name(s->metric_name()), type(s->type_name());
+        pack_value(h, static_cast<uint16_t>(name.size())); h += name;
+        pack_value(h, static_cast<uint16_t>(type.size())); h += type;
+      }
+      o.write(h.data(), h.size());
+    }
+    
+    void write_binary_record(std::ostream& o, int64_t timestamp, const std::string& packed) {
+      uint32_t nbytes = packed.size();
+      o.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+      o.write(reinterpret_cast<const char*>(&nbytes), sizeof(nbytes));
+      o.write(packed.data(), nbytes);
+    }
+    
+    template< typename T > T zero_callback() { return 0; }
+    
+    template< typename T >
+    MetricBase* make_numeric_metric(const std::string& kind, const char * name) {
+      if (kind == "SimpleMetric")      return new SimpleMetric<T>(name, 0, false);
+      if (kind == "SummarizingMetric") return new SummarizingMetric<T>(name, 0, false);
+      if (kind == "MaxMetric")         return new MaxMetric<T>(name, std::numeric_limits<T>::lowest(), false);
+      if (kind == "CallbackMetric")    return new CallbackMetric<T>(name, &zero_callback<T>, false);
+      return nullptr;
+    }
+    
+    MetricBase* make_metric(const std::string& type, const char * name) {
+      if (type == "StringMetric") return new StringMetric(name, "", false);
+      if (type == "HistogramMetric") return new HistogramMetric(name, 0, false);
+      
+      auto lt = type.find('<');
+      if (lt == std::string::npos || type.back() != '>') return nullptr;
+      std::string kind = type.substr(0, lt);
+      std::string arg = type.substr(lt+1, type.size()-lt-2);
+      
+      if (kind == "LatencyHistogram") return new LatencyHistogram(name, std::stoi(arg), false);
+      if (arg == "int")      return make_numeric_metric<int>(kind, name);
+      if (arg == "unsigned") return make_numeric_metric<unsigned>(kind, name);
+      if (arg == "int64_t")  return make_numeric_metric<int64_t>(kind, name);
+      if (arg == "uint64_t") return make_numeric_metric<uint64_t>(kind, name);
+      if (arg == "double")   return make_numeric_metric<double>(kind, name);
+      if (arg == "float")    return make_numeric_metric<float>(kind, name);
+      return nullptr;
+    }
+    
+    void pack_all(std::string& out, MetricList& stats) {
+      uint32_t n = stats.size();
+      pack_value(out, n);
+      for (auto* s : stats) s->pack(out);
+    }
+    
+    void merge_packed_all(MetricList& stats, const std::string& in) {
+      uint32_t n;
+      const char * p = unpack_value(in.data(), &n);
+      CHECK_EQ( n, stats.size() ) << "cores registered different sets of metrics";
+      for (auto* s : stats) p = s->merge_packed(p);
+      CHECK_EQ( p, in.data() + in.size() );
+    }
+    
+    /// Per-core state for tree-merging metrics (see Metrics::merge).
+    struct MetricsTreeMerge {
+      MetricList partial;                        ///< this core's stats merged with its subtree's
+      std::map<Core,std::string> from_children;  ///< packed partial merges, reassembled
+      std::map<Core,size_t> bytes_received;
+      CompletionEvent children_done;
+    };
+    MetricsTreeMerge tree_merge;
+    
+    /// Slice of a core's packed partial merge, sent to its parent in the tree.
+    struct MetricsTreeChunk {
+      static const size_t capacity = 2048;
+      uint32_t offset;
+      uint32_t total;
+      uint32_t len;
+      char data[capacity];
+    };
+    
+    /// Per-core ring buffer of packed samples of all registered metrics.
+    struct MetricsRing {
+      std::vector<std::string> samples;
+      std::vector<int64_t> timestamps;
+      size_t next = 0;
+      size_t count = 0;
+    };
+    MetricsRing metrics_ring;
+    
+    int64_t metrics_ring_sample_ticks() {
+      return (FLAGS_metrics_ring_samples > 0) ? FLAGS_metrics_ring_ticks : 0;
+    }
+    
     /// Get next filename for profiler files
     char * get_next_profiler_filename( ) {
       // use Slurm environment variables if we can
@@ -140,12 +255,76 @@ namespace Grappa {
     void merge(MetricList& result) {
       result.clear(); // ensure it's empty
       
+      if (FLAGS_metrics_merge_fanout > 0) {
+        merge_tree(result, FLAGS_metrics_merge_fanout);
+        return;
+      }
+      
       for (Grappa::impl::MetricBase * local_stat : Grappa::impl::registered_stats()) {
         Grappa::impl::MetricBase* merge_target = local_stat->clone();
         result.push_back(merge_target); // slot for merged stat
         merge_target->merge_all(local_stat);
       }
     }
+    
+    void merge_tree(MetricList& result, int64_t fanout) {
+      result.clear();
+      CHECK_GT( fanout, 0 );
+      Core root = mycore();
+      
+      // set up every core's partial merge before anyone starts sending to its parent
+      call_on_all_cores([root,fanout]{
+        auto& t = impl::tree_merge;
+        t.partial.clear();
+        for (auto* s : impl::registered_stats()) t.partial.push_back(s->clone());
+        
+        Core rank = (mycore() - root + cores()) % cores();
+        int64_t nchildren = 0;
+        for (int64_t i = 1; i <= fanout; i++) if (rank*fanout + i < cores()) nchildren++;
+        t.children_done.enroll(nchildren);
+      });
+      
+      on_all_cores([root,fanout]{
+        auto& t = impl::tree_merge;
+        t.children_done.wait();
+        
+        for (auto& kv : t.from_children) impl::merge_packed_all(t.partial, kv.second);
+        t.from_children.clear();
+        t.bytes_received.clear();
+        
+        if (mycore() == root) return;
+        
+        Core rank = (mycore() - root + cores()) % cores();
+        Core parent = ((rank - 1) / fanout + root) % cores();
+        Core src = mycore();
+        
+        std::string packed;
+        impl::pack_all(packed, t.partial);
+        for (auto* s : t.partial) delete s;
+        t.partial.clear();
+        
+        impl::MetricsTreeChunk chunk;
+        chunk.total = packed.size();
+        for (size_t off = 0; off < packed.size(); off += chunk.len) {
+          chunk.offset = off;
+          size_t capacity = impl::MetricsTreeChunk::capacity;
+          chunk.len = std::min(capacity, packed.size() - off);
+          std::memcpy(chunk.data, packed.data() + off, chunk.len);
+          
+          send_heap_message(parent, [src,chunk]{
+            auto& t = impl::tree_merge;
+            auto& buf = t.from_children[src];
+            buf.resize(chunk.total);
+            std::memcpy(&buf[chunk.offset], chunk.data, chunk.len);
+            if ((t.bytes_received[src] += chunk.len) == chunk.total) {
+              t.children_done.complete();
+            }
+          });
+        }
+      });
+      
+      result.swap(impl::tree_merge.partial);
+    }
 
     void print(std::ostream& out, MetricList& stats, const std::string& legacy_stats) {
       std::ostringstream o;
@@ -171,17 +350,63 @@ namespace Grappa {
       MetricList all;
       merge(all); // also flushes histogram logs
 
-      std::ofstream of( FLAGS_stats_blob_filename.c_str(), std::ios::out );
-      print(of, all, "");
+      if (FLAGS_stats_blob_format == "binary") {
+        dump_binary(FLAGS_stats_blob_filename, all);
+      } else {
+        std::ofstream of( FLAGS_stats_blob_filename.c_str(), std::ios::out );
+        print(of, all, "");
+      }
+      for (auto* s : all) delete s;
     }
     
     void dump_stats_blob() {
       if( FLAGS_stats_blob_enable ) {
-        MetricList all;
-        merge(all); // also flushes histogram logs
-
-        std::ofstream o( FLAGS_stats_blob_filename.c_str(), std::ios::out );
-        print( o, all, "");
+        merge_and_dump_to_file();
+      }
+      if( FLAGS_metrics_ring_samples > 0 ) {
+        on_all_cores([]{ dump_ring_here(); });
+      }
+    }
+    
+    void dump_binary(const std::string& filename, MetricList& stats) {
+      std::string packed;
+      impl::pack_all(packed, stats);
+      
+      std::ofstream o( filename.c_str(), std::ios::out | std::ios::binary );
+      impl::write_binary_header(o, stats, mycore());
+      impl::write_binary_record(o, Grappa::timestamp(), packed);
+    }
+    
+    void ring_sample(int64_t timestamp) {
+      auto& r = impl::metrics_ring;
+      if (r.samples.size() != static_cast<size_t>(FLAGS_metrics_ring_samples)) {
+        r.samples.resize(FLAGS_metrics_ring_samples);
+        r.timestamps.resize(FLAGS_metrics_ring_samples);
+        r.next = r.count = 0;
+      }
+      // reuse the slot's storage, so steady-state sampling doesn't allocate
+      auto& slot = r.samples[r.next];
+      slot.clear();
+      impl::pack_all(slot, impl::registered_stats());
+      r.timestamps[r.next] = timestamp;
+      r.next = (r.next + 1) % r.samples.size();
+      if (r.count < r.samples.size()) r.count++;
+    }
+    
+    void dump_ring_here() {
+      auto& r = impl::metrics_ring;
+      if (r.count == 0) return;
+      
+      std::ostringstream fname;
+      fname << FLAGS_stats_blob_filename << ".ring." << mycore() << ".bin";
+      std::ofstream o( fname.str().c_str(), std::ios::out | std::ios::binary );
+      impl::write_binary_header(o, impl::registered_stats(), mycore());
+      
+      // oldest first
+      size_t first = (r.next + r.samples.size() - r.count) % r.samples.size();
+      for (size_t k = 0; k < r.count; k++) {
+        size_t i = (first + k) % r.samples.size();
+        impl::write_binary_record(o, r.timestamps[i], r.samples[i]);
       }
     }
 
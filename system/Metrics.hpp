@@ -43,6 +43,7 @@
 #include "SummarizingMetric.hpp"
 #include "CallbackMetric.hpp"
 #include "MaxMetric.hpp"
+#include "LatencyHistogram.hpp"
 
 /// @addtogroup Utility
 /// @{
@@ -57,6 +58,21 @@ namespace Grappa {
     
     extern bool take_tracing_sample;
     void set_exe_name( char * name );
+    
+    /// Ticks between local samples into the metrics ring buffer (0 if disabled).
+    int64_t metrics_ring_sample_ticks();
+    
+    /// Create an unregistered metric from a `type_name()` string (used to decode binary dumps).
+    /// Returns nullptr for unknown types.
+    MetricBase* make_metric(const std::string& type, const char * name);
+    
+    /// Append the packed values of all metrics in `stats` to `out`.
+    void pack_all(std::string& out, MetricList& stats);
+    
+    /// Fold values produced by `pack_all` into `stats`.
+    void merge_packed_all(MetricList& stats, const std::string& in);
+    
+    extern const char binary_magic[8];
   }
   
   namespace Metrics {
@@ -67,9 +83,19 @@ namespace Grappa {
     void print(std::ostream& out = std::cerr, MetricList& stats = Grappa::impl::registered_stats(), const std::string& legacy_stats = "");
     
     /// Merge registered stats from all cores into `result` list.
+    /// Uses `merge_tree` unless `--metrics_merge_fanout=0`, in which case each stat
+    /// is gathered from every core directly by this core.
     /// @param result   must be a clone of a core's impl::registered_stats().
     void merge(MetricList& result);
     
+    /// Merge registered stats up a `fanout`-ary tree of cores rooted at this core: each
+    /// core folds its children's packed partial results into its own clones and sends one
+    /// packed blob to its parent, so no core receives more than `fanout` messages per chunk.
+    /// Fills `result` with newly-allocated merged stats.
+    ///
+    /// @warning Uses per-core static state; only one tree merge may be in flight at a time.
+    void merge_tree(MetricList& result, int64_t fanout);
+    
     /// Create clone of stats list, merge all stats into it, and print them.
     void merge_and_print(std::ostream& out = std::cerr);
     
@@ -79,6 +105,16 @@ namespace Grappa {
     /// Dump local registered stats to file.
     void dump_stats_blob();
     
+    /// Write `stats` in the compact binary format to `filename` (decode with metrics_convert.exe).
+    void dump_binary(const std::string& filename, MetricList& stats);
+    
+    /// Pack all local registered stats into this core's ring buffer (no communication).
+    /// Called by the scheduler every `--metrics_ring_ticks` when `--metrics_ring_samples` > 0.
+    void ring_sample(int64_t timestamp);
+    
+    /// Write this core's ring buffer to '<stats_blob_filename>.ring.<core>.bin'.
+    void dump_ring_here();
+    
     /// Sample all local registered stats
     void sample();
     
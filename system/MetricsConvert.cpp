@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+/// Offline converter for binary metrics dumps (`--stats_blob_format=binary` and
+/// the per-core sample ring buffers written with `--metrics_ring_samples`).
+///
+/// Usage:
+///   metrics_convert.exe [--format=json|csv] <file.bin>
+///
+/// JSON output is one `STATS{...}STATS` object per record (as printed by Metrics::print,
+/// plus the record's "timestamp"). CSV output has a header of field names and one row per
+/// record, which is convenient for plotting ring-buffer time series.
+///
+/// Does not start the Grappa runtime; it only uses the metric classes to decode values.
+
+#include "Metrics.hpp"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <deque>
+
+DEFINE_string( format, "json", "Output format: 'json' or 'csv'" );
+
+using namespace Grappa;
+
+template< typename T >
+static T read_value(std::istream& in) {
+  T v;
+  in.read(reinterpret_cast<char*>(&v), sizeof(T));
+  CHECK( in ) << "truncated metrics file";
+  return v;
+}
+
+static std::string read_string(std::istream& in) {
+  auto len = read_value<uint16_t>(in);
+  std::string s(len, '\0');
+  in.read(&s[0], len);
+  CHECK( in ) << "truncated metrics file";
+  return s;
+}
+
+/// split a metric's JSON fragment (`"a": 1, "a_b": 2`) into keys and values
+static void split_fields(const std::string& frag,
+                         std::vector<std::string>& keys, std::vector<std::string>& values) {
+  size_t pos = 0;
+  while ((pos = frag.find('"', pos)) != std::string::npos) {
+    size_t kend = frag.find("\": ", pos+1);
+    if (kend == std::string::npos) break;
+    size_t vend = frag.find(", \"", kend);
+    if (vend == std::string::npos) vend = frag.size();
+    keys.push_back(frag.substr(pos+1, kend-pos-1));
+    values.push_back(frag.substr(kend+3, vend-kend-3));
+    pos = vend;
+  }
+}
+
+int main(int argc, char * argv[]) {
+  google::SetUsageMessage("metrics_convert.exe [--format=json|csv] <file.bin>");
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  
+  CHECK_EQ( argc, 2 ) << "usage: metrics_convert.exe [--format=json|csv] <file.bin>";
+  std::ifstream in(argv[1], std::ios::in | std::ios::binary);
+  CHECK( in ) << "unable to open " << argv[1];
+  
+  char magic[sizeof(impl::binary_magic)];
+  in.read(magic, sizeof(magic));
+  CHECK( in && std::equal(magic, magic+sizeof(magic), impl::binary_magic) )
+    << argv[1] << " is not a binary metrics file";
+  
+  auto core = read_value<uint32_t>(in);
+  auto ncores = read_value<uint32_t>(in);
+  auto nmetrics = read_value<uint32_t>(in);
+  
+  std::deque<std::string> names; // stable storage; metrics keep a pointer to their name
+  MetricList stats;
+  for (uint32_t i = 0; i < nmetrics; i++) {
+    names.push_back(read_string(in));
+    auto type = read_string(in);
+    auto m = impl::make_metric(type, names.back().c_str());
+    CHECK( m != nullptr ) << "unknown metric type '" << type << "' for " << names.back();
+    stats.push_back(m);
+  }
+  
+  bool csv = (FLAGS_format == "csv");
+  bool first = true;
+  std::string packed;
+  
+  while (in.peek() != EOF) {
+    auto timestamp = read_value<int64_t>(in);
+    auto nbytes = read_value<uint32_t>(in);
+    packed.resize(nbytes);
+    in.read(&packed[0], nbytes);
+    CHECK( in ) << "truncated metrics file";
+    
+    for (auto* s : stats) s->reset();
+    impl::merge_packed_all(stats, packed);
+    
+    if (csv) {
+      std::vector<std::string> keys, values;
+      for (auto* s : stats) {
+        std::ostringstream frag;
+        s->json(frag);
+        split_fields(frag.str(), keys, values);
+      }
+      if (first) {
+        std::cout << "timestamp,core,cores";
+        for (auto& k : keys) std::cout << "," << k;
+        std::cout << "\n";
+      }
+      std::cout << timestamp << "," << core << "," << ncores;
+      for (auto& v : values) std::cout << "," << v;
+      std::cout << "\n";
+    } else {
+      std::ostringstream ts;
+      ts << "  \"timestamp\": " << timestamp << ", \"core\": " << core << ", \"cores\": " << ncores;
+      Metrics::print(std::cout, stats, ts.str());
+    }
+    first = false;
+  }
+  
+  for (auto* s : stats) delete s;
+  return 0;
+}
@@ -43,6 +43,8 @@
 #include "ParallelLoop.hpp"
 #include "PerformanceTools.hpp"
 
+DECLARE_int64( metrics_merge_fanout );
+
 BOOST_AUTO_TEST_SUITE( Metrics_tests );
 
 using namespace Grappa;
@@ -67,6 +69,9 @@ GRAPPA_DEFINE_METRIC(MaxMetric<uint64_t>, maz, 0);
 GRAPPA_DEFINE_METRIC(StringMetric, foostr, "");
 #define I_FOOSTR 5
 
+GRAPPA_DEFINE_METRIC(LatencyHistogram, lat, 4);
+#define I_LAT 6
+
 BOOST_AUTO_TEST_CASE( test1 ) {
   Grappa::init( GRAPPA_TEST_ARGS );
   Grappa::run([]{
@@ -81,6 +86,8 @@ BOOST_AUTO_TEST_CASE( test1 ) {
 
     foostr = "foo";
 
+    for (int64_t i = 1; i <= 1000; i++) lat.record(i);
+
     delegate::call(1, []() -> bool {
       foo++;
       foo++;
@@ -90,6 +97,7 @@ BOOST_AUTO_TEST_CASE( test1 ) {
       baz += 36;
       foostr = "bar";
       foostr += "z";
+      for (int64_t i = 1001; i <= 2000; i++) lat.record(i);
 
       BOOST_CHECK( baz.value() == (16+25+36) );
       BOOST_CHECK( foo.value() == 2 );
@@ -119,6 +127,33 @@ BOOST_AUTO_TEST_CASE( test1 ) {
     // string append not associative
     BOOST_CHECK( (reinterpret_cast<StringMetric*>(all[I_FOOSTR])->value() == "foobarz") 
                 || (reinterpret_cast<StringMetric*>(all[I_FOOSTR])->value() == "barzfoo") );
+
+    auto merged_lat = reinterpret_cast<LatencyHistogram*>(all[I_LAT]);
+    BOOST_CHECK_EQUAL( merged_lat->count(), 2000 );
+    BOOST_CHECK_EQUAL( merged_lat->minimum(), 1 );
+    BOOST_CHECK_EQUAL( merged_lat->maximum(), 2000 );
+    BOOST_CHECK_CLOSE( merged_lat->mean(), 1000.5, 0.001 );
+    // 4 bits of precision => within 1/16 of the exact value, never below it
+    BOOST_CHECK( merged_lat->percentile(50) >= 1000 && merged_lat->percentile(50) <= 1000*17/16 );
+    BOOST_CHECK( merged_lat->percentile(99) >= 1980 && merged_lat->percentile(99) <= 2000 );
+    BOOST_CHECK_EQUAL( merged_lat->percentile(100), 2000 );
+
+    // a chain (fanout 1) forwards partial merges through every core
+    MetricList chain;
+    Metrics::merge_tree(chain, 1);
+    BOOST_CHECK_EQUAL( reinterpret_cast<SimpleMetric<int>*>(chain[I_FOO])->value(), 3 );
+    BOOST_CHECK_EQUAL( reinterpret_cast<SummarizingMetric<int>*>(chain[I_BAZ])->value(), 91 );
+    BOOST_CHECK_EQUAL( reinterpret_cast<LatencyHistogram*>(chain[I_LAT])->count(), 2000 );
+
+    // direct gather agrees with the tree
+    FLAGS_metrics_merge_fanout = 0;
+    MetricList direct;
+    Metrics::merge(direct);
+    FLAGS_metrics_merge_fanout = 8;
+    BOOST_CHECK_EQUAL( reinterpret_cast<SimpleMetric<int>*>(direct[I_FOO])->value(), 3 );
+    BOOST_CHECK_EQUAL( reinterpret_cast<SummarizingMetric<int>*>(direct[I_BAZ])->value(), 91 );
+    BOOST_CHECK_EQUAL( reinterpret_cast<LatencyHistogram*>(direct[I_LAT])->percentile(99),
+                       reinterpret_cast<LatencyHistogram*>(chain[I_LAT])->percentile(99) );
       
 
     Metrics::reset_all_cores();
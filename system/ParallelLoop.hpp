@@ -345,7 +345,7 @@ namespace Grappa {
     auto end = base+nelem;
     if (nelem > 0) { fc = 1; }
   
-    size_t block_elems = std::max<size_t>(1, block_size / sizeof(T));
+    size_t block_elems = std::max<size_t>(1, base.block_bytes() / sizeof(T));
     int64_t nfirstcore = base.block_max() - base;
     int64_t n = nelem - nfirstcore;
     
@@ -409,7 +409,7 @@ namespace Grappa {
       [loop_body,base](T* local_base, size_t nlocal){
         Grappa::forall_here<B,SyncMode::Async,GCE,Threshold>(0, nlocal, 
             [loop_body,local_base,base](int64_t s, int64_t n){
-          loop_body( make_linear(local_base+s)-base, n, local_base+s );
+          loop_body( make_linear(local_base+s, base.block_bytes())-base, n, local_base+s );
         });
       });
       
@@ -422,9 +422,10 @@ namespace Grappa {
     void forall(GlobalAddress<T> base, int64_t nelems, F loop_body,
                 void (F::*mf)(int64_t,T&) const)
     {
-      auto f = [loop_body](int64_t start, int64_t niters, T* first){
-        auto block_elems = block_size / sizeof(T);
-        auto a = make_linear(first);
+      size_t block_bytes = base.block_bytes();
+      auto f = [loop_body,block_bytes](int64_t start, int64_t niters, T* first){
+        auto block_elems = block_bytes / sizeof(T);
+        auto a = make_linear(first, block_bytes);
         auto n_to_boundary = a.block_max() - a;
         auto index = start;
         
@@ -88,6 +88,29 @@ BOOST_AUTO_TEST_CASE( test1 ) {
     BOOST_MESSAGE( "total=" << total );
     BOOST_CHECK( total == FLAGS_N );
 
+    // public and private tasks with closures too big for a task queue entry
+    struct Payload { int64_t v[40]; };
+    ce->enroll(2*FLAGS_N);
+    call_on_all_cores([]{ finished_local = 0; });
+    for (int i=0; i<FLAGS_N; i++) {
+      Payload p;
+      for (int k=0; k<40; k++) p.v[k] = i*k;
+      auto check = [i,p]{
+        for (int k=0; k<40; k++) BOOST_CHECK_EQUAL(p.v[k], i*k);
+        finished_local++;
+        delegate::call( 0, [] { ce->complete(); });
+      };
+      spawn<unbound>(check);
+      spawn(check);
+    }
+    ce->wait();
+    
+    total = 0;
+    for (uint64_t i=0; i<Grappa::cores(); i++) {
+      total += delegate::read(make_global(&finished_local,i)); 
+    }
+    BOOST_CHECK_EQUAL( total, 2*FLAGS_N );
+
   //  for ( uint64_t i = 0; i<N; i++ ) {
   //    uint64_t other = delegate::read( make_global(&finished[i],1));
   //    BOOST_MESSAGE( "i " << i << " fi "<<finished[i] <<" o " << other );
@@ -122,6 +122,25 @@ namespace Grappa {
     
     virtual void merge_all(impl::MetricBase* static_stat_ptr);
 
+    virtual void pack(std::string& out) const {
+      impl::pack_value(out, value_);
+    }
+    
+    virtual const char* merge_packed(const char* in) {
+      T v;
+      in = impl::unpack_value(in, &v);
+      if (initf_ != NULL) {
+        if (value_ > v) value_ = v; // min (see merge_all)
+      } else {
+        value_ += v;
+      }
+      return in;
+    }
+    
+    virtual std::string type_name() const {
+      return std::string("SimpleMetric<") + impl::metric_value_type<T>() + ">";
+    }
+
     inline const SimpleMetric<T>& count() { return (*this)++; }
 
     /// Get the current value
@@ -0,0 +1,465 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Grappa.hpp"
+#include "Collective.hpp"
+#include "GlobalAllocator.hpp"
+#include "Metrics.hpp"
+#include "ChunkSender.hpp"
+#include "ConditionVariableLocal.hpp"
+#include "Hashing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, sketch_merges);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, sketch_merge_bytes);
+GRAPPA_DECLARE_METRIC(SummarizingMetric<double>, sketch_merge_runtime);
+
+/// @file
+/// Mergeable sketches: small fixed- or bounded-size summaries that can be
+/// built independently on each core and combined afterwards, giving
+/// approximate answers in one pass at constant memory. Every sketch `S`
+/// provides:
+///
+///   - `add(x)`                        accumulate one item
+///   - `merge(const S&)`               combine with a sketch built with the same parameters
+///   - `serialize(std::vector<uint64_t>&)` / `static S deserialize(const uint64_t*, size_t)`
+///
+/// which is all SketchReducer needs to merge per-core sketches.
+
+namespace Grappa {
+
+/// HyperLogLog distinct-count sketch with 2^p one-byte registers
+/// (standard error about 1.04/sqrt(2^p): 1.6% at the default p = 12,
+/// in 4 KB).
+class HyperLogLog {
+  int p;
+  std::vector<uint8_t> reg;
+
+public:
+  HyperLogLog(int p = 12): p(p), reg(size_t(1) << p, 0) {
+    CHECK(p >= 4 && p <= 18) << "HyperLogLog precision must be in [4,18]";
+  }
+
+  /// Add an already well-mixed 64-bit hash.
+  void add_hash(uint64_t h) {
+    size_t idx = h >> (64 - p);
+    uint64_t w = (h << p) | (uint64_t(1) << (p - 1));  // guard bit bounds the count
+    uint8_t rho = __builtin_clzll(w) + 1;
+    if (rho > reg[idx]) reg[idx] = rho;
+  }
+
+  template< typename K, typename Hash = std::hash<K> >
+  void add(const K& key) { add_hash(mix64(Hash()(key))); }
+
+  void merge(const HyperLogLog& o) {
+    CHECK_EQ(p, o.p) << "merging HyperLogLogs of different precision";
+    for (size_t i = 0; i < reg.size(); i++) reg[i] = std::max(reg[i], o.reg[i]);
+  }
+
+  /// Estimated number of distinct items added.
+  double estimate() const {
+    double m = reg.size();
+    double alpha = (p == 4) ? 0.673 : (p == 5) ? 0.697 : (p == 6) ? 0.709 : 0.7213 / (1 + 1.079 / m);
+    double sum = 0;
+    size_t zeros = 0;
+    for (auto r : reg) {
+      sum += std::ldexp(1.0, -r);
+      if (r == 0) zeros++;
+    }
+    double e = alpha * m * m / sum;
+    // small-range correction: linear counting
+    if (e <= 2.5 * m && zeros > 0) e = m * std::log(m / zeros);
+    return e;
+  }
+
+  void serialize(std::vector<uint64_t>& out) const {
+    out.assign(1 + (reg.size() + 7) / 8, 0);
+    out[0] = p;
+    ::memcpy(&out[1], reg.data(), reg.size());
+  }
+
+  static HyperLogLog deserialize(const uint64_t * w, size_t n) {
+    HyperLogLog h(w[0]);
+    CHECK_EQ(n, 1 + (h.reg.size() + 7) / 8);
+    ::memcpy(h.reg.data(), &w[1], h.reg.size());
+    return h;
+  }
+};
+
+/// Count-min sketch: `depth` rows of `width` counters. Estimates never
+/// undercount; with total count N they overcount by at most e*N/width
+/// with probability 1 - exp(-depth).
+class CountMinSketch {
+  size_t width;
+  size_t depth;
+  uint64_t total;
+  std::vector<uint64_t> counts;  // counts[d * width + i]
+
+  size_t cell(uint64_t h, size_t d) const {
+    return d * width + mix64(h + (d + 1) * 0x9E3779B97F4A7C15ULL) % width;
+  }
+
+public:
+  CountMinSketch(size_t width = 2048, size_t depth = 4)
+    : width(width), depth(depth), total(0), counts(width * depth, 0) {
+    CHECK(width > 0 && depth > 0);
+  }
+
+  template< typename K, typename Hash = std::hash<K> >
+  void add(const K& key, uint64_t count = 1) {
+    uint64_t h = Hash()(key);
+    for (size_t d = 0; d < depth; d++) counts[cell(h, d)] += count;
+    total += count;
+  }
+
+  /// Upper bound on the count of `key` (exact up to collisions).
+  template< typename K, typename Hash = std::hash<K> >
+  uint64_t estimate(const K& key) const {
+    uint64_t h = Hash()(key);
+    uint64_t e = counts[cell(h, 0)];
+    for (size_t d = 1; d < depth; d++) e = std::min(e, counts[cell(h, d)]);
+    return e;
+  }
+
+  /// Estimated size of the equi-join of the two multisets summarized
+  /// (sum over keys of count here * count there); never underestimates.
+  uint64_t inner_product(const CountMinSketch& o) const {
+    CHECK(width == o.width && depth == o.depth) << "sketches differ in shape";
+    uint64_t best = UINT64_MAX;
+    for (size_t d = 0; d < depth; d++) {
+      uint64_t dot = 0;
+      for (size_t i = d * width; i < (d + 1) * width; i++) dot += counts[i] * o.counts[i];
+      best = std::min(best, dot);
+    }
+    return best;
+  }
+
+  uint64_t size() const { return total; }
+
+  void merge(const CountMinSketch& o) {
+    CHECK(width == o.width && depth == o.depth) << "merging count-min sketches of different shape";
+    for (size_t i = 0; i < counts.size(); i++) counts[i] += o.counts[i];
+    total += o.total;
+  }
+
+  void serialize(std::vector<uint64_t>& out) const {
+    out.clear();
+    out.push_back(width);
+    out.push_back(depth);
+    out.push_back(total);
+    out.insert(out.end(), counts.begin(), counts.end());
+  }
+
+  static CountMinSketch deserialize(const uint64_t * w, size_t n) {
+    CountMinSketch s(w[0], w[1]);
+    CHECK_EQ(n, 3 + s.counts.size());
+    s.total = w[2];
+    std::copy(w + 3, w + n, s.counts.begin());
+    return s;
+  }
+};
+
+/// KLL quantile sketch over values of type T: a stack of compactors,
+/// where level h holds items of weight 2^h and lower levels get
+/// geometrically smaller capacities. Rank error is about 1.7/k with
+/// high probability, using O(k) items regardless of how many are added.
+template< typename T = double >
+class QuantileSketch {
+  static_assert(std::is_pod<T>::value && sizeof(T) <= sizeof(uint64_t),
+                "QuantileSketch values must be POD and at most 8 bytes");
+
+  uint32_t k;
+  uint64_t n;
+  uint64_t coin;  // xorshift state choosing which half a compaction keeps
+  std::vector<std::vector<T>> levels;
+
+  // xorshift is stuck at 0, so never let the state get there
+  static uint64_t nonzero(uint64_t z) { return z ? z : 0x2545F4914F6CDD1DULL; }
+
+  size_t capacity(size_t h) const {
+    size_t depth = levels.size() - 1 - h;
+    return std::max<size_t>(2, std::ceil(k * std::pow(2.0 / 3.0, depth)));
+  }
+
+  bool over_capacity() const {
+    size_t retained = 0, cap = 0;
+    for (size_t h = 0; h < levels.size(); h++) {
+      retained += levels[h].size();
+      cap += capacity(h);
+    }
+    return retained > cap;
+  }
+
+  // halve the lowest full level into the one above until everything fits
+  void compress() {
+    while (over_capacity()) {
+      size_t h = 0;
+      while (levels[h].size() < capacity(h)) h++;
+      if (h + 1 == levels.size()) levels.emplace_back();
+      auto& lv = levels[h];
+      auto& up = levels[h + 1];
+      std::sort(lv.begin(), lv.end());
+      coin ^= coin << 13; coin ^= coin >> 7; coin ^= coin << 17;
+      size_t even = lv.size() & ~size_t(1);
+      for (size_t i = coin & 1; i < even; i += 2) up.push_back(lv[i]);
+      lv.erase(lv.begin(), lv.begin() + even);  // an odd item stays behind
+    }
+  }
+
+  // (value, weight) of every retained item, sorted by value
+  std::vector<std::pair<T,uint64_t>> weighted() const {
+    std::vector<std::pair<T,uint64_t>> items;
+    for (size_t h = 0; h < levels.size(); h++) {
+      for (auto& x : levels[h]) items.push_back(std::make_pair(x, uint64_t(1) << h));
+    }
+    std::sort(items.begin(), items.end());
+    return items;
+  }
+
+public:
+  QuantileSketch(uint32_t k = 200): k(k), n(0), coin(0x2545F4914F6CDD1DULL), levels(1) {
+    CHECK_GE(k, 8u);
+  }
+
+  /// Reseed the compaction coin flips. Sketches that are merged should
+  /// be seeded differently (SketchReducer seeds each core's by its rank),
+  /// or identical inputs compact identically and the errors add up.
+  void seed(uint64_t s) { coin = nonzero(mix64(s)); }
+
+  void add(const T& x) {
+    levels[0].push_back(x);
+    n++;
+    if (levels[0].size() >= capacity(0)) compress();
+  }
+
+  void merge(const QuantileSketch& o) {
+    CHECK_EQ(k, o.k) << "merging quantile sketches with different k";
+    if (levels.size() < o.levels.size()) levels.resize(o.levels.size());
+    for (size_t h = 0; h < o.levels.size(); h++) {
+      levels[h].insert(levels[h].end(), o.levels[h].begin(), o.levels[h].end());
+    }
+    n += o.n;
+    coin = nonzero(mix64(coin ^ o.coin ^ n));  // equal coins must not cancel
+    compress();
+  }
+
+  /// Number of values added.
+  uint64_t size() const { return n; }
+
+  /// Approximate value at quantile `q` in [0,1] (0.5 = median).
+  T quantile(double q) const {
+    CHECK_GT(n, 0) << "quantile of an empty sketch";
+    auto items = weighted();
+    double target = std::max(0.0, std::min(1.0, q)) * n;
+    uint64_t cum = 0;
+    for (auto& it : items) {
+      cum += it.second;
+      if (cum >= target) return it.first;
+    }
+    return items.back().first;
+  }
+
+  /// Approximate fraction of values <= x.
+  double rank(const T& x) const {
+    if (n == 0) return 0;
+    uint64_t below = 0;
+    for (size_t h = 0; h < levels.size(); h++) {
+      for (auto& y : levels[h]) if (!(x < y)) below += uint64_t(1) << h;
+    }
+    return double(below) / n;
+  }
+
+  void serialize(std::vector<uint64_t>& out) const {
+    out.clear();
+    out.push_back(k);
+    out.push_back(n);
+    out.push_back(coin);
+    out.push_back(levels.size());
+    for (auto& lv : levels) out.push_back(lv.size());
+    for (auto& lv : levels) {
+      for (auto& x : lv) {
+        uint64_t w = 0;
+        ::memcpy(&w, &x, sizeof(T));
+        out.push_back(w);
+      }
+    }
+  }
+
+  static QuantileSketch deserialize(const uint64_t * w, size_t n) {
+    QuantileSketch s(w[0]);
+    s.n = w[1];
+    s.coin = w[2];
+    s.levels.resize(w[3]);
+    size_t pos = 4 + s.levels.size();
+    for (size_t h = 0; h < s.levels.size(); h++) {
+      s.levels[h].resize(w[4 + h]);
+      for (auto& x : s.levels[h]) ::memcpy(&x, &w[pos++], sizeof(T));
+    }
+    CHECK_EQ(pos, n);
+    return s;
+  }
+};
+
+namespace impl {
+  // seed sketches that randomize (see QuantileSketch::seed); others need none
+  template< typename S >
+  auto seed_sketch(S& s, uint64_t seed, int) -> decltype(s.seed(seed), void()) { s.seed(seed); }
+  template< typename S >
+  void seed_sketch(S&, uint64_t, long) {}
+}
+
+/// Sketch-valued reducer: each core accumulates into its own sketch
+/// with no communication, and `merge()` combines them up a binomial tree
+/// (log2(cores) rounds, each sketch sent once in bulk chunks) onto the
+/// calling core. Per-core sketches are left intact, so accumulation may
+/// continue after a merge. Sketches with a `seed(uint64_t)` member are
+/// seeded with their core's rank, so they don't compact in lockstep.
+///
+/// Unlike Reducer, a SketchReducer is allocated symmetrically, so several
+/// may be in use at once:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// auto distinct = SketchReducer<HyperLogLog>::create(14);
+/// forall(edges, nedges, [distinct](Edge& e){ distinct->add(e.src); });
+/// LOG(INFO) << "~" << distinct->merge().estimate() << " sources";
+/// distinct->destroy();
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+template< typename S >
+class SketchReducer {
+  static const int MAX_ROUNDS = 8 * sizeof(Core);
+
+  GlobalAddress<SketchReducer> self;
+  S empty;
+  S local_sketch;
+  S merged;
+  std::vector<std::vector<uint64_t>> incoming;  // by round
+  std::vector<size_t> received;                 // by round
+  ConditionVariable arrived;                    // signaled as sketches complete
+  ChunkSender sender;
+
+  SketchReducer(GlobalAddress<SketchReducer> self, const S& empty)
+    : self(self), empty(empty), local_sketch(empty), merged(empty)
+    , incoming(MAX_ROUNDS), received(MAX_ROUNDS, 0) {}
+
+  void send_sketch(Core c, int round, const S& s) {
+    std::vector<uint64_t> w;
+    s.serialize(w);
+    auto self = this->self;
+    size_t total = w.size();
+    sketch_merge_bytes += total * sizeof(uint64_t);
+    sender.send(c, w.data(), total, [self,round,total](const uint64_t * words, size_t n, size_t offset){
+      auto& buf = self->incoming[round];
+      if (buf.size() < total) buf.resize(total);
+      std::copy(words, words + n, buf.begin() + offset);
+      self->received[round] += n;
+      if (self->received[round] == total) broadcast(&self->arrived);
+    });
+    sender.wait();
+  }
+
+  S receive_sketch(int round) {
+    auto& buf = incoming[round];
+    while (buf.empty() || received[round] < buf.size()) Grappa::wait(&arrived);
+    S s = S::deserialize(buf.data(), buf.size());
+    buf.clear();
+    received[round] = 0;
+    return s;
+  }
+
+public:
+  /// Create a reducer whose per-core sketches are all `S(args...)`.
+  template< typename... Args >
+  static GlobalAddress<SketchReducer> create(Args... args) {
+    auto r = symmetric_global_alloc<SketchReducer>();
+    on_all_cores([r,args...]{
+      S empty(args...);
+      impl::seed_sketch(empty, mycore(), 0);
+      new (r.localize()) SketchReducer(r, empty);
+    });
+    return r;
+  }
+
+  void destroy() {
+    auto self = this->self;
+    on_all_cores([self]{ self->~SketchReducer(); });
+    global_free(self);
+  }
+
+  /// This core's sketch.
+  S& local() { return local_sketch; }
+
+  /// Accumulate into this core's sketch (`S::add(args...)`); cheap and local.
+  template< typename... Args >
+  void add(const Args&... args) { local_sketch.add(args...); }
+
+  /// Merge all cores' sketches onto the calling core and return the result.
+  S merge() {
+    auto self = this->self;
+    Core root = mycore();
+    double start = walltime();
+    on_all_cores([self,root]{
+      auto r = self.localize();
+      r->merged = r->local_sketch;
+      int rank = (mycore() - root + cores()) % cores();
+      for (int round = 0; (1 << round) < cores(); round++) {
+        int step = 1 << round;
+        if (rank & step) {
+          r->send_sketch((rank - step + root) % cores(), round, r->merged);
+          break;
+        }
+        if (rank + step < cores()) {
+          r->merged.merge(r->receive_sketch(round));
+          sketch_merges++;
+        }
+      }
+    });
+    sketch_merge_runtime += walltime() - start;
+    return merged;
+  }
+
+  /// Clear the sketches on all cores.
+  void reset() {
+    auto self = this->self;
+    on_all_cores([self]{ self->local_sketch = self->empty; });
+  }
+} GRAPPA_BLOCK_ALIGNED;
+
+} // namespace Grappa
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <Sketch.hpp>
+
+BOOST_AUTO_TEST_SUITE( Sketch_tests );
+
+using namespace Grappa;
+
+DEFINE_int64(sketch_items, 1 << 18, "Number of items added to each sketch.");
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t n = FLAGS_sketch_items;
+    int64_t distinct = n / 4;
+    auto A = global_alloc<int64_t>(n);
+    forall(A, n, [](int64_t i, int64_t& a){ a = i; });
+
+    BOOST_MESSAGE("HyperLogLog");
+    auto hll = SketchReducer<HyperLogLog>::create(12);
+    forall(A, n, [hll,distinct](int64_t& a){ hll->add(a % distinct); });
+    double d = hll->merge().estimate();
+    BOOST_MESSAGE("distinct: " << d << " (exact " << distinct << ")");
+    BOOST_CHECK_LT(std::abs(d - distinct) / distinct, 0.05);
+    // merging leaves the per-core sketches intact
+    BOOST_CHECK_EQUAL(hll->merge().estimate(), d);
+    hll->destroy();
+
+    BOOST_MESSAGE("CountMinSketch");
+    auto cm = SketchReducer<CountMinSketch>::create(1024, 4);
+    forall(A, n, [cm](int64_t& a){ cm->add(a % 100, (a % 100 == 7) ? 3 : 1); });
+    auto freq = cm->merge();
+    BOOST_CHECK_EQUAL(freq.size(), n + 2 * (n / 100 + (n % 100 > 7)));
+    for (int64_t k = 0; k < 100; k++) {
+      uint64_t exact = (n / 100 + (k < n % 100)) * (k == 7 ? 3 : 1);
+      BOOST_CHECK_GE(freq.estimate(k), exact);
+      BOOST_CHECK_LE(freq.estimate(k), exact + 3 * freq.size() / 1024);
+    }
+    cm->destroy();
+
+    BOOST_MESSAGE("QuantileSketch");
+    auto q = SketchReducer<QuantileSketch<double>>::create(200);
+    forall(A, n, [q](int64_t& a){ q->add(double(a)); });
+    auto dist = q->merge();
+    BOOST_CHECK_EQUAL(dist.size(), n);
+    for (double p : {0.01, 0.25, 0.5, 0.75, 0.99}) {
+      BOOST_MESSAGE(p << " quantile: " << dist.quantile(p) << " (exact " << p * n << ")");
+      BOOST_CHECK_LT(std::abs(dist.quantile(p) - p * n) / n, 0.02);
+    }
+    q->reset();
+    BOOST_CHECK_EQUAL(q->merge().size(), 0);
+    q->destroy();
+
+    BOOST_MESSAGE("QuantileSketch with matching coins");
+    // sketches fed equally many items flip the same coins (word 2 of the
+    // serialized form); merging them must not cancel the state to zero
+    QuantileSketch<double> a(64), b(64);
+    for (int64_t i = 0; i < 1000; i++) { a.add(double(2*i)); b.add(double(2*i+1)); }
+    std::vector<uint64_t> wa, wb;
+    a.serialize(wa);
+    b.serialize(wb);
+    BOOST_CHECK_EQUAL(wa[2], wb[2]);
+    a.merge(b);
+    a.serialize(wa);
+    BOOST_CHECK_NE(wa[2], 0);
+    for (int64_t i = 2000; i < n; i++) a.add(double(i));
+    for (double p : {0.25, 0.5, 0.75}) {
+      BOOST_CHECK_LT(std::abs(a.quantile(p) - p * n) / n, 0.02);
+    }
+    // SketchReducer seeds each core's sketch differently
+    auto seeded = SketchReducer<QuantileSketch<double>>::create(64);
+    on_all_cores([seeded]{
+      std::vector<uint64_t> w;
+      seeded->local().serialize(w);
+      auto lo = allreduce<uint64_t,collective_min>(w[2]);
+      auto hi = allreduce<uint64_t,collective_max>(w[2]);
+      if (cores() > 1) BOOST_CHECK_NE(lo, hi);
+    });
+    seeded->destroy();
+
+    global_free(A);
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -137,6 +137,27 @@ namespace Grappa {
     
     virtual void merge_all(impl::MetricBase* static_stat_ptr);
 
+    virtual void pack(std::string& out) const {
+      uint16_t len = strlen(value_);
+      impl::pack_value(out, len);
+      out.append(value_, len);
+    }
+    
+    virtual const char* merge_packed(const char* in) {
+      uint16_t len;
+      in = impl::unpack_value(in, &len);
+      std::string s(in, len);
+      if (initf_ != NULL) {
+        // max length str (see merge_all)
+        if (strlen(value_) < s.length()) write_value(s);
+      } else {
+        write_value(std::string(value_) + s);
+      }
+      return in + len;
+    }
+    
+    virtual std::string type_name() const { return "StringMetric"; }
+
     /// Get the current value
     inline std::string value() const { return std::string(value_); }
     
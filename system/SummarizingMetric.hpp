@@ -50,6 +50,7 @@
 #include <math.h>
 
 #include <limits>
+#include <algorithm>
 
 namespace Grappa {
 
@@ -129,7 +130,9 @@ namespace Grappa {
       , value_( s.value_ )
       , n( s.n )
       , mean( s.mean )
-      , M2( s.M2 ) {
+      , M2( s.M2 )
+      , min( s.min )
+      , max( s.max ) {
       // no vampir registration since this is for merging
     }
     
@@ -164,6 +167,44 @@ namespace Grappa {
     
     virtual void merge_all(impl::MetricBase* static_stat_ptr);
 
+    virtual void pack(std::string& out) const {
+      impl::pack_value(out, value_);
+      impl::pack_value(out, n);
+      impl::pack_value(out, mean);
+      impl::pack_value(out, M2);
+      impl::pack_value(out, min);
+      impl::pack_value(out, max);
+    }
+    
+    virtual const char* merge_packed(const char* in) {
+      T o_value, o_min, o_max; size_t o_n; double o_mean, o_M2;
+      in = impl::unpack_value(in, &o_value);
+      in = impl::unpack_value(in, &o_n);
+      in = impl::unpack_value(in, &o_mean);
+      in = impl::unpack_value(in, &o_M2);
+      in = impl::unpack_value(in, &o_min);
+      in = impl::unpack_value(in, &o_max);
+      if( o_n > 0 ) { // same combining rule as merge_all
+        value_ += o_value;
+        if( n == 0 ) {
+          n = o_n; mean = o_mean; M2 = o_M2; min = o_min; max = o_max;
+        } else {
+          size_t new_n = o_n + n;
+          double delta = o_mean - mean;
+          mean = mean + delta * ( static_cast<double>(o_n) / new_n );
+          M2 = M2 + o_M2 + delta * delta * n * o_n / new_n;
+          n = new_n;
+          max = std::max(max, o_max);
+          min = std::min(min, o_min);
+        }
+      }
+      return in;
+    }
+    
+    virtual std::string type_name() const {
+      return std::string("SummarizingMetric<") + impl::metric_value_type<T>() + ">";
+    }
+
     inline const SummarizingMetric<T>& count() { return (*this)++; }
 
     /// Get the current value
@@ -42,6 +42,7 @@
 #include "Communicator.hpp"
 
 #include <cstdlib>
+#include <type_traits>
 
 #include <boost/type_traits/remove_pointer.hpp>
 #include <boost/typeof/typeof.hpp>
@@ -59,8 +60,10 @@
 
 DECLARE_uint64( num_starting_workers );
 
-GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, tasks_heap_allocated);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, tasks_slab_allocated);
 GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, tasks_created);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, task_slab_refills);
+GRAPPA_DECLARE_METRIC(SimpleMetric<uint64_t>, task_closures_fetched);
 
 ///
 /// Task routines
@@ -84,6 +87,50 @@ namespace Grappa {
 
   namespace impl {
 
+    /// Size of the slab blocks used for task closures of `bytes` bytes:
+    /// the next power of two, at least 32.
+    constexpr size_t task_slab_bytes( size_t bytes, size_t block = 32 ) {
+      return block >= bytes ? block : task_slab_bytes( bytes, block * 2 );
+    }
+    
+    /// Per-core pool of `Bytes`-byte blocks holding task closures too big
+    /// to fit in a task queue entry. Blocks are carved from the heap
+    /// `chunk_blocks` at a time and recycled through a free list, so
+    /// spawning large tasks doesn't pay for a malloc/free per task.
+    template< size_t Bytes >
+    class TaskSlab {
+      static void * free_list;
+    public:
+      static const size_t chunk_blocks = 64;
+      
+      static void * allocate() {
+        if( !free_list ) {
+          task_slab_refills++;
+          // blocks are powers of two, so a block-aligned chunk keeps every
+          // closure (up to block alignment) suitably aligned
+          void * mem = nullptr;
+          CHECK_EQ( posix_memalign( &mem, BLOCK_SIZE, Bytes * chunk_blocks ), 0 ) << "Out of memory allocating task slab";
+          char * chunk = static_cast<char*>( mem );
+          for( size_t i = 0; i < chunk_blocks; i++ ) release( chunk + i * Bytes );
+        }
+        void * p = free_list;
+        free_list = *reinterpret_cast<void**>( p );
+        return p;
+      }
+      
+      static void release( void * p ) {
+        *reinterpret_cast<void**>( p ) = free_list;
+        free_list = p;
+      }
+    };
+    template< size_t Bytes > void * TaskSlab<Bytes>::free_list = nullptr;
+    
+    /// Copy a `bytes`-byte task closure from `remote` on core `origin` to
+    /// `local`, then return its storage there with `release`. Used to run
+    /// public tasks stolen from another core.
+    void fetch_task_closure( Core origin, void * remote, void * local, size_t bytes,
+                             void (*release)(void*) );
+    
     /// Helper function to insert lambdas and functors in our task queues.
     template< typename T >
     static void task_functor_proxy( uint64_t a0, uint64_t a1, uint64_t a2 ) {
@@ -95,12 +142,31 @@ namespace Grappa {
 
     /// Helper function to insert lambdas and functors in our task
     /// queues when they are larger than 24 bytes. This function takes
-    /// ownership of the heap-allocated functor and deallocates it
-    /// after it has run.
+    /// ownership of the slab-allocated functor and releases it after it
+    /// has run.
     template< typename T >
-    static void task_heapfunctor_proxy( T * tp, T * unused1, T * unused2 ) {
+    static void task_slabfunctor_proxy( T * tp, T * unused1, T * unused2 ) {
       (*tp)();
-      delete tp;
+      tp->~T();
+      TaskSlab< task_slab_bytes(sizeof(T)) >::release( tp );
+    }
+    
+    /// Like task_slabfunctor_proxy, for public tasks. If the task was
+    /// stolen, the functor is copied from the spawning core first.
+    template< typename T >
+    static void task_public_slabfunctor_proxy( uint64_t storage, uint64_t origin, uint64_t unused ) {
+      T * tp = reinterpret_cast< T * >( storage );
+      if( static_cast< Core >( origin ) == Grappa::mycore() ) {
+        (*tp)();
+        tp->~T();
+        TaskSlab< task_slab_bytes(sizeof(T)) >::release( tp );
+      } else {
+        typename std::aligned_storage< sizeof(T), alignof(T) >::type buf;
+        fetch_task_closure( origin, tp, &buf, sizeof(T), &TaskSlab< task_slab_bytes(sizeof(T)) >::release );
+        T * local = reinterpret_cast< T * >( &buf );
+        (*local)();
+        local->~T();
+      }
     }
 
     /// Helper function to spawn workers with lambdas and
@@ -117,9 +183,9 @@ namespace Grappa {
 
   /// Spawn a task visible to this Core only. The task is specified as
   /// a functor or lambda. If it is 24 bytes or less, it is copied
-  /// directly into the task queue. If it is larger, a copy is
-  /// allocated on the heap. This copy will be deallocated after the
-  /// task completes.
+  /// directly into the task queue. If it is larger, a copy is placed
+  /// in a per-core slab block sized for it (see impl::TaskSlab), which
+  /// is recycled after the task completes.
   ///
   /// @tparam TF type of task functor
   ///
@@ -134,14 +200,13 @@ namespace Grappa {
   void privateTask( TF tf ) {
     tasks_created++;
     if( sizeof( tf ) > 24 ) { // if it's too big to fit in a task queue entry
-      DVLOG(4) << "Heap allocated task of size " << sizeof(tf);
-      tasks_heap_allocated++;
+      DVLOG(4) << "Slab allocated task of size " << sizeof(tf);
+      tasks_slab_allocated++;
+      static_assert( alignof(TF) <= BLOCK_SIZE, "task functor alignment too large for slab" );
       
-      struct __attribute__((deprecated("heap allocating private task functor"))) Warning {};
-      
-      // heap-allocate copy of functor, passing ownership to spawned task
-      TF * tp = new TF(tf);
-      Grappa::impl::global_task_manager.spawnLocalPrivate( Grappa::impl::task_heapfunctor_proxy<TF>, tp, tp, tp );
+      // copy functor into slab storage, passing ownership to spawned task
+      TF * tp = new (impl::TaskSlab< impl::task_slab_bytes(sizeof(TF)) >::allocate()) TF(tf);
+      Grappa::impl::global_task_manager.spawnLocalPrivate( Grappa::impl::task_slabfunctor_proxy<TF>, tp, tp, tp );
     } else {
       /// Shove copy of functor into space used for task arguments.
       /// @todo: misusing argument list. Is this okay?
@@ -155,21 +220,41 @@ namespace Grappa {
     }
   }
   
-  /// Spawn a task that may be stolen between cores. The task is specified as a functor or lambda,
-  /// and must be 24 bytes or less (currently).
+  namespace impl {
+    
+    /// @b internal: publicTask for functors that fit in the task arguments
+    template < typename TF >
+    void spawn_public( TF& tf, std::false_type ) {
+      uint64_t args[3];
+      new (reinterpret_cast<TF*>(&args[0])) TF(tf);
+      global_task_manager.spawnPublic( task_functor_proxy<TF>, args[0], args[1], args[2] );
+    }
+    
+    /// @b internal: publicTask for larger functors, kept in a slab block
+    template < typename TF >
+    void spawn_public( TF& tf, std::true_type ) {
+      tasks_slab_allocated++;
+      static_assert( alignof(TF) <= BLOCK_SIZE, "task functor alignment too large for slab" );
+      TF * tp = new (TaskSlab< task_slab_bytes(sizeof(TF)) >::allocate()) TF(tf);
+      global_task_manager.spawnPublic( task_public_slabfunctor_proxy<TF>,
+          reinterpret_cast<uint64_t>(tp), static_cast<uint64_t>(Grappa::mycore()), uint64_t(0) );
+    }
+    
+  }
+  
+  /// Spawn a task that may be stolen between cores. The task is specified as a functor or lambda.
+  /// Functors larger than 24 bytes are kept in a slab block on this core; if the task is stolen,
+  /// the thief copies the functor over before running it, so (as with messages) its captures
+  /// must be safe to copy bytewise to another core.
   ///
   /// @see Grappa::spawn for usage.
   template < typename TF >
   void publicTask( TF tf ) {
     tasks_created++;
-    // TODO: implement automatic heap allocation and caching to handle larger functors
-    CHECK_LE( sizeof(tf), 24) << "Functor argument to publicTask too large to be automatically coerced.";
-    
     DVLOG(5) << "Worker " << Grappa::impl::global_scheduler.get_current_thread() << " spawns public";
-    
-    uint64_t args[3];
-    new (reinterpret_cast<TF*>(&args[0])) TF(tf);
-    Grappa::impl::global_task_manager.spawnPublic(Grappa::impl::task_functor_proxy<TF>, args[0], args[1], args[2]);
+    // pick the slab path at compile time, so the placement new into the
+    // task arguments is only instantiated for functors that fit
+    impl::spawn_public( tf, std::integral_constant< bool, (sizeof(TF) > 24) >() );
   }
 
   /// @b internal
@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Graph.hpp"
+#include "Collective.hpp"
+#include "Delegate.hpp"
+#include "ParallelLoop.hpp"
+#include <unordered_map>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, cc_sample_links);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, cc_final_links);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, cc_skipped_vertices);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, cc_giant_component_size);
+
+namespace Grappa {
+  
+  /// @addtogroup Graph
+  /// @{
+  
+  namespace impl {
+    
+    /// Per-core counts for connected_components().
+    extern int64_t cc_roots;
+    extern int64_t cc_giant;
+    
+    /// Label of vertex `i` (its parent in the component forest).
+    template< typename G, typename Label >
+    VertexID cc_parent(GlobalAddress<G> g, Label label, VertexID i) {
+      return delegate::call(g->vs+i, [label](typename G::Vertex& v){ return label(v); });
+    }
+    
+    /// Pending union of the trees containing `hi` and `lo` (hi > lo),
+    /// handled by the core that owns vertex `hi`.
+    struct CCLink {
+      VertexID hi;
+      VertexID lo;
+    };
+    
+    inline CCLink cc_make_link(VertexID u, VertexID v) {
+      return CCLink{ std::max(u, v), std::min(u, v) };
+    }
+    
+    /// Most links each core queues in the final phase before applying them.
+    const size_t cc_link_batch = 1 << 16;
+    
+    /// Called from SPMD context: apply every core's `pending` links
+    /// (Afforest's `link`, always pointing the larger root at the
+    /// smaller). Links are applied in rounds: each round groups them by
+    /// the core owning `hi` and exchanges them with one alltoallv. There,
+    /// `hi` is hooked to `lo` if it is a root; otherwise the link moves up
+    /// to hi's parent and goes into the next round. Only the owner writes
+    /// a vertex's label, so no atomics are needed.
+    template< typename G, typename Label >
+    void cc_link_all(GlobalAddress<G> g, Label label, std::vector<CCLink>& pending) {
+      auto vs = g->vs;
+      std::vector<size_t> counts(cores());
+      std::vector<size_t> offsets(cores());
+      std::vector<CCLink> out, in;
+      while (allreduce<int64_t,collective_add>(pending.size()) > 0) {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (auto& l : pending) counts[(vs+l.hi).core()]++;
+        offsets[0] = 0;
+        for (Core c = 1; c < cores(); c++) offsets[c] = offsets[c-1] + counts[c-1];
+        out.resize(pending.size());
+        for (auto& l : pending) out[offsets[(vs+l.hi).core()]++] = l;
+        
+        alltoallv(out.data(), counts.data(), in);
+        
+        pending.clear();
+        for (auto& l : in) {
+          auto& v = *(vs+l.hi).pointer();
+          VertexID p = label(v);
+          if (p == l.hi) {
+            label(v) = l.lo; // root: hook it
+          } else if (p != l.lo) {
+            pending.push_back(cc_make_link(p, l.lo));
+          }
+        }
+      }
+    }
+    
+    /// Point every vertex directly at its root.
+    template< typename G, typename Label >
+    void cc_compress(GlobalAddress<G> g, Label label) {
+      forall(g, [g,label](typename G::Vertex& v){
+        VertexID p = label(v);
+        VertexID pp = cc_parent(g, label, p);
+        while (pp != p) {
+          p = pp;
+          pp = cc_parent(g, label, p);
+        }
+        label(v) = p;
+      });
+    }
+    
+  }
+  
+  /// Connected components of an undirected graph, by Afforest (Sutton et
+  /// al.), a Shiloach-Vishkin variant using neighbor sampling.
+  ///
+  /// First each vertex links along only its first `neighbor_rounds` edges,
+  /// which is enough to connect most of the largest component, followed by
+  /// pointer jumping. The largest component is then identified by sampling
+  /// labels, and only vertices outside it link along their remaining edges
+  /// (in an undirected graph, any edge into the largest component is also
+  /// seen from its other end). Links are sent in bulk to the cores owning
+  /// the roots they hook (see impl::cc_link_all), so this takes a few bulk
+  /// phases regardless of the graph's diameter, unlike label propagation
+  /// which needs one round per hop.
+  ///
+  /// Afterwards `label(v)` is the smallest vertex ID in v's component.
+  ///
+  /// @param label  reference to a VertexID field: `VertexID&(G::Vertex&)`
+  /// @return number of components (counting only valid vertices)
+  ///
+  /// Example:
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// struct VertexData { VertexID component; };
+  /// using G = Graph<VertexData,Empty>;
+  ///
+  /// auto n = connected_components(g, [](G::Vertex& v) -> VertexID& {
+  ///   return v->component;
+  /// });
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  template< typename G, typename Label >
+  int64_t connected_components(GlobalAddress<G> g, Label label,
+                               int neighbor_rounds = 2, int64_t nsamples = 1024) {
+    using Vertex = typename G::Vertex;
+    
+    forall(g->vs, g->nv, [label](VertexID i, Vertex& v){ label(v) = i; });
+    
+    // link along a few sampled neighbors of each vertex
+    for (int r = 0; r < neighbor_rounds; r++) {
+      on_all_cores([g,label,r]{
+        std::vector<impl::CCLink> pending;
+        for (auto& v : iterate_local(g->vs, g->nv)) {
+          if (v.valid && v.nadj > r) {
+            cc_sample_links++;
+            pending.push_back(impl::cc_make_link(make_linear(&v) - g->vs, v.local_adj[r]));
+          }
+        }
+        impl::cc_link_all(g, label, pending);
+      });
+      impl::cc_compress(g, label);
+    }
+    
+    // find the most common label among a random sample of vertices
+    std::vector<VertexID> samples(nsamples);
+    auto sp = samples.data();
+    auto nv = g->nv;
+    forall_here(0, nsamples, [g,label,sp,nv](int64_t i){
+      sp[i] = impl::cc_parent(g, label, random() % nv);
+    });
+    std::unordered_map<VertexID,int64_t> freq;
+    VertexID giant = -1;
+    int64_t giant_count = 0;
+    for (auto c : samples) {
+      if (++freq[c] > giant_count) { giant = c; giant_count = freq[c]; }
+    }
+    VLOG(2) << "cc: largest sampled component " << giant
+            << " (" << giant_count << " of " << nsamples << " samples)";
+    
+    // everything else links along its remaining edges, a batch at a time
+    on_all_cores([g,label,neighbor_rounds,giant]{
+      auto local = iterate_local(g->vs, g->nv);
+      Vertex * v = local.begin();
+      Vertex * end = local.end();
+      int64_t k = neighbor_rounds;  // next edge of *v
+      std::vector<impl::CCLink> pending;
+      do {
+        while (v != end && pending.size() < impl::cc_link_batch) {
+          if (k == neighbor_rounds && v->valid && label(*v) == giant) {
+            cc_skipped_vertices++;
+            k = v->nadj;
+          }
+          if (v->valid && k < v->nadj) {
+            cc_final_links++;
+            pending.push_back(impl::cc_make_link(make_linear(v) - g->vs, v->local_adj[k++]));
+          } else {
+            v++;
+            k = neighbor_rounds;
+          }
+        }
+        impl::cc_link_all(g, label, pending);
+      } while (allreduce<int64_t,collective_add>(v != end) > 0);
+    });
+    impl::cc_compress(g, label);
+    
+    // count components by their roots
+    call_on_all_cores([]{ impl::cc_roots = 0; impl::cc_giant = 0; });
+    auto root = impl::cc_parent(g, label, giant);
+    forall(g, [label,root](VertexID i, Vertex& v){
+      if (label(v) == i) impl::cc_roots++;
+      if (label(v) == root) impl::cc_giant++;
+    });
+    cc_giant_component_size = reduce<int64_t,collective_add>(&impl::cc_giant);
+    return reduce<int64_t,collective_add>(&impl::cc_roots);
+  }
+  
+  /// @}
+  
+} // namespace Grappa
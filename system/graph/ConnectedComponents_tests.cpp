@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <graph/ConnectedComponents.hpp>
+
+BOOST_AUTO_TEST_SUITE( ConnectedComponents_tests );
+
+using namespace Grappa;
+
+struct VData {
+  VertexID component;
+  VertexID reference;
+};
+
+using G = Graph<VData,Empty>;
+
+bool changed;
+
+/// Label propagation to a fixed point: each vertex takes the smallest
+/// label among its neighbors.
+int64_t reference_components(GlobalAddress<G> g) {
+  forall(g->vs, g->nv, [](VertexID i, G::Vertex& v){ v->reference = i; });
+  do {
+    call_on_all_cores([]{ changed = false; });
+    forall(g, [g](G::Vertex& v){
+      for (int64_t k = 0; k < v.nadj; k++) {
+        auto l = delegate::call(g->vs+v.local_adj[k], [](G::Vertex& w){ return w->reference; });
+        if (l < v->reference) {
+          v->reference = l;
+          changed = true;
+        }
+      }
+    });
+  } while (reduce<bool,collective_or>(&changed));
+  
+  call_on_all_cores([]{ changed = false; });
+  int64_t n = 0;
+  auto n_addr = make_global(&n);
+  forall(g, [n_addr](VertexID i, G::Vertex& v){
+    if (v->reference == i) delegate::increment<async>(n_addr, 1);
+  });
+  return n;
+}
+
+void check_components(GlobalAddress<G> g) {
+  auto expected = reference_components(g);
+  auto n = connected_components(g, [](G::Vertex& v) -> VertexID& { return v->component; });
+  BOOST_CHECK_EQUAL(n, expected);
+  forall(g, [](VertexID i, G::Vertex& v){
+    BOOST_CHECK_EQUAL(v->component, v->reference);
+  });
+}
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    // low-degree Kronecker graph: a giant component and many small ones
+    {
+      auto tg = TupleGraph::Kronecker(10, 2 << 10, 111, 222);
+      auto g = G::create(tg);
+      tg.destroy();
+      check_components(g);
+      g->destroy();
+    }
+    
+    // sparse grid: long paths, high diameter
+    {
+      auto tg = TupleGraph::Grid(16, 64, 0.6, 42);
+      auto g = G::create(tg);
+      tg.destroy();
+      check_components(g);
+      g->destroy();
+    }
+    
+    // full grid is one component
+    {
+      auto tg = TupleGraph::Grid(8, 32);
+      auto g = G::create(tg);
+      tg.destroy();
+      BOOST_CHECK_EQUAL(connected_components(g, [](G::Vertex& v) -> VertexID& { return v->component; }), 1);
+      g->destroy();
+    }
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
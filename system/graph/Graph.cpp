@@ -34,3 +34,197 @@
 
 #include "Graph.hpp"
 
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+DEFINE_int64( graph_stream_max_inflight, 64, "Maximum number of edge chunks each core may have in flight while streaming graph construction" );
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, graph_core_adj_min, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, graph_core_adj_max, 0);
+
+namespace Grappa {
+
+VertexOrder vertex_order_from_string(const std::string& s) {
+  if (s == "original") return VertexOrder::Original;
+  if (s == "degree") return VertexOrder::Degree;
+  if (s == "balanced") return VertexOrder::Balanced;
+  LOG(FATAL) << "unknown vertex order: " << s;
+  return VertexOrder::Original;
+}
+
+namespace impl {
+
+/// Degrees at or above this share a bucket when ranking; the order among
+/// such hubs doesn't matter for balance.
+static const int64_t relabel_max_bucket = 1 << 20;
+
+/// Per-core state for relabel_by_degree().
+static int64_t relabel_max_degree;
+static std::vector<int64_t> relabel_next_rank;
+
+VertexRelabeling relabel_by_degree(const TupleGraph& tg, int64_t nv,
+                                   bool directed, VertexOrder order) {
+  CHECK(order != VertexOrder::Original);
+  
+  auto deg = global_alloc<int64_t>(nv);
+  Grappa::forall(deg, nv, [](int64_t& d){ d = 0; });
+  Grappa::forall(tg.edges, tg.nedge, [deg,directed](TupleGraph::Edge& e){
+    delegate::increment<SyncMode::Async>(deg+e.v0, 1);
+    if (!directed) delegate::increment<SyncMode::Async>(deg+e.v1, 1);
+  });
+  
+  call_on_all_cores([]{ relabel_max_degree = 0; });
+  Grappa::forall(deg, nv, [](int64_t& d){
+    if (d > relabel_max_degree) relabel_max_degree = d;
+  });
+  int64_t nbucket = std::min(reduce<int64_t,collective_max>(&relabel_max_degree),
+                             relabel_max_bucket-1) + 1;
+  
+  auto counters = global_alloc<int64_t>(nbucket);
+  Grappa::forall(counters, nbucket, [](int64_t& c){ c = 0; });
+  
+  // rank by decreasing degree: each core counts its vertices per degree,
+  // reserves a range of ranks in each bucket, then hands them out locally
+  on_all_cores([=]{
+    std::vector<int64_t> local(nbucket, 0);
+    for (auto& d : iterate_local(deg, nv)) local[std::min(d, nbucket-1)]++;
+    
+    // allreduce payloads must be in locale shared memory
+    auto total = locale_alloc<int64_t>(nbucket);
+    std::copy(local.begin(), local.end(), total);
+    allreduce_inplace<int64_t,collective_add>(total, nbucket);
+    
+    relabel_next_rank.assign(nbucket, 0);
+    int64_t above = 0;
+    for (int64_t b = nbucket-1; b >= 0; b--) {
+      if (local[b] > 0) {
+        relabel_next_rank[b] = above + delegate::fetch_and_add(counters+b, local[b]);
+      }
+      above += total[b];
+    }
+    locale_free(total);
+  });
+  
+  VertexRelabeling r;
+  r.internal_ids = global_alloc<VertexID>(nv);
+  r.original_ids = global_alloc<VertexID>(nv);
+  int64_t nc = cores();
+  
+  Grappa::forall(deg, nv, [=](int64_t i, int64_t& d){
+    int64_t id = relabel_next_rank[std::min(d, nbucket-1)]++;
+    if (order == VertexOrder::Balanced) {
+      // Vertex IDs are dealt to cores cyclically; reverse every other
+      // round so the biggest vertex of each round alternates between the
+      // first and last core (the final partial round stays in order).
+      int64_t round = id / nc, slot = id % nc;
+      if (round % 2 == 1 && (round+1)*nc <= nv) slot = nc-1-slot;
+      id = round*nc + slot;
+    }
+    delegate::write<SyncMode::Async>(r.internal_ids+i, id);
+    delegate::write<SyncMode::Async>(r.original_ids+id, i);
+  });
+  
+  call_on_all_cores([]{ relabel_next_rank.clear(); });
+  global_free(counters);
+  global_free(deg);
+  return r;
+}
+
+static const char graph_snapshot_magic[8] = { 'G','R','P','G','R','A','F','1' };
+
+SnapshotPath snapshot_path(const std::string& path) {
+  SnapshotPath p;
+  CHECK_LT(path.size(), sizeof(p.name)) << "snapshot path too long: " << path;
+  strncpy(p.name, path.c_str(), sizeof(p.name));
+  return p;
+}
+
+std::string snapshot_filename(const SnapshotPath& path, Core core) {
+  std::stringstream ss;
+  ss << path.name << "." << core;
+  return ss.str();
+}
+
+static int64_t align_section(int64_t offset) {
+  return (offset + block_size - 1) / block_size * block_size;
+}
+
+void snapshot_layout(GraphSnapshotHeader * h) {
+  std::memcpy(h->magic, graph_snapshot_magic, sizeof(h->magic));
+  int64_t offset = align_section(sizeof(*h));
+  h->valid_offset = offset;
+  offset = align_section(offset + h->nlocal);
+  h->degree_offset = offset;
+  offset = align_section(offset + h->nlocal * sizeof(int64_t));
+  h->vertex_data_offset = offset;
+  offset = align_section(offset + h->nlocal * h->vertex_data_size);
+  h->adj_offset = offset;
+  offset = align_section(offset + h->nadj_local * sizeof(VertexID));
+  h->edge_data_offset = offset;
+  h->file_size = offset + h->nadj_local * h->edge_data_size;
+}
+
+GraphSnapshotFile::GraphSnapshotFile(const std::string& filename, bool use_mmap)
+  : fd_(-1)
+  , map_(nullptr)
+  , size_(0)
+{
+  PCHECK((fd_ = open(filename.c_str(), O_RDONLY)) >= 0) << "could not open graph snapshot " << filename;
+  struct stat st;
+  PCHECK(fstat(fd_, &st) == 0);
+  size_ = st.st_size;
+  CHECK_GE(size_, sizeof(header)) << "truncated graph snapshot " << filename;
+  
+  if (use_mmap) {
+    void * m = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_, 0);
+    PCHECK(m != MAP_FAILED) << "could not map graph snapshot " << filename;
+    map_ = static_cast<char*>(m);
+  }
+  
+  read(0, &header, sizeof(header));
+  CHECK_EQ(std::memcmp(header.magic, graph_snapshot_magic, sizeof(header.magic)), 0)
+    << filename << " is not a graph snapshot";
+  CHECK_GE(size_, header.file_size) << "truncated graph snapshot " << filename;
+}
+
+GraphSnapshotFile::~GraphSnapshotFile() {
+  if (map_) unmap(map_, size_);
+  close(fd_);
+}
+
+void GraphSnapshotFile::read(int64_t offset, void * dst, size_t bytes) {
+  if (map_) {
+    std::memcpy(dst, map_ + offset, bytes);
+    return;
+  }
+  char * p = static_cast<char*>(dst);
+  while (bytes > 0) {
+    ssize_t n = pread(fd_, p, bytes, offset);
+    PCHECK(n > 0) << "error reading graph snapshot";
+    p += n;
+    offset += n;
+    bytes -= n;
+  }
+}
+
+char * GraphSnapshotFile::mapped(int64_t offset) {
+  CHECK(map_) << "graph snapshot file not mapped";
+  return map_ + offset;
+}
+
+void * GraphSnapshotFile::release_map(size_t * size) {
+  void * m = map_;
+  *size = size_;
+  map_ = nullptr;
+  return m;
+}
+
+void GraphSnapshotFile::unmap(void * map, size_t size) {
+  PCHECK(munmap(map, size) == 0) << "could not unmap graph snapshot";
+}
+
+} // namespace impl
+} // namespace Grappa
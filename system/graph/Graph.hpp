@@ -42,10 +42,15 @@
 #include <Delegate.hpp>
 #include <AsyncDelegate.hpp>
 #include <Array.hpp>
+#include <ChunkSender.hpp>
 #include "TupleGraph.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
 
 // #define USE_MPI3_COLLECTIVES
 #undef USE_MPI3_COLLECTIVES
@@ -53,6 +58,11 @@
 #include <mpi.h>
 #endif
 
+DECLARE_int64( graph_stream_max_inflight );
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, graph_core_adj_min);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, graph_core_adj_max);
+
 namespace Grappa {
   /// @addtogroup Graph
   /// @{
@@ -63,6 +73,19 @@ namespace Grappa {
   /// Empty struct, for specifying lack of either Vertex or Edge data in @ref Graph.
   struct Empty {};
   
+  /// How Graph::create() numbers vertices internally (which decides the
+  /// core each vertex lives on). User-visible IDs can always be recovered
+  /// with Graph::original_id().
+  enum class VertexOrder {
+    Original, ///< keep input IDs (vertices dealt cyclically by ID)
+    Degree,   ///< renumber by decreasing degree, spreading hubs over cores
+    Balanced  ///< like Degree, but dealt back and forth so every core gets
+              ///  about the same number of edges (and its hubs first)
+  };
+  
+  /// Parse "original", "degree" or "balanced" (e.g. from a flag).
+  VertexOrder vertex_order_from_string(const std::string& s);
+  
   namespace impl {
     
     struct VertexBase {
@@ -136,6 +159,120 @@ namespace Grappa {
       static constexpr size_t size() { return locale_heap_size() + global_heap_size(); }
       
     } GRAPPA_BLOCK_ALIGNED;
+    
+    /// Header at the start of each per-core file written by
+    /// Graph::save_snapshot(). Section offsets are from the start of the
+    /// file and block-aligned, so sections can be used in place when the
+    /// file is mapped.
+    struct GraphSnapshotHeader {
+      char magic[8];
+      int64_t ncores, core, start_core;
+      int64_t nv, nadj, nlocal, nadj_local;
+      int64_t vertex_data_size, edge_data_size;
+      int64_t valid_offset, degree_offset, vertex_data_offset, adj_offset, edge_data_offset;
+      int64_t file_size;
+    };
+    
+    /// Snapshot path in a fixed-size buffer, so it can be captured by
+    /// lambdas sent to other cores.
+    struct SnapshotPath { char name[1024]; };
+    
+    SnapshotPath snapshot_path(const std::string& path);
+    
+    /// Name of the file holding `core`'s part of the snapshot.
+    std::string snapshot_filename(const SnapshotPath& path, Core core);
+    
+    /// Fill in the magic and section offsets of a header whose counts and
+    /// element sizes are already set.
+    void snapshot_layout(GraphSnapshotHeader * h);
+    
+    /// Index of the k'th local vertex in a snapshot file. A Vertex is
+    /// exactly one block, so vertices were dealt to cores round-robin
+    /// starting at the core holding the start of the vertex array.
+    inline VertexID snapshot_vertex_id(const GraphSnapshotHeader& h, int64_t k) {
+      return (h.core - h.start_core + h.ncores) % h.ncores + k * h.ncores;
+    }
+    
+    /// One core's snapshot file, opened for reading either with read()
+    /// or by mapping it privately (copy-on-write) into memory.
+    class GraphSnapshotFile {
+      int fd_;
+      char * map_;
+      size_t size_;
+    public:
+      GraphSnapshotHeader header;
+      
+      GraphSnapshotFile(const std::string& filename, bool use_mmap);
+      ~GraphSnapshotFile();
+      
+      /// Copy `bytes` bytes starting at file offset `offset` into `dst`.
+      void read(int64_t offset, void * dst, size_t bytes);
+      
+      /// Pointer into the mapped file (only valid when opened with mmap).
+      char * mapped(int64_t offset);
+      
+      /// Give up ownership of the mapping; it must later be passed to unmap().
+      void * release_map(size_t * size);
+      
+      static void unmap(void * map, size_t size);
+    };
+    
+    /// Vertex renumbering computed by relabel_by_degree().
+    struct VertexRelabeling {
+      GlobalAddress<VertexID> internal_ids; ///< input ID -> internal ID
+      GlobalAddress<VertexID> original_ids; ///< internal ID -> input ID
+    };
+    
+    /// Renumber the `nv` vertices of `tg` in the given order (not
+    /// VertexOrder::Original), based on their degree in `tg`.
+    VertexRelabeling relabel_by_degree(const TupleGraph& tg, int64_t nv,
+                                       bool directed, VertexOrder order);
+    
+    /// Number of (vertex, neighbor) edges Graph::create_streaming() batches
+    /// per destination core before handing them to its ChunkSender; also
+    /// the size of each chunk sent.
+    const size_t stream_edge_batch = 64;
+    
+    /// Run `source` on this core, sending each edge it produces (and its
+    /// reverse, if undirected) to the core owning the edge's first vertex
+    /// in `vs`, where `deliver(vertex, neighbor)` is called in a message
+    /// handler. Adjacencies are buffered per destination core and at most
+    /// --graph_stream_max_inflight chunks are outstanding, so memory use is
+    /// bounded no matter how much the source produces. Returns once
+    /// everything sent from this core has been delivered.
+    template< typename T, typename Source, typename Deliver >
+    void stream_adjacencies(GlobalAddress<T> vs, bool directed, Source source, Deliver deliver) {
+      std::vector<std::vector<TupleGraph::Edge>> out(cores());
+      ChunkSender sender(FLAGS_graph_stream_max_inflight);
+      
+      auto flush = [&out,&sender,deliver](Core dest) {
+        auto& c = out[dest];
+        if (c.empty()) return;
+        sender.send<stream_edge_batch * sizeof(TupleGraph::Edge)>(dest, c.data(), c.size(),
+            [deliver](const TupleGraph::Edge * es, size_t n, size_t offset){
+          for (size_t i=0; i<n; i++) deliver(es[i].v0, es[i].v1);
+        });
+        c.clear();
+      };
+      
+      auto add = [&out,&flush,vs](VertexID v, VertexID adj) {
+        Core dest = (vs+v).core();
+        auto& c = out[dest];
+        c.push_back(TupleGraph::Edge{v, adj});
+        if (c.size() == stream_edge_batch) flush(dest);
+      };
+      
+      TupleGraph::EdgeSink sink = [&add,directed](const TupleGraph::Edge* es, size_t n) {
+        for (size_t i=0; i<n; i++) {
+          add(es[i].v0, es[i].v1);
+          if (!directed) add(es[i].v1, es[i].v0);
+        }
+      };
+      source(sink);
+      
+      for (Core c=0; c<cores(); c++) flush(c);
+      sender.wait();
+    }
   
   }
   
@@ -227,6 +364,17 @@ namespace Grappa {
   /// forall(g, [](const G::Edge& e, G::Vertex& dst){ ... });
   /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   /// 
+  /// Snapshots
+  /// ----------
+  /// 
+  /// A constructed graph can be saved with `g->save_snapshot(path)`, which
+  /// writes each core's vertices and adjacencies to its own file
+  /// (`<path>.<core>`), and restored with `G::load_snapshot(path)`. With
+  /// the same number of cores, each core maps (or reads) its own file and
+  /// no data moves between cores; otherwise the vertices and edges are
+  /// redistributed to their new homes. Vertex and edge data are copied
+  /// bytewise, so they must not contain pointers.
+  /// 
   /// Iteration over adjacencies of single Vertex:
   /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   /// // usually done inside another iteration over vertices, like so:
@@ -280,6 +428,14 @@ namespace Grappa {
     VertexID * adj_buf;
     EdgeState * edge_storage;
     
+    // Mapping between input and internal vertex IDs (if relabeled)
+    bool relabeled;
+    GlobalAddress<VertexID> original_ids, internal_ids;
+    
+    // Snapshot file mapping holding adj_buf and edge_storage, if loaded with mmap
+    void * snapshot_map;
+    size_t snapshot_map_size;
+    
     // Temporary internal state
     void* scratch;
     
@@ -292,6 +448,12 @@ namespace Grappa {
       , nadj(0)
       , nadj_local(0)
       , adj_buf(nullptr)
+      , edge_storage(nullptr)
+      , relabeled(false)
+      , original_ids()
+      , internal_ids()
+      , snapshot_map(nullptr)
+      , snapshot_map_size(0)
       , scratch(nullptr)
     { }
   
@@ -301,14 +463,19 @@ namespace Grappa {
         for (int64_t i=0; i<nadj_local; i++) {
           edge_storage[i].~E();
         }
-        locale_free(edge_storage);
+        if (!snapshot_map) locale_free(edge_storage);
       }
-      if (adj_buf) locale_free(adj_buf);
+      if (adj_buf && !snapshot_map) locale_free(adj_buf);
+      if (snapshot_map) impl::GraphSnapshotFile::unmap(snapshot_map, snapshot_map_size);
     }
   
     void destroy() {
       auto self = this->self;
       global_free(this->vs);
+      if (relabeled) {
+        global_free(original_ids);
+        global_free(internal_ids);
+      }
       call_on_all_cores([self]{ self->~Graph(); });
       global_free(self);
     }
@@ -367,15 +534,54 @@ namespace Grappa {
     }
     
     // Constructor
-    static GlobalAddress<Graph> create(const TupleGraph& tg, bool directed = false, bool solo_invalid = true);
+    static GlobalAddress<Graph> create(const TupleGraph& tg, bool directed = false, bool solo_invalid = true,
+                                       VertexOrder order = VertexOrder::Original);
+    
+    /// Construct a graph with `nv` vertices from edges streamed by
+    /// `source`, without materializing a TupleGraph. See the
+    /// out-of-line definition for details.
+    template< typename Source >
+    static GlobalAddress<Graph> create_streaming(int64_t nv, Source source,
+                                                 bool directed = false, bool solo_invalid = true);
     
     static GlobalAddress<Graph> Undirected(const TupleGraph& tg) { return create(tg, false); }
     static GlobalAddress<Graph> Directed(const TupleGraph& tg) { return create(tg, true); }
+    
+    /// Write each core's vertices and adjacencies to `<path>.<core>`.
+    void save_snapshot(const std::string& path);
+    
+    /// Restore a graph written by save_snapshot(). If the snapshot was
+    /// taken on the same number of cores, every core maps (or, without
+    /// `use_mmap`, reads) its own file in place; otherwise falls back to
+    /// load_snapshot_repartition().
+    static GlobalAddress<Graph> load_snapshot(const std::string& path, bool use_mmap = true);
+    
+    /// Restore a graph written by save_snapshot() on any number of cores,
+    /// sending each vertex and adjacency to its home in a fresh layout.
+    static GlobalAddress<Graph> load_snapshot_repartition(const std::string& path);
       
     VertexID id(Vertex& v) {
       return make_linear(&v) - vs;
     }
     
+    /// Input ID of the vertex with internal ID `i` (its index in `vs`).
+    /// Identical unless the graph was created with a VertexOrder other
+    /// than Original. (The mapping is not kept by save_snapshot().)
+    VertexID original_id(VertexID i) {
+      return relabeled ? delegate::read(original_ids+i) : i;
+    }
+    
+    /// Internal ID (index in `vs`) of the vertex with input ID `o`.
+    VertexID internal_id(VertexID o) {
+      return relabeled ? delegate::read(internal_ids+o) : o;
+    }
+    
+    /// Position of local vertex `v` among this core's vertices (the order
+    /// of `iterate_local(vs, nv)`); used to index VertexColumn.
+    int64_t local_index(Vertex& v) {
+      return &v - vs.localize();
+    }
+    
     Edge edge(Vertex& v, size_t i) {
       auto j = v.local_adj[i];
       return Edge{ j, vs+j, v.local_edge_state[i] };
@@ -616,16 +822,21 @@ namespace Grappa {
   /// @param solo_invalid  mark vertices with no in- or out-edges as 
   ///                      invalid (not to be visited when iterating 
   ///                      over vertices)
+  /// @param order         internal vertex numbering; anything other than
+  ///                      VertexOrder::Original builds the graph from a
+  ///                      renamed copy of `tg` (temporarily doubling the
+  ///                      edge list) and keeps the ID mapping
   template< typename V, typename E >
-  GlobalAddress<Graph<V,E>> Graph<V,E>::create(const TupleGraph& tg,
-      bool directed, bool solo_invalid) {
+  GlobalAddress<Graph<V,E>> Graph<V,E>::create(const TupleGraph& tg_in,
+      bool directed, bool solo_invalid, VertexOrder order) {
     VLOG(1) << "Graph: " << (directed ? "directed" : "undirected");
     double t;
     auto g = symmetric_global_alloc<Graph>();
     
-    // find nv
+    // find nv (symmetric storage may be reused from a destroyed graph)
         t = walltime();
-    forall(tg.edges, tg.nedge, [g](TupleGraph::Edge& e){
+    call_on_all_cores([g]{ g->nv = 0; });
+    forall(tg_in.edges, tg_in.nedge, [g](TupleGraph::Edge& e){
       if (e.v0 > g->nv) { g->nv = e.v0; }
       if (e.v1 > g->nv) { g->nv = e.v1; }
     });
@@ -633,11 +844,26 @@ namespace Grappa {
       g->nv = Grappa::allreduce<int64_t,collective_max>(g->nv) + 1;
     });
         VLOG(2) << "find_nv_time: " << walltime() - t;
+    
+    // optionally renumber vertices, then build from the renamed edges
+    TupleGraph tg = tg_in;
+    impl::VertexRelabeling relabeling;
+    if (order != VertexOrder::Original) {
+      t = walltime();
+      relabeling = impl::relabel_by_degree(tg_in, g->nv, directed, order);
+      tg = tg_in.relabeled(relabeling.internal_ids);
+      VLOG(2) << "relabel_time: " << walltime() - t;
+    }
 
     auto vs = global_alloc<Vertex>(g->nv);
     auto self = g;
-    on_all_cores([g,vs]{
+    on_all_cores([g,vs,order,relabeling]{
       new (g.localize()) Graph(g, vs, g->nv);
+      if (order != VertexOrder::Original) {
+        g->relabeled = true;
+        g->original_ids = relabeling.original_ids;
+        g->internal_ids = relabeling.internal_ids;
+      }
       for (Vertex& v : iterate_local(g->vs, g->nv)) {
         new (&v) Vertex();
       }
@@ -754,6 +980,16 @@ namespace Grappa {
       // compute total nadj
       g->nadj = allreduce<int64_t,collective_add>(g->nadj_local);
       
+      // report edge balance (forall edge loops are bounded by the fullest core)
+      auto adj_min = allreduce<int64_t,collective_min>(g->nadj_local);
+      auto adj_max = allreduce<int64_t,collective_max>(g->nadj_local);
+      if (mycore() == 0) {
+        graph_core_adj_min = adj_min;
+        graph_core_adj_max = adj_max;
+        LOG(INFO) << "adjacencies per core: min " << adj_min << ", mean "
+                  << g->nadj / cores() << ", max " << adj_max;
+      }
+      
       size_t offset = 0;
       for (Vertex& v : iterate_local(g->vs, g->nv)) {
         auto adj = g->adj_buf + offset;
@@ -776,6 +1012,8 @@ namespace Grappa {
     }    
     VLOG(1) << "-- vertices: " << g->nv;
     
+    if (order != VertexOrder::Original) tg.destroy();
+    
     auto gsz = Vertex::global_heap_size()*g->nv
                           + sizeof(Graph) * cores();
     auto lsz = Vertex::locale_heap_size()*g->nv
@@ -788,5 +1026,327 @@ namespace Grappa {
     return g;
   }
   
+  /// @brief Construct a distributed adjacency-list Graph from a stream of edges.
+  /// 
+  /// Unlike create(), the edge list is never stored: edges are routed
+  /// straight from the source to the cores owning their vertices, and
+  /// each core builds its adjacency lists in place. Peak memory is the
+  /// final graph (plus room for duplicate edges until they are removed)
+  /// and bounded per-core send buffers.
+  /// 
+  /// @param nv            number of vertices (edge endpoints must be < nv)
+  /// @param source        run on every core, twice (once to count degrees,
+  ///                      once to fill adjacencies), and must produce the
+  ///                      same edges each time:
+  ///                      `void(const TupleGraph::EdgeSink& sink)`
+  /// @param directed      create additional edges to make it undirected
+  /// @param solo_invalid  mark vertices with no in- or out-edges as invalid
+  /// 
+  /// Example:
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// auto g = G::create_streaming(1L << scale, [=](const TupleGraph::EdgeSink& sink){
+  ///   TupleGraph::stream_kronecker(scale, nedge, seed1, seed2, sink);
+  /// });
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  template< typename V, typename E >
+  template< typename Source >
+  GlobalAddress<Graph<V,E>> Graph<V,E>::create_streaming(int64_t nv, Source source,
+      bool directed, bool solo_invalid) {
+    VLOG(1) << "Graph (streaming): " << (directed ? "directed" : "undirected");
+    double t;
+    auto g = symmetric_global_alloc<Graph>();
+    auto vs = global_alloc<Vertex>(nv);
+    on_all_cores([g,vs,nv]{
+      new (g.localize()) Graph(g, vs, nv);
+      for (Vertex& v : iterate_local(vs, nv)) new (&v) Vertex();
+    });
+    
+    // count adjacencies (including duplicates) at each vertex's home
+    t = walltime();
+    on_all_cores([g,directed,source]{
+      impl::stream_adjacencies(g->vs, directed, source, [g](VertexID vi, VertexID adj){
+        CHECK_LT(vi, g->nv); CHECK_LT(adj, g->nv);
+        (g->vs+vi).pointer()->local_sz++;
+      });
+    });
+    VLOG(2) << "count_time: " << walltime() - t;
+    
+    // carve each core's adjacency lists out of a single local buffer
+    on_all_cores([g]{
+      int64_t total = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) total += v.local_sz;
+      g->adj_buf = locale_alloc<VertexID>(total);
+      int64_t offset = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        v.local_adj = g->adj_buf + offset;
+        v.nadj = 0;
+        offset += v.local_sz;
+      }
+    });
+    
+    // stream again, filling adjacency lists
+    t = walltime();
+    on_all_cores([g,directed,source]{
+      impl::stream_adjacencies(g->vs, directed, source, [g](VertexID vi, VertexID adj){
+        auto& v = *(g->vs+vi).pointer();
+        v.local_adj[v.nadj++] = adj;
+      });
+    });
+    VLOG(2) << "scatter_time: " << walltime() - t;
+    
+    // sort & de-dup each list, sliding lists down to close the gaps
+    on_all_cores([g]{
+      int64_t offset = 0, total = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        CHECK_EQ(v.nadj, v.local_sz);
+        total += v.local_sz;
+        std::sort(v.local_adj, v.local_adj+v.nadj);
+        v.nadj = std::unique(v.local_adj, v.local_adj+v.nadj) - v.local_adj;
+        std::memmove(g->adj_buf+offset, v.local_adj, v.nadj*sizeof(VertexID));
+        v.local_adj = g->adj_buf+offset;
+        v.local_sz = v.nadj;
+        offset += v.nadj;
+      }
+      g->nadj_local = offset;
+      
+      // give back the space duplicates took by moving into an exact-size buffer
+      if (offset < total) {
+        auto adj_buf = locale_alloc<VertexID>(offset);
+        std::memcpy(adj_buf, g->adj_buf, offset*sizeof(VertexID));
+        for (Vertex& v : iterate_local(g->vs, g->nv)) {
+          v.local_adj = adj_buf + (v.local_adj - g->adj_buf);
+        }
+        locale_free(g->adj_buf);
+        g->adj_buf = adj_buf;
+      }
+      
+      g->edge_storage = locale_alloc<EdgeState>(g->nadj_local);
+      for (size_t i=0; i<g->nadj_local; i++) {
+        new (g->edge_storage+i) EdgeState();
+      }
+      offset = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        v.local_edge_state = g->edge_storage+offset;
+        offset += v.nadj;
+      }
+      
+      g->nadj = allreduce<int64_t,collective_add>(g->nadj_local);
+    });
+    
+    if (solo_invalid) {
+      forall(g, [](Vertex& v){ v.valid = (v.nadj > 0); });
+      forall(g, [](Edge& e, Vertex& ve){ ve.valid = true; });
+    }
+    VLOG(1) << "-- vertices: " << g->nv << ", adjacencies: " << g->nadj;
+    return g;
+  }
+  
+  template< typename V, typename E >
+  void Graph<V,E>::save_snapshot(const std::string& path) {
+    auto g = self;
+    auto p = impl::snapshot_path(path);
+    on_all_cores([g,p]{
+      impl::GraphSnapshotHeader h;
+      h.ncores = cores();
+      h.core = mycore();
+      h.start_core = g->vs.core();
+      h.nv = g->nv;
+      h.nadj = g->nadj;
+      h.nlocal = iterate_local(g->vs, g->nv).size();
+      h.nadj_local = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) h.nadj_local += v.nadj;
+      h.vertex_data_size = sizeof(V);
+      h.edge_data_size = sizeof(E);
+      impl::snapshot_layout(&h);
+      
+      auto filename = impl::snapshot_filename(p, mycore());
+      std::ofstream out(filename, std::ios_base::binary | std::ios_base::trunc);
+      CHECK(out) << "could not create graph snapshot " << filename;
+      out.write(reinterpret_cast<char*>(&h), sizeof(h));
+      
+      std::vector<uint8_t> valid;
+      std::vector<int64_t> degree;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        valid.push_back(v.valid);
+        degree.push_back(v.nadj);
+      }
+      out.seekp(h.valid_offset);
+      out.write(reinterpret_cast<char*>(valid.data()), valid.size());
+      out.seekp(h.degree_offset);
+      out.write(reinterpret_cast<char*>(degree.data()), degree.size()*sizeof(int64_t));
+      
+      out.seekp(h.vertex_data_offset);
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        out.write(reinterpret_cast<const char*>(&v.data), sizeof(V));
+      }
+      out.seekp(h.adj_offset);
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        out.write(reinterpret_cast<const char*>(v.local_adj), v.nadj*sizeof(VertexID));
+      }
+      out.seekp(h.edge_data_offset);
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        out.write(reinterpret_cast<const char*>(v.local_edge_state), v.nadj*sizeof(E));
+      }
+      CHECK(out) << "error writing graph snapshot " << filename;
+    });
+  }
+  
+  template< typename V, typename E >
+  GlobalAddress<Graph<V,E>> Graph<V,E>::load_snapshot(const std::string& path, bool use_mmap) {
+    auto p = impl::snapshot_path(path);
+    auto h0 = impl::GraphSnapshotFile(impl::snapshot_filename(p, 0), false).header;
+    CHECK_EQ(h0.vertex_data_size, sizeof(V)) << "snapshot vertex data type doesn't match";
+    CHECK_EQ(h0.edge_data_size, sizeof(E)) << "snapshot edge data type doesn't match";
+    
+    if (h0.ncores != cores()) {
+      LOG(INFO) << "Graph snapshot was written on " << h0.ncores << " cores; repartitioning";
+      return load_snapshot_repartition(path);
+    }
+    
+    auto g = symmetric_global_alloc<Graph>();
+    auto nv = h0.nv;
+    
+    // start the vertex array on the same core as before, so every core
+    // owns exactly the vertices in its file
+    auto vs = global_alloc<Vertex>(nv + cores());
+    while (vs.core() != h0.start_core) vs++;
+    
+    on_all_cores([g,vs,nv,p,use_mmap]{
+      new (g.localize()) Graph(g, vs, nv);
+      
+      impl::GraphSnapshotFile f(impl::snapshot_filename(p, mycore()), use_mmap);
+      auto& h = f.header;
+      CHECK_EQ(h.core, mycore());
+      CHECK_EQ(h.nv, nv);
+      CHECK_EQ(h.nlocal, iterate_local(vs, nv).size());
+      g->nadj = h.nadj;
+      g->nadj_local = h.nadj_local;
+      
+      std::vector<uint8_t> valid(h.nlocal);
+      std::vector<int64_t> degree(h.nlocal);
+      std::vector<char> data(h.nlocal*sizeof(V));
+      f.read(h.valid_offset, valid.data(), valid.size());
+      f.read(h.degree_offset, degree.data(), degree.size()*sizeof(int64_t));
+      f.read(h.vertex_data_offset, data.data(), data.size());
+      
+      if (use_mmap) {
+        g->adj_buf = reinterpret_cast<VertexID*>(f.mapped(h.adj_offset));
+        g->edge_storage = reinterpret_cast<EdgeState*>(f.mapped(h.edge_data_offset));
+        g->snapshot_map = f.release_map(&g->snapshot_map_size);
+      } else {
+        g->adj_buf = locale_alloc<VertexID>(h.nadj_local);
+        g->edge_storage = locale_alloc<EdgeState>(h.nadj_local);
+        f.read(h.adj_offset, g->adj_buf, h.nadj_local*sizeof(VertexID));
+        f.read(h.edge_data_offset, g->edge_storage, h.nadj_local*sizeof(E));
+      }
+      
+      int64_t k = 0, offset = 0;
+      for (Vertex& v : iterate_local(vs, nv)) {
+        new (&v) Vertex();
+        std::memcpy(&v.data, &data[k*sizeof(V)], sizeof(V));
+        v.valid = valid[k];
+        v.nadj = v.local_sz = degree[k];
+        v.local_adj = g->adj_buf + offset;
+        v.local_edge_state = g->edge_storage + offset;
+        offset += v.nadj;
+        k++;
+      }
+      CHECK_EQ(offset, h.nadj_local);
+    });
+    return g;
+  }
+  
+  template< typename V, typename E >
+  GlobalAddress<Graph<V,E>> Graph<V,E>::load_snapshot_repartition(const std::string& path) {
+    auto p = impl::snapshot_path(path);
+    auto h0 = impl::GraphSnapshotFile(impl::snapshot_filename(p, 0), false).header;
+    CHECK_EQ(h0.vertex_data_size, sizeof(V)) << "snapshot vertex data type doesn't match";
+    CHECK_EQ(h0.edge_data_size, sizeof(E)) << "snapshot edge data type doesn't match";
+    int64_t nfiles = h0.ncores;
+    auto nv = h0.nv;
+    
+    auto g = symmetric_global_alloc<Graph>();
+    auto vs = global_alloc<Vertex>(nv);
+    on_all_cores([g,vs,nv]{
+      new (g.localize()) Graph(g, vs, nv);
+      for (Vertex& v : iterate_local(vs, nv)) new (&v) Vertex();
+    });
+    
+    // send validity, degree and data of each saved vertex to its new home
+    struct VertexBytes { char bytes[sizeof(V)]; };
+    finish([g,p,nfiles]{
+      on_all_cores([g,p,nfiles]{
+        for (int64_t fi = mycore(); fi < nfiles; fi += cores()) {
+          impl::GraphSnapshotFile f(impl::snapshot_filename(p, fi), true);
+          auto& h = f.header;
+          auto valid = reinterpret_cast<uint8_t*>(f.mapped(h.valid_offset));
+          auto degree = reinterpret_cast<int64_t*>(f.mapped(h.degree_offset));
+          auto data = f.mapped(h.vertex_data_offset);
+          for (int64_t k = 0; k < h.nlocal; k++) {
+            auto vaddr = g->vs + impl::snapshot_vertex_id(h, k);
+            bool vvalid = valid[k];
+            int64_t d = degree[k];
+            VertexBytes b;
+            std::memcpy(b.bytes, data + k*sizeof(V), sizeof(V));
+            delegate::call<SyncMode::Async>(vaddr.core(), [vaddr,vvalid,d,b]{
+              auto& v = *vaddr.pointer();
+              std::memcpy(&v.data, b.bytes, sizeof(V));
+              v.valid = vvalid;
+              v.nadj = v.local_sz = d;
+            });
+          }
+        }
+      });
+    });
+    
+    // allocate adjacency storage for the vertices each core now owns
+    on_all_cores([g]{
+      g->nadj_local = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) g->nadj_local += v.nadj;
+      g->adj_buf = locale_alloc<VertexID>(g->nadj_local);
+      g->edge_storage = locale_alloc<EdgeState>(g->nadj_local);
+      for (size_t i=0; i<g->nadj_local; i++) {
+        new (g->edge_storage+i) EdgeState();
+      }
+      g->nadj = allreduce<int64_t,collective_add>(g->nadj_local);
+      
+      size_t offset = 0;
+      for (Vertex& v : iterate_local(g->vs, g->nv)) {
+        v.local_adj = g->adj_buf + offset;
+        v.local_edge_state = g->edge_storage + offset;
+        offset += v.nadj;
+      }
+    });
+    
+    // scatter adjacencies and their edge data, keeping each list's order
+    struct EdgeBytes { char bytes[sizeof(E)]; };
+    finish([g,p,nfiles]{
+      on_all_cores([g,p,nfiles]{
+        for (int64_t fi = mycore(); fi < nfiles; fi += cores()) {
+          impl::GraphSnapshotFile f(impl::snapshot_filename(p, fi), true);
+          auto& h = f.header;
+          auto degree = reinterpret_cast<int64_t*>(f.mapped(h.degree_offset));
+          auto adj = reinterpret_cast<VertexID*>(f.mapped(h.adj_offset));
+          auto edata = f.mapped(h.edge_data_offset);
+          int64_t offset = 0;
+          for (int64_t k = 0; k < h.nlocal; k++) {
+            auto vaddr = g->vs + impl::snapshot_vertex_id(h, k);
+            for (int64_t i = 0; i < degree[k]; i++, offset++) {
+              VertexID j = adj[offset];
+              EdgeBytes e;
+              std::memcpy(e.bytes, edata + offset*sizeof(E), sizeof(E));
+              delegate::call<SyncMode::Async>(vaddr.core(), [vaddr,i,j,e]{
+                auto& v = *vaddr.pointer();
+                v.local_adj[i] = j;
+                std::memcpy(&v.local_edge_state[i], e.bytes, sizeof(E));
+              });
+            }
+          }
+        }
+      });
+    });
+    return g;
+  }
+  
   /// @}
 } // namespace Grappa
@@ -33,9 +33,12 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include <boost/test/unit_test.hpp>
+#include <cstdio>
 #include <Grappa.hpp>
 #include <graph/Graph.hpp>
 #include <GlobalVector.hpp>
+#include "graph_generator.h"
+#include "utils.h"
 
 BOOST_AUTO_TEST_SUITE( Graph_tests );
 
@@ -61,6 +64,30 @@ DEFINE_int32(scale, 10, "Log2 number of vertices.");
 GRAPPA_DEFINE_METRIC(SummarizingMetric<int64_t>, degree, 0);
 GRAPPA_DEFINE_METRIC(SummarizingMetric<double>, edge_weight, 0);
 
+/// Check that graphs `h` and `g` have the same vertices, adjacencies and
+/// vertex/edge state.
+void check_same_graph(GlobalAddress<MyGraph> h, GlobalAddress<MyGraph> g) {
+  CHECK_EQ(h->nv, g->nv);
+  CHECK_EQ(h->nadj, g->nadj);
+  forall(h, [g](VertexID i, MyGraph::Vertex& v){
+    struct Summary { int64_t nadj, parent, adj_sum; double weight_sum; };
+    auto summarize = [](MyGraph::Vertex& v) {
+      Summary s = { v.nadj, v->parent, 0, 0.0 };
+      for (int64_t k = 0; k < v.nadj; k++) {
+        s.adj_sum += (k+1) * v.local_adj[k];
+        s.weight_sum += v.local_edge_state[k].weight;
+      }
+      return s;
+    };
+    auto mine = summarize(v);
+    auto orig = delegate::call(g->vs+i, summarize);
+    CHECK_EQ(mine.nadj, orig.nadj);
+    CHECK_EQ(mine.parent, orig.parent);
+    CHECK_EQ(mine.adj_sum, orig.adj_sum);
+    CHECK_EQ(mine.weight_sum, orig.weight_sum);
+  });
+}
+
 BOOST_AUTO_TEST_CASE( test1 ) {
   init( GRAPPA_TEST_ARGS );
   run([]{
@@ -107,6 +134,87 @@ BOOST_AUTO_TEST_CASE( test1 ) {
       edge_weight += e->weight;
     });
     
+    /////////////////////////////////
+    // test snapshot save & restore
+    forall(g, [](VertexID i, MyGraph::Vertex& v){ v->parent = i; });
+    forall(g, [](MyGraph::Vertex& v, MyGraph::Edge& e){ e->weight = 0.5 * e.id; });
+    
+    g->save_snapshot("/tmp/Graph_tests.snapshot");
+    for (auto h : { MyGraph::load_snapshot("/tmp/Graph_tests.snapshot"),
+                    MyGraph::load_snapshot("/tmp/Graph_tests.snapshot", false),
+                    MyGraph::load_snapshot_repartition("/tmp/Graph_tests.snapshot") }) {
+      check_same_graph(h, g);
+      h->destroy();
+    }
+    on_all_cores([]{
+      auto p = impl::snapshot_path("/tmp/Graph_tests.snapshot");
+      std::remove(impl::snapshot_filename(p, mycore()).c_str());
+    });
+    
+    /////////////////////////////////////////////////
+    // test streaming construction matches create()
+    {
+      auto h = MyGraph::create_streaming(g->nv, [tg](const TupleGraph::EdgeSink& sink){
+        for (auto& e : iterate_local(tg.edges, tg.nedge)) sink(&e, 1);
+      });
+      forall(h, [](VertexID i, MyGraph::Vertex& v){ v->parent = i; });
+      forall(h, [](MyGraph::Vertex& v, MyGraph::Edge& e){ e->weight = 0.5 * e.id; });
+      check_same_graph(h, g);
+      h->destroy();
+      
+      auto k = MyGraph::create_streaming(nv, [scale,ne](const TupleGraph::EdgeSink& sink){
+        TupleGraph::stream_kronecker(scale, ne, 11111, 22222, sink, 1000);
+      });
+      CHECK_EQ(k->nv, nv);
+      CHECK_EQ(k->nadj, g->nadj);
+      k->destroy();
+    }
+    
+    ////////////////////////////////////////////////////////////
+    // test batched generator against the reference generator
+    on_all_cores([scale]{
+      int64_t start = 12345 * mycore() + 3, n = 1001;
+      std::vector<packed_edge> ref(n);
+      std::vector<TupleGraph::Edge> mine(n);
+      uint_fast32_t seed[5];
+      make_mrg_seed(11111, 22222, seed);
+      generate_kronecker_range(seed, scale, start, start+n, ref.data());
+      TupleGraph::generate_kronecker(scale, 11111, 22222, start, start+n, mine.data());
+      for (int64_t i = 0; i < n; i++) {
+        CHECK_EQ(mine[i].v0, ref[i].v0);
+        CHECK_EQ(mine[i].v1, ref[i].v1);
+      }
+      TupleGraph::generate_kronecker(scale, 11111, 22222, start, start+n, mine.data(),
+                                     TupleGraph::KroneckerRNG::Counter);
+      for (auto& e : mine) for (auto v : {e.v0, e.v1}) CHECK(v >= 0 && v < (1L << scale));
+    });
+    
+    ////////////////////////////////////////////////////////////////
+    // test relabeled construction: same edges under the ID mapping
+    for (auto order : { VertexOrder::Degree, VertexOrder::Balanced }) {
+      auto h = MyGraph::create(tg, false, true, order);
+      CHECK_EQ(h->nv, g->nv);
+      CHECK_EQ(h->nadj, g->nadj);
+      CHECK_LE(graph_core_adj_min, graph_core_adj_max);
+      
+      forall(h->vs, h->nv, [h,g](VertexID i, MyGraph::Vertex& v){
+        auto o = h->original_id(i);
+        CHECK_EQ(h->internal_id(o), i);
+        
+        std::vector<VertexID> mine;
+        for (int64_t k = 0; k < v.nadj; k++) mine.push_back(h->original_id(v.local_adj[k]));
+        std::sort(mine.begin(), mine.end());
+        
+        auto n = delegate::call(g->vs+o, [](MyGraph::Vertex& w){ return w.nadj; });
+        CHECK_EQ(mine.size(), n);
+        for (int64_t k = 0; k < n; k++) {
+          auto j = delegate::call(g->vs+o, [k](MyGraph::Vertex& w){ return w.local_adj[k]; });
+          CHECK_EQ(mine[k], j);
+        }
+      });
+      h->destroy();
+    }
+    
     ///////////////////////////
     // test 'transform'
     struct Data { int64_t parent; double w; };
@@ -33,35 +33,280 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include "graph_generator.h"
+#include "splittable_mrg.h"
 #include "utils.h"
 #include "TupleGraph.hpp"
 #include "ParallelLoop.hpp"
+#include "Hashing.hpp"
 
-namespace Grappa {
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
-  TupleGraph TupleGraph::Kronecker(int scale, int64_t nedge, 
-                                            uint64_t seed1, uint64_t seed2) {    
-    static_assert(sizeof(TupleGraph::Edge) == sizeof(packed_edge),
-                  "TupleGraph::Edge doesn't match Graph500 generator's.");
+namespace Grappa {
+  
+  namespace {
+    
+    /// Number of edges generated together; each step of the generator
+    /// works on all lanes at once, in loops simple enough for the
+    /// compiler to vectorize.
+    const int LANES = 8;
+    
+    // Constants of the reference generator (graph_generator.c / splittable_mrg.c).
+    const uint64_t MRG_MOD = 0x7FFFFFFF;
+    const uint64_t MRG_X = 107374182;
+    const uint64_t MRG_Y = 104480;
+    const uint32_t INITIATOR_A = 5700;
+    const uint32_t INITIATOR_BC = 1900;
+    const uint32_t INITIATOR_DENOM = 10000;
+    const uint32_t REJECT_LIMIT = MRG_MOD % INITIATOR_DENOM;
+    
+    /// `v mod (2^31-1)` for any 64-bit `v`, without a division.
+    inline uint32_t mrg_mod(uint64_t v) {
+      v = (v & MRG_MOD) + (v >> 31);
+      v = (v & MRG_MOD) + (v >> 31);
+      return static_cast<uint32_t>(v >= MRG_MOD ? v - MRG_MOD : v);
+    }
+    
+    /// Skipping the reference generator ahead is linear in its 5-word
+    /// state, so the per-edge skip can be captured once as a 5x5 matrix
+    /// (columns are the images of the unit states) and applied to all
+    /// lanes at once, instead of a full `mrg_skip` per edge.
+    struct SkipMatrix {
+      uint32_t m[5][5];
+      
+      explicit SkipMatrix(uint64_t edges) {
+        for (int j = 0; j < 5; j++) {
+          uint_fast32_t unit[5] = {0,0,0,0,0};
+          unit[j] = 1;
+          mrg_state st;
+          mrg_seed(&st, unit);
+          mrg_skip(&st, 0, edges, 0);
+          uint_fast32_t col[5] = { st.z1, st.z2, st.z3, st.z4, st.z5 };
+          for (int i = 0; i < 5; i++) m[i][j] = col[i];
+        }
+      }
+      
+      /// Replace each lane's state `z[.][l]` with `M * z[.][l]`.
+      void apply(uint32_t z[5][LANES]) const {
+        uint32_t r[5][LANES];
+        for (int i = 0; i < 5; i++) {
+          for (int l = 0; l < LANES; l++) {
+            uint64_t acc = mrg_mod(uint64_t(m[i][0]) * z[0][l] + uint64_t(m[i][1]) * z[1][l]);
+            acc = mrg_mod(acc + uint64_t(m[i][2]) * z[2][l] + uint64_t(m[i][3]) * z[3][l]);
+            r[i][l] = mrg_mod(acc + uint64_t(m[i][4]) * z[4][l]);
+          }
+        }
+        std::memcpy(z, r, sizeof(r));
+      }
+    };
+    
+    inline uint64_t bitreverse(uint64_t x) {
+      x = __builtin_bswap64(x);
+      x = ((x >> 4) & UINT64_C(0x0F0F0F0F0F0F0F0F)) | ((x & UINT64_C(0x0F0F0F0F0F0F0F0F)) << 4);
+      x = ((x >> 2) & UINT64_C(0x3333333333333333)) | ((x & UINT64_C(0x3333333333333333)) << 2);
+      x = ((x >> 1) & UINT64_C(0x5555555555555555)) | ((x & UINT64_C(0x5555555555555555)) << 1);
+      return x;
+    }
+    
+    /// Vertex-number scrambling, as in the reference generator.
+    inline int64_t scramble(int64_t v0, int lgN, uint64_t val0, uint64_t val1) {
+      uint64_t v = static_cast<uint64_t>(v0);
+      v += val0 + val1;
+      v *= (val0 | UINT64_C(0x4519840211493211));
+      v = (bitreverse(v) >> (64 - lgN));
+      v *= (val1 | UINT64_C(0x3050852102C843A5));
+      v = (bitreverse(v) >> (64 - lgN));
+      return static_cast<int64_t>(v);
+    }
+    
+    /// Per-edge recursive descent for all lanes, given `draw(level, val)`
+    /// filling `val[l]` with each lane's draw in [0, INITIATOR_DENOM).
+    template< typename Draw >
+    void descend(int scale, Draw draw, int64_t src[LANES], int64_t tgt[LANES]) {
+      for (int l = 0; l < LANES; l++) src[l] = tgt[l] = 0;
+      for (int level = 0; level < scale; level++) {
+        uint32_t val[LANES];
+        draw(level, val);
+        int64_t half = int64_t(1) << (scale - 1 - level);
+        for (int l = 0; l < LANES; l++) {
+          uint32_t v = val[l];
+          // quadrants: [0,BC) -> (0,1), [BC,2BC) -> (1,0), then A -> (0,0), else (1,1)
+          int64_t s = (v >= INITIATOR_BC && v < 2*INITIATOR_BC) | (v >= 2*INITIATOR_BC + INITIATOR_A);
+          int64_t t = (v < INITIATOR_BC) | (v >= 2*INITIATOR_BC + INITIATOR_A);
+          // clip-and-flip while still on the diagonal
+          int64_t diag = (src[l] == tgt[l]);
+          int64_t s2 = diag ? (s & t) : s;
+          int64_t t2 = diag ? (s | t) : t;
+          src[l] += half * s2;
+          tgt[l] += half * t2;
+        }
+      }
+    }
+    
+    /// Scalar version of the reference `make_one_edge`, used for the rare
+    /// batches where some lane hits the generator's rejection branch.
+    void reference_edge(int scale, mrg_state st, int64_t* src, int64_t* tgt) {
+      int64_t s = 0, t = 0;
+      for (int level = 0; level < scale; level++) {
+        uint32_t v = mrg_get_uint_orig(&st);
+        while (v < REJECT_LIMIT) v = mrg_get_uint_orig(&st);
+        v %= INITIATOR_DENOM;
+        int so, to;
+        if (v < INITIATOR_BC) { so = 0; to = 1; }
+        else if (v < 2*INITIATOR_BC) { so = 1; to = 0; }
+        else if (v < 2*INITIATOR_BC + INITIATOR_A) { so = 0; to = 0; }
+        else { so = 1; to = 1; }
+        if (s == t && so > to) std::swap(so, to);
+        int64_t half = int64_t(1) << (scale - 1 - level);
+        s += half * so;
+        t += half * to;
+      }
+      *src = s; *tgt = t;
+    }
     
+    void generate_graph500(int scale, uint64_t seed1, uint64_t seed2,
+                           int64_t start, int64_t end, TupleGraph::Edge* out) {
+      static const SkipMatrix next_batch(LANES);
+      
+      uint_fast32_t seed[5];
+      make_mrg_seed(seed1, seed2, seed);
+      mrg_state st;
+      mrg_seed(&st, seed);
+      
+      uint64_t val0, val1;
+      {
+        mrg_state ss = st;
+        mrg_skip(&ss, 50, 7, 0);
+        val0 = mrg_get_uint_orig(&ss);
+        val0 *= UINT64_C(0xFFFFFFFF);
+        val0 += mrg_get_uint_orig(&ss);
+        val1 = mrg_get_uint_orig(&ss);
+        val1 *= UINT64_C(0xFFFFFFFF);
+        val1 += mrg_get_uint_orig(&ss);
+      }
+      
+      // lane l starts at the state of edge `start+l`; one full skip for the
+      // first, single-edge steps for the rest, then whole-batch steps
+      uint32_t lane[5][LANES];
+      mrg_skip(&st, 0, static_cast<uint64_t>(start), 0);
+      for (int l = 0; l < LANES; l++) {
+        uint_fast32_t z[5] = { st.z1, st.z2, st.z3, st.z4, st.z5 };
+        for (int i = 0; i < 5; i++) lane[i][l] = z[i];
+        mrg_skip(&st, 0, 1, 0);
+      }
+      
+      for (int64_t e = start; e < end; e += LANES) {
+        int64_t n = std::min<int64_t>(LANES, end - e);
+        
+        // ring of state words: z1 is r[h], z5 is r[(h+4)%5]
+        uint32_t r[5][LANES];
+        std::memcpy(r, lane, sizeof(r));
+        int h = 0;
+        uint32_t rejected = 0;
+        
+        int64_t src[LANES], tgt[LANES];
+        descend(scale, [&](int level, uint32_t val[LANES]){
+          int h5 = (h + 4) % 5;
+          for (int l = 0; l < LANES; l++) {
+            uint32_t z = mrg_mod(MRG_X * r[h][l] + MRG_Y * r[h5][l]);
+            r[h5][l] = z;
+            rejected |= (z < REJECT_LIMIT);
+            val[l] = z % INITIATOR_DENOM;
+          }
+          h = h5;
+        }, src, tgt);
+        
+        if (rejected) {
+          for (int l = 0; l < n; l++) {
+            mrg_state ls = { lane[0][l], lane[1][l], lane[2][l], lane[3][l], lane[4][l] };
+            reference_edge(scale, ls, &src[l], &tgt[l]);
+          }
+        }
+        
+        for (int l = 0; l < n; l++) {
+          out[e - start + l].v0 = scramble(src[l], scale, val0, val1);
+          out[e - start + l].v1 = scramble(tgt[l], scale, val0, val1);
+        }
+        
+        next_batch.apply(lane);
+      }
+    }
+    
+    void generate_counter(int scale, uint64_t seed1, uint64_t seed2,
+                          int64_t start, int64_t end, TupleGraph::Edge* out) {
+      uint64_t key = mix64(seed1 ^ mix64(seed2 + UINT64_C(0x9E3779B97F4A7C15)));
+      uint64_t val0 = mix64(key + 1), val1 = mix64(key + 2);
+      
+      for (int64_t e = start; e < end; e += LANES) {
+        int64_t n = std::min<int64_t>(LANES, end - e);
+        uint64_t bits[LANES];
+        
+        int64_t src[LANES], tgt[LANES];
+        descend(scale, [&](int level, uint32_t val[LANES]){
+          // one 64-bit hash of (key, edge, level pair) gives two 32-bit draws
+          if (level % 2 == 0) {
+            for (int l = 0; l < LANES; l++) {
+              bits[l] = mix64(key + UINT64_C(0x9E3779B97F4A7C15) * uint64_t(e + l)
+                              + UINT64_C(0xD1B54A32D192ED03) * uint64_t(level / 2 + 1));
+            }
+          }
+          int shift = (level % 2) * 32;
+          for (int l = 0; l < LANES; l++) {
+            val[l] = static_cast<uint32_t>(((bits[l] >> shift) & 0xFFFFFFFF) * INITIATOR_DENOM >> 32);
+          }
+        }, src, tgt);
+        
+        for (int l = 0; l < n; l++) {
+          out[e - start + l].v0 = scramble(src[l], scale, val0, val1);
+          out[e - start + l].v1 = scramble(tgt[l], scale, val0, val1);
+        }
+      }
+    }
+    
+  }
+  
+  void TupleGraph::generate_kronecker(int scale, uint64_t seed1, uint64_t seed2,
+                                      int64_t start, int64_t end, Edge* out,
+                                      KroneckerRNG rng) {
+    if (end <= start) return;
+    if (rng == KroneckerRNG::Graph500) {
+      generate_graph500(scale, seed1, seed2, start, end, out);
+    } else {
+      generate_counter(scale, seed1, seed2, start, end, out);
+    }
+  }
+  
+  TupleGraph TupleGraph::Kronecker(int scale, int64_t nedge, 
+                                            uint64_t seed1, uint64_t seed2,
+                                            KroneckerRNG rng) {    
     TupleGraph tg(nedge);
     
-    on_all_cores([tg,scale,seed1,seed2]{
+    on_all_cores([tg,scale,seed1,seed2,rng]{
       auto local_base = tg.edges.localize();
       auto local_end = (tg.edges+tg.nedge).localize();
       int64_t local_n = local_end - local_base;
       
-      uint_fast32_t seed[5];
-      make_mrg_seed(seed1, seed2, seed);
-      
       auto start = local_n * mycore();
       auto end   = start + local_n;
-      auto packed_edges = reinterpret_cast<packed_edge*>(local_base);
-      generate_kronecker_range(seed, scale, start, end, packed_edges);
-      
+      generate_kronecker(scale, seed1, seed2, start, end, local_base, rng);
     });
     
     return tg;
   }
   
+  void TupleGraph::stream_kronecker(int scale, int64_t nedge, uint64_t seed1, uint64_t seed2,
+                                    const EdgeSink& sink, size_t chunk_edges,
+                                    KroneckerRNG rng) {
+    int64_t start = nedge * mycore() / cores();
+    int64_t end   = nedge * (mycore()+1) / cores();
+    std::vector<Edge> buf(std::min<int64_t>(chunk_edges, end - start));
+    
+    for (int64_t i = start; i < end; i += buf.size()) {
+      int64_t n = std::min<int64_t>(buf.size(), end - i);
+      generate_kronecker(scale, seed1, seed2, i, i+n, buf.data(), rng);
+      sink(buf.data(), n);
+    }
+  }
+  
 }
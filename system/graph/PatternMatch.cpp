@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+
+#include "PatternMatch.hpp"
+
+DEFINE_int64(pattern_max_inflight, 64, "Maximum number of partial-match chunks each core may have in flight during PatternMatcher queries.");
+
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, pattern_partials_sent, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, pattern_matches, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<int64_t>, pattern_rounds, 0);
+
+namespace Grappa {
+  
+  Pattern Pattern::path(const std::vector<int64_t>& colors) {
+    Pattern p;
+    for (auto c : colors) p.add_vertex(c);
+    for (int i = 1; i < p.size(); i++) p.add_edge(i-1, i);
+    return p;
+  }
+  
+  Pattern Pattern::triangle(int64_t c0, int64_t c1, int64_t c2) {
+    auto p = path({c0, c1, c2});
+    p.add_edge(2, 0);
+    if (c0 == any && c1 == any && c2 == any) {
+      p.add_less(0, 1);
+      p.add_less(1, 2);
+    }
+    return p;
+  }
+  
+  Pattern Pattern::star(int64_t center, const std::vector<int64_t>& leaves) {
+    Pattern p;
+    p.add_vertex(center);
+    for (auto c : leaves) p.add_edge(0, p.add_vertex(c));
+    return p;
+  }
+  
+  namespace impl {
+    
+    PatternPlan compile_pattern(const Pattern& p) {
+      int k = p.size();
+      CHECK_GT(k, 0) << "empty pattern";
+      
+      std::vector<uint32_t> nbrs(k, 0);
+      for (auto& e : p.edges) {
+        CHECK(e.first >= 0 && e.first < k && e.second >= 0 && e.second < k) << "bad pattern edge";
+        if (e.first == e.second) continue;
+        nbrs[e.first]  |= 1u << e.second;
+        nbrs[e.second] |= 1u << e.first;
+      }
+      
+      // plan position of each pattern vertex (-1 until bound)
+      std::vector<int> pos(k, -1);
+      PatternPlan plan;
+      plan.k = k;
+      
+      auto bind = [&](int u, int i) {
+        pos[u] = i;
+        plan.pattern_vertex[i] = u;
+        plan.color[i] = p.colors[u];
+        plan.anchor[i] = -1;
+        plan.closing[i] = plan.below[i] = plan.above[i] = 0;
+        for (int w = 0; w < k; w++) {
+          if (!(nbrs[u] & (1u << w)) || pos[w] < 0 || w == u) continue;
+          plan.anchor[i] = std::max(plan.anchor[i], pos[w]);
+        }
+        for (int w = 0; w < k; w++) {
+          if (!(nbrs[u] & (1u << w)) || pos[w] < 0 || w == u) continue;
+          if (pos[w] != plan.anchor[i]) plan.closing[i] |= 1u << pos[w];
+        }
+      };
+      
+      // root: a colored vertex if there is one, then the highest degree
+      auto score = [&](int u) {
+        return (p.colors[u] != Pattern::any ? 2*Pattern::max_size : 0)
+               + __builtin_popcount(nbrs[u]);
+      };
+      int root = 0;
+      for (int u = 1; u < k; u++) if (score(u) > score(root)) root = u;
+      bind(root, 0);
+      
+      for (int i = 1; i < k; i++) {
+        int best = -1, best_score = -1;
+        for (int u = 0; u < k; u++) {
+          if (pos[u] >= 0) continue;
+          int back = 0, latest = -1;
+          for (int w = 0; w < k; w++) {
+            if ((nbrs[u] & (1u << w)) && pos[w] >= 0) { back++; latest = std::max(latest, pos[w]); }
+          }
+          if (back == 0) continue;
+          int s = (latest == i-1 ? 4*Pattern::max_size : 0) + 2*back
+                  + (p.colors[u] != Pattern::any ? 1 : 0);
+          if (s > best_score) { best = u; best_score = s; }
+        }
+        CHECK_GE(best, 0) << "pattern is not connected";
+        bind(best, i);
+      }
+      
+      for (auto& c : p.less) {
+        int a = pos[c.first], b = pos[c.second];
+        CHECK(a >= 0 && b >= 0 && a != b) << "bad pattern constraint";
+        // check at whichever of the two is bound later
+        if (a < b) plan.below[b] |= 1u << a;
+        else       plan.above[a] |= 1u << b;
+      }
+      return plan;
+    }
+    
+  }
+  
+}
@@ -0,0 +1,373 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+
+#pragma once
+
+#include "Graph.hpp"
+#include "VertexColumn.hpp"
+#include "Delegate.hpp"
+#include "ParallelLoop.hpp"
+#include "ChunkSender.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, pattern_partials_sent);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, pattern_matches);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, pattern_rounds);
+
+DECLARE_int64(pattern_max_inflight);
+
+namespace Grappa {
+  
+  /// @addtogroup Graph
+  /// @{
+  
+  /// A small connected pattern to look for in a Graph: up to `max_size`
+  /// vertices, each optionally restricted to one color, joined by
+  /// (undirected) edges. Optional `less` constraints require the graph
+  /// vertex matched to `a` to have a smaller ID than the one matched to
+  /// `b`, to break a pattern's symmetries (e.g. so that each triangle is
+  /// reported once rather than six times).
+  struct Pattern {
+    static const int max_size = 8;
+    static const int64_t any = -1;
+    
+    std::vector<int64_t> colors;              ///< Color of each pattern vertex (or `any`)
+    std::vector<std::pair<int,int>> edges;
+    std::vector<std::pair<int,int>> less;
+    
+    int size() const { return colors.size(); }
+    
+    int add_vertex(int64_t color = any) {
+      CHECK_LT(colors.size(), max_size) << "pattern too large";
+      colors.push_back(color);
+      return colors.size() - 1;
+    }
+    void add_edge(int a, int b) { edges.emplace_back(a, b); }
+    void add_less(int a, int b) { less.emplace_back(a, b); }
+    
+    /// Path through vertices colored `colors[0]`, `colors[1]`, ...
+    static Pattern path(const std::vector<int64_t>& colors);
+    /// Triangle (reported once per triangle if all colors are `any`).
+    static Pattern triangle(int64_t c0 = any, int64_t c1 = any, int64_t c2 = any);
+    /// Vertex 0 (colored `center`) joined to one leaf per entry of `leaves`.
+    static Pattern star(int64_t center, const std::vector<int64_t>& leaves);
+  };
+  
+  namespace impl {
+    
+    /// A Pattern renumbered in the order its vertices are matched: plan
+    /// vertex 0 is tried at every graph vertex, and each later vertex `i`
+    /// is extended from the adjacency of plan vertex `anchor[i]`, then
+    /// filtered by color, injectivity, `less` constraints and its other
+    /// (`closing`) edges back to already-matched vertices.
+    struct PatternPlan {
+      int k;
+      int pattern_vertex[Pattern::max_size];  ///< Pattern vertex of each plan vertex
+      int64_t color[Pattern::max_size];
+      int anchor[Pattern::max_size];
+      uint32_t closing[Pattern::max_size];    ///< Earlier plan vertices `i` must be adjacent to
+      uint32_t below[Pattern::max_size];      ///< Earlier plan vertices matched to smaller IDs
+      uint32_t above[Pattern::max_size];      ///< Earlier plan vertices matched to larger IDs
+    };
+    
+    /// Order the vertices of `p` so that each is adjacent to an earlier
+    /// one, preferring to extend from the most recently matched vertex
+    /// (which keeps the next step on the same core) and to bind vertices
+    /// with more edges back to the matched set first (so they are pruned
+    /// early). Fails if `p` is empty or not connected.
+    PatternPlan compile_pattern(const Pattern& p);
+    
+    struct PartialMatch {
+      VertexID v[Pattern::max_size];  ///< Graph vertex of each bound plan vertex
+      int8_t bound;                   ///< Plan vertices [0, bound) are matched
+      int8_t cursor;                  ///< Plan vertex whose owner holds this match
+      bool check;                     ///< Whether `cursor`'s closing edges are unverified
+    };
+    
+    /// Partial matches batched per destination into one message.
+    const size_t partial_match_batch = 32;
+    
+  }
+  
+  /// Matches small patterns (paths, triangles, stars, ...) against every
+  /// vertex of a Graph at once.
+  ///
+  /// A query runs in bulk-synchronous rounds. Each core extends the partial
+  /// matches it holds along its local adjacency lists, pruning candidates
+  /// by color before anything is sent (the color of every adjacency
+  /// target is cached next to the adjacency), and ships the survivors
+  /// that need a check or extension elsewhere to the owning core, batched
+  /// per destination. Complete matches are handed to the sink on the core
+  /// where they are completed, as they are found.
+  ///
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// auto pm = PatternMatcher<G>::create(g, [](G::Vertex& v){ return v->color; });
+  /// auto n = pm->count(Pattern::triangle());
+  /// pm->match(Pattern::path({0, 1, 2}), [](const VertexID* m){
+  ///   // m[p] is the graph vertex matched to pattern vertex p
+  /// });
+  /// pm->destroy();
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  ///
+  /// Every injective mapping satisfying the pattern is reported (use
+  /// Pattern::less to collapse symmetric ones). A pattern edge (a,b) is
+  /// matched by `b` appearing in `a`'s adjacency list, so patterns are
+  /// meant for graphs created undirected. Partial matches of one round
+  /// are held in memory until the next, so very unselective patterns on
+  /// large graphs can use a lot of it.
+  template< typename G >
+  struct PatternMatcher {
+    using Vertex = typename G::Vertex;
+    
+    GlobalAddress<G> g;
+    GlobalAddress<PatternMatcher> self;
+    
+    std::vector<int64_t> color;       ///< Color of each local vertex
+    std::vector<int64_t> adj_offset;  ///< Start of each local vertex's entries in `adj_color`
+    std::vector<int64_t> adj_color;   ///< Color of the target of each local adjacency
+    
+    impl::PatternPlan plan;
+    std::vector<impl::PartialMatch> frontier;          ///< Partial matches to process this round
+    std::vector<impl::PartialMatch> next;              ///< Partial matches received for the next round
+    std::vector<std::vector<impl::PartialMatch>> out;  ///< Per-destination send buffers
+    ChunkSender sender;                                ///< Sent buffers not yet received
+    
+    PatternMatcher(GlobalAddress<PatternMatcher> self, GlobalAddress<G> g)
+      : g(g), self(self), sender(FLAGS_pattern_max_inflight) {}
+    
+    /// Matcher for `g` with vertex colors given by `color_of(Vertex&)`.
+    template< typename F >
+    static GlobalAddress<PatternMatcher> create(GlobalAddress<G> g, F color_of) {
+      auto m = symmetric_global_alloc<PatternMatcher>();
+      call_on_all_cores([m,g,color_of]{
+        auto& pm = *new (m.localize()) PatternMatcher(m, g);
+        int64_t total = 0;
+        for (auto& v : iterate_local(g->vs, g->nv)) {
+          pm.color.push_back(color_of(v));
+          pm.adj_offset.push_back(total);
+          total += v.nadj;
+        }
+        pm.adj_offset.push_back(total);
+        pm.adj_color.resize(total);
+      });
+      
+      // cache the color of each adjacency's target next to the adjacency
+      forall(g->vs, g->nv, [g,m](Vertex& v){
+        auto base = m->adj_offset[g->local_index(v)];
+        forall<SyncMode::Async>(adj(g,v), [g,m,base](int64_t k, typename G::Edge& e){
+          auto c = delegate::call(e.ga, [g,m](Vertex& w){
+            return m->color[g->local_index(w)];
+          });
+          m->adj_color[base + k] = c;
+        });
+      });
+      return m;
+    }
+    
+    void destroy() {
+      auto self = this->self;
+      call_on_all_cores([self]{ self->~PatternMatcher(); });
+      global_free(self);
+    }
+    
+    /// Find all matches of `p`, calling `sink(const VertexID* m)` once per
+    /// match, on the core that completed it, with `m[i]` the graph vertex
+    /// matched to pattern vertex `i`. Call from a single task.
+    template< typename F >
+    void match(const Pattern& p, F sink) {
+      auto self = this->self;
+      auto plan = impl::compile_pattern(p);
+      call_on_all_cores([self,plan]{
+        self->plan = plan;
+        self->frontier.clear();
+        self->next.clear();
+      });
+      
+      int64_t remaining = 0;
+      int64_t round = 0;
+      do {
+        on_all_cores([self,sink,round]{ self->run_round(round == 0, sink); });
+        remaining = sum_all_cores([self]{
+          std::swap(self->frontier, self->next);
+          self->next.clear();
+          return static_cast<int64_t>(self->frontier.size());
+        });
+        round++;
+      } while (remaining > 0);
+      pattern_rounds += round;
+      
+      call_on_all_cores([self]{
+        std::vector<impl::PartialMatch>().swap(self->frontier);
+        std::vector<impl::PartialMatch>().swap(self->next);
+      });
+    }
+    
+    /// Number of matches of `p`.
+    int64_t count(const Pattern& p) {
+      call_on_all_cores([]{ match_count() = 0; });
+      match(p, [](const VertexID* m){ match_count()++; });
+      return sum_all_cores([]{ return match_count(); });
+    }
+    
+  private:
+    static int64_t& match_count() { static int64_t n; return n; }
+    
+    Vertex& local_vertex(VertexID j) { return *(g->vs+j).pointer(); }
+    
+    /// Whether local vertex `v` has `j` in its (sorted) adjacency list.
+    static bool has_adj(const Vertex& v, VertexID j) {
+      return std::binary_search(v.local_adj, v.local_adj + v.nadj, j);
+    }
+    
+    /// Process this core's share of one round: seed from the local
+    /// vertices on the first round, otherwise continue the partial matches
+    /// received in the previous one. Returns once everything this core
+    /// sent has been received.
+    template< typename F >
+    void run_round(bool seed, F& sink) {
+      out.resize(cores());
+      for (auto& c : out) c.clear();
+      
+      if (seed) {
+        for (auto& v : iterate_local(g->vs, g->nv)) {
+          if (!v.valid) continue;
+          if (plan.color[0] != Pattern::any && color[g->local_index(v)] != plan.color[0]) continue;
+          impl::PartialMatch m;
+          m.v[0] = g->id(v);
+          m.bound = 1;
+          m.cursor = 0;
+          m.check = false;
+          extend(m, sink);
+        }
+      } else {
+        for (auto& m : frontier) {
+          if (m.check && !closes(m)) continue;
+          extend(m, sink);
+        }
+      }
+      
+      for (Core c = 0; c < cores(); c++) flush(c);
+      sender.wait();
+    }
+    
+    /// Check the closing edges of the just-bound plan vertex `m.cursor`.
+    bool closes(const impl::PartialMatch& m) {
+      auto& v = local_vertex(m.v[m.cursor]);
+      auto mask = plan.closing[m.cursor];
+      for (int j = 0; j < m.cursor; j++) {
+        if ((mask & (1u << j)) && !has_adj(v, m.v[j])) return false;
+      }
+      return true;
+    }
+    
+    /// Extend `m`, held by the owner of its cursor vertex, to full matches
+    /// as far as possible on this core; ship it on where needed.
+    template< typename F >
+    void extend(impl::PartialMatch m, F& sink) {
+      int i = m.bound;
+      if (i == plan.k) {
+        VertexID r[Pattern::max_size];
+        for (int j = 0; j < plan.k; j++) r[plan.pattern_vertex[j]] = m.v[j];
+        pattern_matches++;
+        sink(static_cast<const VertexID*>(r));
+        return;
+      }
+      
+      int a = plan.anchor[i];
+      if (a != m.cursor) {
+        m.cursor = a;
+        m.check = false;
+        auto dest = (g->vs+m.v[a]).core();
+        if (dest != mycore()) {
+          send(dest, m);
+          return;
+        }
+      }
+      
+      auto& v = local_vertex(m.v[a]);
+      auto colors = &adj_color[adj_offset[g->local_index(v)]];
+      for (int64_t k = 0; k < v.nadj; k++) {
+        if (plan.color[i] != Pattern::any && colors[k] != plan.color[i]) continue;
+        
+        auto w = v.local_adj[k];
+        bool ok = true;
+        for (int j = 0; j < i && ok; j++) {
+          ok = (m.v[j] != w)
+            && !((plan.below[i] & (1u << j)) && !(m.v[j] < w))
+            && !((plan.above[i] & (1u << j)) && !(w < m.v[j]));
+        }
+        if (!ok) continue;
+        
+        auto n = m;
+        n.v[i] = w;
+        n.bound = i+1;
+        if (plan.closing[i]) {
+          n.cursor = i;
+          auto dest = (g->vs+w).core();
+          if (dest != mycore()) {
+            n.check = true;
+            send(dest, n);
+          } else if (closes(n)) {
+            extend(n, sink);
+          }
+        } else {
+          extend(n, sink);
+        }
+      }
+    }
+    
+    void send(Core dest, const impl::PartialMatch& m) {
+      auto& c = out[dest];
+      c.push_back(m);
+      if (c.size() == impl::partial_match_batch) flush(dest);
+    }
+    
+    void flush(Core dest) {
+      auto& c = out[dest];
+      if (c.empty()) return;
+      pattern_partials_sent += c.size();
+      auto self = this->self;
+      sender.send<impl::partial_match_batch * sizeof(impl::PartialMatch)>(dest, c.data(), c.size(),
+          [self](const impl::PartialMatch * ms, size_t n, size_t offset){
+        auto& next = self->next;
+        next.insert(next.end(), ms, ms + n);
+      });
+      c.clear();
+    }
+  } GRAPPA_BLOCK_ALIGNED;
+  
+  /// @}
+  
+}
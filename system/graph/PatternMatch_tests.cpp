@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <graph/PatternMatch.hpp>
+#include <functional>
+
+BOOST_AUTO_TEST_SUITE( PatternMatch_tests );
+
+using namespace Grappa;
+
+DEFINE_int64(scale, 8, "Log2 number of vertices.");
+DEFINE_int64(edgefactor, 8, "Average number of edges per vertex.");
+
+struct VData {
+  int64_t color;
+};
+
+using G = Graph<VData,Empty>;
+
+/// Copy of the whole adjacency structure (on core 0) for brute-force checks.
+std::vector<std::vector<VertexID>> adjs;
+
+/// Count matches of `p` by backtracking over `adjs`, taking the pattern
+/// vertices in their own order (each must have an edge to an earlier one).
+int64_t brute_force_count(const Pattern& p) {
+  int k = p.size();
+  std::vector<VertexID> m(k);
+  auto adjacent = [](VertexID a, VertexID b){
+    return std::binary_search(adjs[a].begin(), adjs[a].end(), b);
+  };
+  
+  std::function<int64_t(int)> go = [&](int i) -> int64_t {
+    if (i == k) return 1;
+    std::vector<VertexID> cands;
+    if (i == 0) {
+      for (VertexID j = 0; j < adjs.size(); j++) cands.push_back(j);
+    } else {
+      for (auto& e : p.edges) {
+        int q = (e.first == i) ? e.second : (e.second == i) ? e.first : -1;
+        if (q >= 0 && q < i) { cands = adjs[m[q]]; break; }
+      }
+    }
+    int64_t n = 0;
+    for (auto w : cands) {
+      if (p.colors[i] != Pattern::any && w % 3 != p.colors[i]) continue;
+      bool ok = true;
+      for (int j = 0; j < i; j++) ok = ok && m[j] != w;
+      for (auto& e : p.edges) {
+        if (e.first == i && e.second < i) ok = ok && adjacent(w, m[e.second]);
+        if (e.second == i && e.first < i) ok = ok && adjacent(w, m[e.first]);
+      }
+      for (auto& c : p.less) {
+        if (c.first == i && c.second < i) ok = ok && w < m[c.second];
+        if (c.second == i && c.first < i) ok = ok && m[c.first] < w;
+      }
+      if (!ok) continue;
+      m[i] = w;
+      n += go(i+1);
+    }
+    return n;
+  };
+  return go(0);
+}
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t NE = (1L << FLAGS_scale) * FLAGS_edgefactor;
+    auto tg = TupleGraph::Kronecker(FLAGS_scale, NE, 111, 222);
+    auto g = G::create(tg);
+    
+    forall(g->vs, g->nv, [g](G::Vertex& v){ v->color = g->id(v) % 3; });
+    auto pm = PatternMatcher<G>::create(g, [](G::Vertex& v){ return v->color; });
+    
+    adjs.resize(g->nv);
+    forall(g, [g](G::Vertex& v, G::Edge& e){
+      auto i = g->id(v);
+      auto j = e.id;
+      delegate::call<async>(0, [i,j]{ adjs[i].push_back(j); });
+    });
+    for (auto& a : adjs) std::sort(a.begin(), a.end());
+    
+    auto star = Pattern::star(1, {Pattern::any, Pattern::any});
+    star.add_less(1, 2);
+    
+    for (auto& p : { Pattern::path({0, 1, 0}),
+                     Pattern::path({Pattern::any, 2, Pattern::any, 1}),
+                     Pattern::triangle(),
+                     Pattern::triangle(0, 1, 2),
+                     star }) {
+      auto expected = brute_force_count(p);
+      auto n = pm->count(p);
+      VLOG(1) << "matches: " << n;
+      CHECK_EQ(n, expected);
+    }
+    
+    // every reported match satisfies the pattern
+    auto tri = Pattern::triangle(0, 1, 2);
+    pm->match(tri, [g](const VertexID* m){
+      for (int i = 0; i < 3; i++) {
+        CHECK_EQ(m[i] % 3, i);
+        auto a = m[i], b = m[(i+1) % 3];
+        CHECK(delegate::call(g->vs+a, [b](G::Vertex& v){
+          return std::binary_search(v.local_adj, v.local_adj + v.nadj, b);
+        }));
+      }
+    });
+    
+    pm->destroy();
+    g->destroy();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
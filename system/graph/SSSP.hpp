@@ -0,0 +1,301 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Graph.hpp"
+#include "Collective.hpp"
+#include "GlobalCompletionEvent.hpp"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <limits>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, sssp_buckets_processed);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, sssp_light_phases);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, sssp_relaxations);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, sssp_relaxations_sent);
+
+namespace Grappa {
+  
+  /// @addtogroup Graph
+  /// @{
+  
+  namespace impl {
+    
+    struct SSSPRelax {
+      VertexID v, parent;
+      double dist;
+    };
+    
+    /// Per-core state for delta-stepping SSSP, allocated symmetrically.
+    struct DeltaStepping {
+      static const int chunk_size = 32;
+      
+      double delta;
+      
+      /// Local vertices (by index into this core's vertices) in each
+      /// bucket. Entries go stale when a vertex moves to a lower bucket.
+      std::map<int64_t,std::vector<int64_t>> buckets;
+      
+      /// Distance each local vertex last relaxed its edges with, to skip
+      /// duplicate bucket entries.
+      std::vector<double> relaxed;
+      
+      /// Local vertices removed from the current bucket, whose heavy
+      /// edges are relaxed once the bucket is empty.
+      std::vector<int64_t> settled;
+      std::vector<bool> is_settled;
+      
+      /// Each local vertex's edge positions, light edges first.
+      std::vector<int64_t> edge_begin;
+      std::vector<uint32_t> edge_order;
+      std::vector<uint32_t> nlight;
+      
+      /// Outgoing relaxations, combined by target (only the minimum is sent).
+      std::unordered_map<VertexID,SSSPRelax> pending;
+      
+      /// Lowest non-empty bucket, and whether it is still non-empty after
+      /// a light phase (as agreed by all cores).
+      int64_t current;
+      bool more;
+      
+      int64_t bucket_of(double dist) const { return static_cast<int64_t>(dist / delta); }
+      
+      int64_t min_bucket() const {
+        for (auto& b : buckets) if (!b.second.empty()) return b.first;
+        return std::numeric_limits<int64_t>::max();
+      }
+    } GRAPPA_BLOCK_ALIGNED;
+    
+  }
+  
+  /// Single-source shortest paths by delta-stepping (Meyer & Sanders).
+  ///
+  /// Vertices are kept in distributed buckets of width `delta` by tentative
+  /// distance. Buckets are processed in order: vertices in the current
+  /// bucket repeatedly relax their light edges (weight <= delta) until the
+  /// bucket stays empty, then the vertices removed from it relax their heavy
+  /// edges once. Relaxations bound for the same vertex are combined on the
+  /// sending core, so only the smallest is sent, and the rest are batched
+  /// into one message per destination core per `chunk_size` relaxations.
+  ///
+  /// The vertex data of `G` must have `dist` and `parent` fields, which are
+  /// filled in with each vertex's distance from `root` (infinity if
+  /// unreachable) and its predecessor on a shortest path (-1 if none;
+  /// `root` is its own parent).
+  ///
+  /// @param weight  non-negative weight of an edge: `double(G::Edge&)`
+  /// @param delta   bucket width; if <= 0, uses max weight / average degree
+  ///
+  /// Example:
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// struct VertexData { double dist; int64_t parent; };
+  /// struct EdgeData { double weight; };
+  /// using G = Graph<VertexData,EdgeData>;
+  /// 
+  /// sssp(g, root, [](G::Edge& e){ return e->weight; });
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  template< typename G, typename WeightFn >
+  void sssp(GlobalAddress<G> g, VertexID root, WeightFn weight, double delta = 0) {
+    using Vertex = typename G::Vertex;
+    const double inf = std::numeric_limits<double>::infinity();
+    
+    auto st = symmetric_global_alloc<impl::DeltaStepping>();
+    
+    // initialize distances and split each vertex's edges into light & heavy
+    on_all_cores([g,st,weight,delta,inf]{
+      auto s = new (st.localize()) impl::DeltaStepping();
+      auto local = iterate_local(g->vs, g->nv);
+      int64_t n = local.size();
+      
+      double max_weight = 0;
+      for (Vertex& v : local) {
+        for (int64_t k = 0; k < v.nadj; k++) {
+          auto e = g->edge(v,k);
+          double w = weight(e);
+          CHECK_GE(w, 0) << "sssp: negative edge weight";
+          max_weight = std::max(max_weight, w);
+        }
+      }
+      max_weight = allreduce<double,collective_max>(max_weight);
+      double avg_degree = std::max(1.0, static_cast<double>(g->nadj) / g->nv);
+      s->delta = (delta > 0) ? delta : max_weight / avg_degree;
+      if (s->delta <= 0) s->delta = 1.0;
+      
+      s->relaxed.assign(n, inf);
+      s->is_settled.assign(n, false);
+      s->edge_begin.resize(n+1);
+      s->nlight.resize(n);
+      
+      int64_t i = 0, offset = 0;
+      for (Vertex& v : local) {
+        v->dist = inf;
+        v->parent = -1;
+        s->edge_begin[i] = offset;
+        offset += v.nadj;
+        i++;
+      }
+      s->edge_begin[n] = offset;
+      s->edge_order.resize(offset);
+      
+      i = 0;
+      for (Vertex& v : local) {
+        auto order = &s->edge_order[s->edge_begin[i]];
+        int64_t lo = 0, hi = v.nadj;
+        for (int64_t k = 0; k < v.nadj; k++) {
+          auto e = g->edge(v,k);
+          if (weight(e) <= s->delta) order[lo++] = k;
+          else order[--hi] = k;
+        }
+        s->nlight[i] = lo;
+        i++;
+      }
+    });
+    VLOG(1) << "sssp: root " << root << ", delta " << st->delta;
+    
+    // apply a relaxation at the target's home core
+    auto apply = [g,st](const impl::SSSPRelax& r) {
+      Vertex& v = *(g->vs+r.v).pointer();
+      if (r.dist < v->dist) {
+        v->dist = r.dist;
+        v->parent = r.parent;
+        auto s = st.localize();
+        s->buckets[s->bucket_of(r.dist)].push_back(&v - g->vs.localize());
+      }
+    };
+    
+    delegate::call(g->vs+root, [apply,root](Vertex& v){
+      apply(impl::SSSPRelax{ root, root, 0.0 });
+    });
+    
+    // relax edges [begin,end) of each vertex's ordering, for the given vertices
+    auto relax = [g,st,weight,apply](const std::vector<int64_t>& vertices, bool light) {
+      auto s = st.localize();
+      auto base = g->vs.localize();
+      for (auto i : vertices) {
+        Vertex& v = base[i];
+        double d = v->dist;
+        auto order = &s->edge_order[s->edge_begin[i]];
+        int64_t begin = light ? 0 : s->nlight[i];
+        int64_t end = light ? s->nlight[i] : v.nadj;
+        for (int64_t k = begin; k < end; k++) {
+          auto e = g->edge(v, order[k]);
+          impl::SSSPRelax r{ e.id, g->id(v), d + weight(e) };
+          sssp_relaxations++;
+          auto it = s->pending.find(r.v);
+          if (it == s->pending.end()) s->pending[r.v] = r;
+          else if (r.dist < it->second.dist) it->second = r;
+        }
+      }
+      
+      // send combined relaxations in one message per chunk per core
+      std::vector<std::vector<impl::SSSPRelax>> out(cores());
+      for (auto& p : s->pending) out[(g->vs+p.first).core()].push_back(p.second);
+      s->pending.clear();
+      for (Core c = 0; c < cores(); c++) {
+        auto& rs = out[c];
+        for (size_t j = 0; j < rs.size(); j += impl::DeltaStepping::chunk_size) {
+          struct { impl::SSSPRelax r[impl::DeltaStepping::chunk_size]; int64_t n; } chunk;
+          chunk.n = std::min<size_t>(impl::DeltaStepping::chunk_size, rs.size() - j);
+          std::copy(rs.begin()+j, rs.begin()+j+chunk.n, chunk.r);
+          sssp_relaxations_sent += chunk.n;
+          delegate::call<SyncMode::Async>(c, [chunk,apply]{
+            for (int64_t k = 0; k < chunk.n; k++) apply(chunk.r[k]);
+          });
+        }
+      }
+    };
+    
+    while (true) {
+      // find the lowest non-empty bucket anywhere
+      on_all_cores([st]{
+        st->current = allreduce<int64_t,collective_min>(st->min_bucket());
+      });
+      int64_t b = st->current;
+      if (b == std::numeric_limits<int64_t>::max()) break;
+      sssp_buckets_processed++;
+      
+      // light edges: repeat until no core has anything left in bucket b
+      do {
+        sssp_light_phases++;
+        finish([g,st,b,relax]{
+          on_all_cores([g,st,b,relax]{
+            auto s = st.localize();
+            auto base = g->vs.localize();
+            std::vector<int64_t> current;
+            auto it = s->buckets.find(b);
+            if (it != s->buckets.end()) {
+              current.swap(it->second);
+              s->buckets.erase(it);
+            }
+            std::vector<int64_t> frontier;
+            for (auto i : current) {
+              double d = base[i]->dist;
+              if (s->bucket_of(d) != b || s->relaxed[i] == d) continue; // stale or duplicate
+              s->relaxed[i] = d;
+              frontier.push_back(i);
+              if (!s->is_settled[i]) {
+                s->is_settled[i] = true;
+                s->settled.push_back(i);
+              }
+            }
+            relax(frontier, true);
+          });
+        });
+        on_all_cores([st,b]{
+          auto it = st->buckets.find(b);
+          bool mine = (it != st->buckets.end() && !it->second.empty());
+          st->more = allreduce<bool,collective_or>(mine);
+        });
+      } while (st->more);
+      
+      // heavy edges of everything settled in bucket b, once
+      finish([st,relax]{
+        on_all_cores([st,relax]{
+          auto s = st.localize();
+          std::vector<int64_t> settled;
+          settled.swap(s->settled);
+          for (auto i : settled) s->is_settled[i] = false;
+          relax(settled, false);
+        });
+      });
+    }
+    
+    call_on_all_cores([st]{ st.localize()->~DeltaStepping(); });
+    global_free(st);
+  }
+  
+  /// @}
+  
+} // namespace Grappa
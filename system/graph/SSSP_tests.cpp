@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <graph/SSSP.hpp>
+
+BOOST_AUTO_TEST_SUITE( SSSP_tests );
+
+using namespace Grappa;
+
+DEFINE_int32(scale, 10, "Log2 number of vertices.");
+
+struct VData {
+  double dist;
+  VertexID parent;
+  double ref_dist;
+};
+
+struct EData {
+  double weight;
+};
+
+using G = Graph<VData,EData>;
+
+/// Deterministic weight in [0,1) for an undirected edge.
+double edge_weight(VertexID i, VertexID j) {
+  uint64_t h = std::min(i,j) * 0x9e3779b97f4a7c15ULL ^ std::max(i,j) * 0xc2b2ae3d27d4eb4fULL;
+  h ^= h >> 29;
+  return (h % 1000003) / 1000003.0;
+}
+
+/// Check the shortest-path conditions: no edge can shorten a distance, and
+/// each vertex's distance is its parent's plus the connecting edge.
+template< typename WeightFn >
+void check_distances(GlobalAddress<G> g, VertexID root, WeightFn weight) {
+  BOOST_CHECK_EQUAL(delegate::call(g->vs+root, [](G::Vertex& v){ return v->dist; }), 0.0);
+  forall(g, [g,weight](VertexID i, G::Vertex& v){
+    if (v->parent == -1) {
+      BOOST_CHECK(std::isinf(v->dist));
+      return;
+    }
+    double d = v->dist;
+    for (int64_t k = 0; k < v.nadj; k++) {
+      auto e = g->edge(v,k);
+      double dj = delegate::call(e.ga, [](G::Vertex& w){ return w->dist; });
+      double w = weight(e);
+      CHECK_LE(dj, d + w + 1e-9) << i << " -> " << e.id;
+      if (e.id == v->parent) {
+        CHECK_LE(std::fabs(d - (dj + w)), 1e-9) << "parent of " << i;
+      }
+    }
+  });
+}
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t ne = (1L << FLAGS_scale) * 16;
+    auto tg = TupleGraph::Kronecker(FLAGS_scale, ne, 111, 222);
+    auto g = G::create(tg);
+    tg.destroy();
+    
+    forall(g, [g](VertexID i, G::Vertex& v){
+      for (int64_t k = 0; k < v.nadj; k++) {
+        v.local_edge_state[k].weight = edge_weight(i, v.local_adj[k]);
+      }
+    });
+    
+    VertexID root = 0;
+    while (delegate::call(g->vs+root, [](G::Vertex& v){ return v.nadj; }) == 0) root++;
+    
+    auto weight = [](G::Edge& e){ return e->weight; };
+    
+    // a single huge bucket degenerates to Bellman-Ford; use it as reference
+    sssp(g, root, weight, 1e9);
+    check_distances(g, root, weight);
+    forall(g, [](G::Vertex& v){ v->ref_dist = v->dist; });
+    
+    for (double delta : { 0.0, 0.01, 0.1 }) {
+      sssp(g, root, weight, delta);
+      check_distances(g, root, weight);
+      forall(g, [](G::Vertex& v){
+        if (std::isinf(v->ref_dist)) BOOST_CHECK(std::isinf(v->dist));
+        else CHECK_LE(std::fabs(v->dist - v->ref_dist), 1e-9);
+      });
+    }
+    
+    // unit weights give BFS levels
+    auto unit = [](G::Edge& e){ return 1.0; };
+    sssp(g, root, unit);
+    check_distances(g, root, unit);
+    
+    g->destroy();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
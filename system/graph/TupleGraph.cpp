@@ -128,6 +128,31 @@ void local_load_bintsv4( const char * filename,
 }
 
 
+void TupleGraph::stream_bintsv4( const char * path, const EdgeSink& sink, size_t chunk_edges ) {
+  std::ifstream infile( path, std::ios_base::in | std::ios_base::binary );
+  CHECK( infile ) << "File not found: " << path;
+  infile.seekg( 0, std::ios_base::end );
+  int64_t nedge = infile.tellg() / sizeof(Int32Edge);
+
+  int64_t start = nedge * Grappa::mycore() / Grappa::cores();
+  int64_t end = nedge * (Grappa::mycore()+1) / Grappa::cores();
+  size_t nbuf = std::min<int64_t>( chunk_edges, end - start );
+  std::vector< Int32Edge > in( nbuf );
+  std::vector< Edge > out( nbuf );
+
+  infile.seekg( start * sizeof(Int32Edge) );
+  for( int64_t i = start; i < end; i += nbuf ) {
+    int64_t n = std::min<int64_t>( nbuf, end - i );
+    infile.read( (char*) in.data(), n * sizeof(Int32Edge) );
+    CHECK( infile ) << "Error reading " << path;
+    for( int64_t j = 0; j < n; j++ ) {
+      out[j].v0 = in[j].v0;
+      out[j].v1 = in[j].v1;
+    }
+    sink( out.data(), n );
+  }
+}
+
 /// helper method for parallel load of a single file
 static std::vector< Grappa::TupleGraph::Edge > read_edges;
 TupleGraph TupleGraph::load_tsv( std::string path ) {
@@ -687,6 +712,37 @@ void local_save_tsv( const char * filename,
 
 
 
+TupleGraph TupleGraph::Grid( int64_t rows, int64_t cols, double keep, uint64_t seed ) {
+  TupleGraph tg( 2 * rows * cols );
+  forall( tg.edges, tg.nedge, [rows,cols,keep,seed]( int64_t i, Edge& e ) {
+    int64_t v = i / 2, r = v / cols, c = v % cols;
+    bool right = (i % 2 == 0);
+    
+    // cheap deterministic hash of (edge, seed) to decide which edges to drop
+    uint64_t h = (i + 1) * 0x9e3779b97f4a7c15ULL ^ seed * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 31; h *= 0x94d049bb133111ebULL; h ^= h >> 29;
+    bool dropped = (h >> 11) * (1.0 / (1ULL << 53)) >= keep;
+    
+    e.v0 = v;
+    if( dropped || (right && c+1 == cols) || (!right && r+1 == rows) ) {
+      e.v1 = v;
+    } else {
+      e.v1 = right ? v + 1 : v + cols;
+    }
+  });
+  return tg;
+}
+
+TupleGraph TupleGraph::relabeled( GlobalAddress<int64_t> ids ) const {
+  TupleGraph tg( nedge );
+  auto out = tg.edges;
+  forall( edges, nedge, [ids,out]( int64_t i, Edge& e ) {
+    Edge r = { delegate::read( ids + e.v0 ), delegate::read( ids + e.v1 ) };
+    delegate::write<SyncMode::Async>( out + i, r );
+  });
+  return tg;
+}
+
 /// TupleGraph constructor that loads from a file, dispatching on file format
 TupleGraph TupleGraph::Load( std::string path, std::string format ) {
   if( format == "bintsv4" ) {
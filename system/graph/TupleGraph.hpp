@@ -36,6 +36,7 @@
 
 #include <Addressing.hpp>
 #include <GlobalAllocator.hpp>
+#include <functional>
 
 namespace Grappa {
 
@@ -45,6 +46,16 @@ namespace Grappa {
       int64_t v0;
       int64_t v1;
     };
+    
+    /// Receives chunks of edges from a streaming source (see
+    /// Graph::create_streaming()).
+    using EdgeSink = std::function<void(const Edge*, size_t)>;
+    
+    /// Random source for the Kronecker generators. `Graph500` reproduces
+    /// the reference generator's edge list exactly for given seeds;
+    /// `Counter` draws from a counter-based hash instead, which is cheaper
+    /// but gives a different (identically distributed) edge list.
+    enum class KroneckerRNG { Graph500, Counter };
 
   private:
     bool initialized;
@@ -61,7 +72,38 @@ namespace Grappa {
   
     /// Use Graph500 Kronecker generator (@see graph/KroneckerGenerator.cpp)
     static TupleGraph Kronecker(int scale, int64_t desired_nedge, 
-                                         uint64_t seed1, uint64_t seed2);
+                                         uint64_t seed1, uint64_t seed2,
+                                         KroneckerRNG rng = KroneckerRNG::Graph500);
+    
+    /// Road-network-like grid: `rows` x `cols` vertices, each joined to
+    /// its right and lower neighbors, except that a pseudo-random
+    /// `1 - keep` fraction of those edges (chosen by `seed`) is replaced
+    /// by self-loops. Unlike Kronecker graphs, these have a large
+    /// diameter (about rows + cols).
+    static TupleGraph Grid(int64_t rows, int64_t cols, double keep = 1.0, uint64_t seed = 0);
+    
+    /// Generate this core's share of a Graph500 Kronecker edge list,
+    /// passing it to `sink` in chunks of at most `chunk_edges` edges
+    /// instead of storing it. Must be called on all cores.
+    static void stream_kronecker(int scale, int64_t nedge, uint64_t seed1, uint64_t seed2,
+                                 const EdgeSink& sink, size_t chunk_edges = 1 << 16,
+                                 KroneckerRNG rng = KroneckerRNG::Graph500);
+    
+    /// Generate edges [start, end) of a Kronecker edge list into `out`
+    /// (local, no communication). Edges are produced in batches of
+    /// independent lanes so the inner loops vectorize.
+    static void generate_kronecker(int scale, uint64_t seed1, uint64_t seed2,
+                                   int64_t start, int64_t end, Edge* out,
+                                   KroneckerRNG rng = KroneckerRNG::Graph500);
+    
+    /// Read this core's share of a bintsv4 edge file, passing it to
+    /// `sink` in chunks of at most `chunk_edges` edges. Must be called on
+    /// all cores.
+    static void stream_bintsv4(const char * path, const EdgeSink& sink,
+                               size_t chunk_edges = 1 << 16);
+
+    /// Copy of this edge list with every vertex `v` renamed to `ids[v]`.
+    TupleGraph relabeled( GlobalAddress<int64_t> ids ) const;
 
     // create new TupleGraph with edges loaded from file
     static TupleGraph Load( std::string path, std::string format );
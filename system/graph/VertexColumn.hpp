@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Graph.hpp"
+#include "ParallelLoop.hpp"
+
+namespace Grappa {
+  
+  /// @addtogroup Graph
+  /// @{
+  
+  /// A vertex property stored as a column (structure-of-arrays) instead of
+  /// inside each Vertex. Each core holds a dense, cache-line-aligned array
+  /// with one element per local vertex of the graph it was created for, in
+  /// the same order as `iterate_local(g->vs, g->nv)`, so kernels that only
+  /// touch one property stream just that property.
+  ///
+  /// Like Graph, VertexColumn is a symmetric data structure:
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// auto rank = vertex_column<double>(g);
+  /// auto next = vertex_column<double>(g);
+  ///
+  /// // element for a vertex (on the vertex's core)
+  /// forall(g, [=](G::Vertex& v){ rank->at(g, v) = 1.0 / g->nv; });
+  ///
+  /// // contiguous spans of local elements, suitable for vectorized loops
+  /// forall(rank, next, [](int64_t start, int64_t n, double* r, double* x){
+  ///   for (int64_t i = 0; i < n; i++) r[i] = 0.15 + 0.85 * x[i];
+  /// });
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  ///
+  /// Columns cover every vertex, including ones marked invalid (which
+  /// `forall(g,...)` skips).
+  template< typename T >
+  struct VertexColumn {
+    T * data;   ///< Local elements
+    int64_t n;  ///< Number of local vertices
+    
+    GlobalAddress<VertexColumn> self;
+    
+    VertexColumn(GlobalAddress<VertexColumn> self, int64_t n)
+      : data(n > 0 ? locale_alloc_aligned<T>(BLOCK_SIZE, n) : nullptr), n(n), self(self)
+    {
+      for (int64_t i = 0; i < n; i++) new (data+i) T();
+    }
+    
+    ~VertexColumn() {
+      for (int64_t i = 0; i < n; i++) data[i].~T();
+      if (data) locale_free(data);
+    }
+    
+    void destroy() {
+      auto self = this->self;
+      call_on_all_cores([self]{ self->~VertexColumn(); });
+      global_free(self);
+    }
+    
+    T& operator[](int64_t i) { return data[i]; }
+    T* begin() { return data; }
+    T* end() { return data + n; }
+    
+    /// Element for vertex `v`, which must be local.
+    template< typename G >
+    T& at(GlobalAddress<G> g, typename G::Vertex& v) { return data[g->local_index(v)]; }
+    
+  } GRAPPA_BLOCK_ALIGNED;
+  
+  /// Allocate a column with one (value-initialized) element per vertex of `g`.
+  template< typename T, typename G >
+  GlobalAddress<VertexColumn<T>> vertex_column(GlobalAddress<G> g) {
+    auto c = symmetric_global_alloc<VertexColumn<T>>();
+    call_on_all_cores([g,c]{
+      new (c.localize()) VertexColumn<T>(c, iterate_local(g->vs, g->nv).size());
+    });
+    return c;
+  }
+  
+  /// Allocate a column initialized from each vertex: `T f(G::Vertex& v)`.
+  template< typename T, typename G, typename F >
+  GlobalAddress<VertexColumn<T>> vertex_column(GlobalAddress<G> g, F f) {
+    auto c = vertex_column<T>(g);
+    forall(g->vs, g->nv, [g,c,f](typename G::Vertex& v){
+      c->at(g, v) = f(v);
+    });
+    return c;
+  }
+  
+  namespace impl {
+    
+    /// Parallel iteration over local elements with their local index.
+    template< GlobalCompletionEvent * C, int64_t Threshold, typename T, typename F >
+    void forall(GlobalAddress<VertexColumn<T>> c, F body,
+                void (F::*mf)(int64_t,T&) const) {
+      finish<C>([c,body]{
+        on_all_cores([c,body]{
+          forall_here<TaskMode::Bound,SyncMode::Async,C,Threshold>(0, c->n, [c,body](int64_t i){
+            body(i, c->data[i]);
+          });
+        });
+      });
+    }
+    
+    /// Parallel iteration over local elements.
+    template< GlobalCompletionEvent * C, int64_t Threshold, typename T, typename F >
+    void forall(GlobalAddress<VertexColumn<T>> c, F body, void (F::*mf)(T&) const) {
+      auto f = [body](int64_t i, T& x){ body(x); };
+      impl::forall<C,Threshold>(c, f, &decltype(f)::operator());
+    }
+    
+    /// Hand out spans of local elements of one or more columns of the same
+    /// graph: `body(start, n, a+start, b+start, ...)`.
+    template< GlobalCompletionEvent * C, int64_t Threshold, typename F, typename T, typename... Ts >
+    void forall_column_spans(F body, GlobalAddress<VertexColumn<T>> c,
+                             GlobalAddress<VertexColumn<Ts>>... cs) {
+      finish<C>([=]{
+        on_all_cores([=]{
+          forall_here<TaskMode::Bound,SyncMode::Async,C,Threshold>(0, c->n,
+              [=](int64_t start, int64_t n){
+            body(start, n, c->data+start, (cs->data+start)...);
+          });
+        });
+      });
+    }
+    
+    template< GlobalCompletionEvent * C, int64_t Threshold, typename T, typename F >
+    void forall(GlobalAddress<VertexColumn<T>> c, F body,
+                void (F::*mf)(int64_t,int64_t,T*) const) {
+      forall_column_spans<C,Threshold>(body, c);
+    }
+    
+  }
+  
+  /// Parallel iterator over a VertexColumn. The body may take:
+  /// - `(T& x)` or `(int64_t i, T& x)` for each element (`i` is the local index)
+  /// - `(int64_t start, int64_t n, T* span)` for contiguous runs of local elements
+  template< GlobalCompletionEvent * C = &impl::local_gce,
+            int64_t Threshold = impl::USE_LOOP_THRESHOLD_FLAG,
+            typename T = nullptr_t, typename F = nullptr_t >
+  void forall(GlobalAddress<VertexColumn<T>> c, F body) {
+    impl::forall<C,Threshold>(c, body, &F::operator());
+  }
+  
+  /// Iterate over matching spans of two columns of the same graph:
+  /// `body(int64_t start, int64_t n, A* a, B* b)`.
+  template< GlobalCompletionEvent * C = &impl::local_gce,
+            int64_t Threshold = impl::USE_LOOP_THRESHOLD_FLAG,
+            typename A = nullptr_t, typename B = nullptr_t, typename F = nullptr_t >
+  void forall(GlobalAddress<VertexColumn<A>> a, GlobalAddress<VertexColumn<B>> b, F body) {
+    impl::forall_column_spans<C,Threshold>(body, a, b);
+  }
+  
+  /// Iterate over matching spans of three columns of the same graph:
+  /// `body(int64_t start, int64_t n, A* a, B* b, D* d)`.
+  template< GlobalCompletionEvent * C = &impl::local_gce,
+            int64_t Threshold = impl::USE_LOOP_THRESHOLD_FLAG,
+            typename A = nullptr_t, typename B = nullptr_t, typename D = nullptr_t,
+            typename F = nullptr_t >
+  void forall(GlobalAddress<VertexColumn<A>> a, GlobalAddress<VertexColumn<B>> b,
+              GlobalAddress<VertexColumn<D>> d, F body) {
+    impl::forall_column_spans<C,Threshold>(body, a, b, d);
+  }
+  
+  /// @}
+  
+} // namespace Grappa
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <graph/VertexColumn.hpp>
+#include <Reducer.hpp>
+
+BOOST_AUTO_TEST_SUITE( VertexColumn_tests );
+
+using namespace Grappa;
+
+DEFINE_int64(scale, 10, "Log2 number of vertices.");
+DEFINE_int64(edgefactor, 16, "Average number of edges per vertex.");
+
+struct VData { double value; };
+
+using G = Graph<VData,Empty>;
+
+Reducer<int64_t,ReducerType::Add> total;
+Reducer<double,ReducerType::Add> total_d;
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t NE = (1L << FLAGS_scale) * FLAGS_edgefactor;
+    auto tg = TupleGraph::Kronecker(FLAGS_scale, NE, 111, 222);
+    auto g = G::create(tg);
+    
+    // one element per vertex, in local vertex order
+    auto degree = vertex_column<int64_t>(g, [](G::Vertex& v){ return v.nadj; });
+    total = 0;
+    on_all_cores([g,degree]{
+      CHECK_EQ(degree->n, iterate_local(g->vs, g->nv).size());
+    });
+    forall(degree, [](int64_t& d){ total += d; });
+    CHECK_EQ(total, g->nadj);
+    
+    forall(g->vs, g->nv, [g,degree](G::Vertex& v){
+      CHECK_EQ(degree->at(g, v), v.nadj);
+      CHECK_EQ(&degree->at(g, v), degree->data + g->local_index(v));
+    });
+    
+    // spans over two columns, checked against the row-wise layout
+    auto x = vertex_column<double>(g);
+    forall(x, [](int64_t i, double& e){ e = 1.0; });
+    forall(g->vs, g->nv, [](G::Vertex& v){ v->value = 1.0 + 0.5 * v.nadj; });
+    
+    forall(x, degree, [](int64_t start, int64_t n, double* x, int64_t* d){
+      for (int64_t i = 0; i < n; i++) x[i] += 0.5 * d[i];
+    });
+    forall(g->vs, g->nv, [g,x](G::Vertex& v){
+      CHECK_EQ(x->at(g, v), v->value);
+    });
+    
+    total = 0;
+    total_d = 0;
+    forall(x, [](int64_t start, int64_t n, double* s){
+      total += n;
+      for (int64_t i = 0; i < n; i++) total_d += s[i];
+    });
+    CHECK_EQ(total, g->nv);
+    CHECK_LE(std::fabs(total_d - (g->nv + 0.5 * g->nadj)), 1e-6 * total_d);
+    
+    x->destroy();
+    degree->destroy();
+    g->destroy();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
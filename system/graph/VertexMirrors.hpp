@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Graph.hpp"
+#include "VertexColumn.hpp"
+#include "Delegate.hpp"
+#include "ParallelLoop.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, mirror_posts_combined);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, mirror_posts_sent);
+GRAPPA_DECLARE_METRIC(SimpleMetric<int64_t>, mirror_reduce_messages);
+
+namespace Grappa {
+  
+  /// @addtogroup Graph
+  /// @{
+  
+  /// Mirrors of a Graph's high in-degree vertices ("hubs") on every core,
+  /// for push-style kernels that would otherwise send one message per edge
+  /// to each hub's owner.
+  ///
+  /// Values posted to a hub are combined (with `Op`) into the local mirror
+  /// and only reach the master at the next reduce(), one message per core
+  /// per touched hub. Posts to other vertices are applied at their owner
+  /// right away with an async delegate. broadcast() copies a value from
+  /// each master back to its mirrors, to be read locally with value_of().
+  ///
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// auto m = VertexMirrors<G,double>::create(g, 1024);
+  /// auto add = [](G::Vertex& v, const double& x){ v->next += x; };
+  /// forall(g, [=](G::Vertex& v, G::Edge& e){
+  ///   m->post(e.id, v->rank / v.nadj, add);
+  /// });
+  /// m->reduce(add);
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  ///
+  /// The apply function given to post() and reduce() must be the same,
+  /// and applying two values must be equivalent to applying their `Op`.
+  template< typename G, typename T, T (*Op)(const T&, const T&) = collective_add<T> >
+  struct VertexMirrors {
+    using Vertex = typename G::Vertex;
+    
+    GlobalAddress<G> g;
+    GlobalAddress<VertexMirrors> self;
+    
+    std::vector<VertexID> hubs;                  ///< Mirrored vertices (same order on all cores)
+    std::unordered_map<VertexID,int64_t> index;  ///< Position of each hub in `hubs`
+    std::vector<T> acc;                          ///< Combined posts not yet reduced
+    std::vector<char> pending;                   ///< Whether `acc[k]` holds any posts
+    std::vector<T> value;                        ///< Values from the last broadcast()
+    
+    VertexMirrors(GlobalAddress<VertexMirrors> self, GlobalAddress<G> g): g(g), self(self) {}
+    
+    /// Mirror every vertex of `g` with at least `min_in_degree` in-edges.
+    static GlobalAddress<VertexMirrors> create(GlobalAddress<G> g, int64_t min_in_degree) {
+      auto m = symmetric_global_alloc<VertexMirrors>();
+      call_on_all_cores([m,g]{ new (m.localize()) VertexMirrors(m, g); });
+      
+      auto in_degree = vertex_column<int64_t>(g);
+      forall(g, [g,in_degree](Vertex& v, typename G::Edge& e){
+        delegate::call<SyncMode::Async>(e.ga, [g,in_degree](Vertex& w){
+          in_degree->at(g, w)++;
+        });
+      });
+      
+      // tell every core about each hub
+      forall(g->vs, g->nv, [g,m,in_degree,min_in_degree](Vertex& v){
+        if (in_degree->at(g, v) < min_in_degree) return;
+        auto i = g->id(v);
+        for (Core c = 0; c < cores(); c++) {
+          delegate::call<SyncMode::Async>(c, [m,i]{ m->hubs.push_back(i); });
+        }
+      });
+      in_degree->destroy();
+      
+      call_on_all_cores([m]{
+        std::sort(m->hubs.begin(), m->hubs.end());
+        for (int64_t k = 0; k < m->hubs.size(); k++) m->index[m->hubs[k]] = k;
+        m->acc.resize(m->hubs.size());
+        m->pending.assign(m->hubs.size(), 0);
+        m->value.resize(m->hubs.size());
+      });
+      VLOG(1) << "mirrored vertices: " << m->hubs.size();
+      return m;
+    }
+    
+    void destroy() {
+      auto self = this->self;
+      call_on_all_cores([self]{ self->~VertexMirrors(); });
+      global_free(self);
+    }
+    
+    bool mirrored(VertexID j) const { return index.count(j) > 0; }
+    
+    /// Value of mirrored vertex `j` as of the last broadcast().
+    const T& value_of(VertexID j) const { return value[index.at(j)]; }
+    
+    /// Post `x` to vertex `j`: `apply(Vertex& v, const T& x)` runs at the
+    /// owner, now (async) for ordinary vertices, or at the next reduce()
+    /// with the combination of all posts from this core for hubs.
+    /// Must be called on the local proxy (`m->post(...)`).
+    template< GlobalCompletionEvent * C = &impl::local_gce, typename F = nullptr_t >
+    void post(VertexID j, const T& x, F apply) {
+      auto it = index.find(j);
+      if (it != index.end()) {
+        auto k = it->second;
+        if (pending[k]) {
+          acc[k] = Op(acc[k], x);
+        } else {
+          acc[k] = x;
+          pending[k] = 1;
+        }
+        mirror_posts_combined++;
+      } else {
+        mirror_posts_sent++;
+        delegate::call<SyncMode::Async,C>(g->vs+j, [x,apply](Vertex& v){ apply(v, x); });
+      }
+    }
+    
+    /// Apply each core's combined posts to the masters, with the same
+    /// `apply` as given to post().
+    template< typename F >
+    void reduce(F apply) {
+      auto self = this->self;
+      finish([self,apply]{
+        on_all_cores([self,apply]{
+          auto& m = *self.localize();
+          for (int64_t k = 0; k < m.hubs.size(); k++) {
+            if (!m.pending[k]) continue;
+            m.pending[k] = 0;
+            auto x = m.acc[k];
+            mirror_reduce_messages++;
+            delegate::call<SyncMode::Async>(m.g->vs+m.hubs[k], [x,apply](Vertex& v){
+              apply(v, x);
+            });
+          }
+        });
+      });
+    }
+    
+    /// Copy `get(Vertex& master)` from every hub to all of its mirrors.
+    template< typename F >
+    void broadcast(F get) {
+      auto self = this->self;
+      finish([self,get]{
+        on_all_cores([self,get]{
+          auto& m = *self.localize();
+          for (int64_t k = 0; k < m.hubs.size(); k++) {
+            auto a = m.g->vs+m.hubs[k];
+            if (a.core() != mycore()) continue;
+            T x = get(*a.pointer());
+            for (Core c = 0; c < cores(); c++) {
+              delegate::call<SyncMode::Async>(c, [self,k,x]{ self->value[k] = x; });
+            }
+          }
+        });
+      });
+    }
+    
+    /// reduce() followed by broadcast().
+    template< typename F, typename FG >
+    void sync(F apply, FG get) {
+      reduce(apply);
+      broadcast(get);
+    }
+    
+  } GRAPPA_BLOCK_ALIGNED;
+  
+  /// @}
+  
+} // namespace Grappa
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2015, University of Washington and Battelle
+// Memorial Institute.  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//     * Redistributions of source code must retain the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials
+//       provided with the distribution.
+//     * Neither the name of the University of Washington, Battelle
+//       Memorial Institute, or the names of their contributors may be
+//       used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// UNIVERSITY OF WASHINGTON OR BATTELLE MEMORIAL INSTITUTE BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+// USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <Grappa.hpp>
+#include <graph/VertexMirrors.hpp>
+
+BOOST_AUTO_TEST_SUITE( VertexMirrors_tests );
+
+using namespace Grappa;
+
+DEFINE_int64(scale, 10, "Log2 number of vertices.");
+DEFINE_int64(edgefactor, 16, "Average number of edges per vertex.");
+
+struct VData {
+  int64_t count;
+  double rank, next, expected;
+};
+
+using G = Graph<VData,Empty>;
+
+BOOST_AUTO_TEST_CASE( test1 ) {
+  init( GRAPPA_TEST_ARGS );
+  run([]{
+    int64_t NE = (1L << FLAGS_scale) * FLAGS_edgefactor;
+    auto tg = TupleGraph::Kronecker(FLAGS_scale, NE, 111, 222);
+    auto g = G::create(tg);
+    
+    auto m = VertexMirrors<G,int64_t>::create(g, 2*FLAGS_edgefactor);
+    CHECK_GT(m->hubs.size(), 0);
+    
+    // counting in-edges through the mirrors gives the degree (undirected)
+    forall(g->vs, g->nv, [](G::Vertex& v){ v->count = 0; });
+    auto inc = [](G::Vertex& v, const int64_t& x){ v->count += x; };
+    forall(g, [m,inc](G::Vertex& v, G::Edge& e){ m->post(e.id, 1, inc); });
+    m->reduce(inc);
+    forall(g, [](G::Vertex& v){ CHECK_EQ(v->count, v.nadj); });
+    
+    m->broadcast([](G::Vertex& v){ return v->count; });
+    on_all_cores([g,m]{
+      for (auto j : m->hubs) {
+        CHECK(m->mirrored(j));
+        CHECK_EQ(m->value_of(j), delegate::call(g->vs+j, [](G::Vertex& v){ return v.nadj; }));
+      }
+    });
+    
+    // one PageRank-style push, against plain delegates
+    forall(g, [](G::Vertex& v){ v->rank = 1.0; v->next = v->expected = 0.0; });
+    forall(g, [g](G::Vertex& v, G::Edge& e){
+      auto x = v->rank / v.nadj;
+      delegate::call<async>(e.ga, [x](G::Vertex& w){ w->expected += x; });
+    });
+    
+    auto r = VertexMirrors<G,double>::create(g, 2*FLAGS_edgefactor);
+    auto add = [](G::Vertex& v, const double& x){ v->next += x; };
+    forall(g, [r,add](G::Vertex& v, G::Edge& e){ r->post(e.id, v->rank / v.nadj, add); });
+    r->reduce(add);
+    forall(g, [](G::Vertex& v){
+      CHECK_LE(std::fabs(v->next - v->expected), 1e-9 * v->expected);
+    });
+    
+    r->destroy();
+    m->destroy();
+    g->destroy();
+  });
+  finalize();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -90,14 +90,35 @@ GRAPPA_DEFINE_METRIC(CallbackMetric<uint64_t>, private_queue_size, []() {
     });
 
 
-GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, tasks_heap_allocated, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, tasks_slab_allocated, 0);
 GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, tasks_created, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, task_slab_refills, 0);
+GRAPPA_DEFINE_METRIC(SimpleMetric<uint64_t>, task_closures_fetched, 0);
 
 namespace Grappa {
   namespace impl {
 
 TaskManager global_task_manager;
 
+void fetch_task_closure( Core origin, void * remote, void * local, size_t bytes,
+                         void (*release)(void*) ) {
+  task_closures_fetched++;
+  struct Piece { char data[256]; };
+  char * src = static_cast<char*>( remote );
+  char * dst = static_cast<char*>( local );
+  for( size_t offset = 0; offset < bytes; offset += sizeof(Piece) ) {
+    size_t n = std::min( sizeof(Piece), bytes - offset );
+    bool last = offset + n == bytes;
+    auto piece = delegate::call( origin, [src,offset,n,last,release]{
+      Piece p;
+      std::memcpy( p.data, src + offset, n );
+      if( last ) release( src );
+      return p;
+    });
+    std::memcpy( dst + offset, piece.data, n );
+  }
+}
+
 //DEFINE_bool(TaskManager_events, true, "Enable tracing of events in TaskManager.");
 
 /// Create an uninitialized TaskManager
@@ -88,6 +88,7 @@ TaskingScheduler global_scheduler;
   , in_no_switch_region_( false )
   , prev_ts( 0 )
   , prev_stats_blob_ts( 0 )
+  , prev_metrics_ring_ts( 0 )
     , stats( this )
 { 
   Grappa::tick();
@@ -154,6 +154,7 @@ class TaskingScheduler : public Scheduler {
 
     Grappa::Timestamp prev_ts;
     Grappa::Timestamp prev_stats_blob_ts;
+    Grappa::Timestamp prev_metrics_ring_ts;
     static const int64_t tick_scale = 1L; //(1L << 30);
 
     Worker * nextCoroutine ( bool isBlocking=true ) {
@@ -184,6 +185,13 @@ class TaskingScheduler : public Scheduler {
 #endif
         }
 
+        // maybe take a local sample into the metrics ring buffer (no communication)
+        if( Grappa::impl::metrics_ring_sample_ticks() > 0 &&
+            current_ts - prev_metrics_ring_ts > Grappa::impl::metrics_ring_sample_ticks() ) {
+          prev_metrics_ring_ts = current_ts;
+          Grappa::Metrics::ring_sample( current_ts );
+        }
+
         // if( ( global_communicator.mycore == 0 ) &&
         //     ( current_ts - prev_stats_blob_ts > FLAGS_stats_blob_ticks ) &&
         //     FLAGS_stats_blob_enable &&